@@ -0,0 +1,457 @@
+#ifndef ABSTRACT_WIFI_PHY_H
+#define ABSTRACT_WIFI_PHY_H
+
+#include "ns3/double.h"
+#include "ns3/event-id.h"
+#include "ns3/mobility-model.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/pointer.h"
+#include "ns3/preamble-detection-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/table-based-error-rate-model.h"
+#include "ns3/threshold-preamble-detection-model.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-phy-state-helper.h"
+#include "ns3/wifi-ppdu.h"
+#include "ns3/wifi-psdu.h"
+#include "ns3/wifi-utils.h"
+#include "ns3/yans-wifi-channel.h"
+#include "ns3/yans-wifi-helper.h"
+#include "ns3/yans-wifi-phy.h"
+
+#include <cmath>
+#include <map>
+#include <vector>
+
+// No log component of its own, as that would clash with the one of the including program
+
+namespace ns3
+{
+
+/**
+ * A Wi-Fi PHY that abstracts frame reception into a single link-to-system mapping step.
+ *
+ * Instead of the PHY header and payload chunk processing of the full PHY, a frame is
+ * received with one event at its start and one at its end. The PHY locks on a frame if
+ * it is idle and the preamble detection model detects the preamble, at the SINR of the
+ * start of the frame. Interference is tracked as the energy of all overlapping signals,
+ * giving one effective SINR per frame, which is mapped to a frame error probability
+ * through per-MCS lookup tables. The tables are sampled once from a
+ * TableBasedErrorRateModel at a reference frame size.
+ *
+ * The PHY sits on a regular YansWifiChannel and uses the loss and delay models of that
+ * channel, so it can be installed through AbstractWifiPhyHelper with the unmodified
+ * WifiHelper and MAC stack. All PHYs on the channel must be abstract.
+ *
+ * WifiPhy keeps the preamble detection model set through the helper to itself, so this
+ * PHY has its own PreambleDetectionModel attribute, a ThresholdPreambleDetectionModel
+ * like the one the helpers install by default.
+ */
+class AbstractWifiPhy : public YansWifiPhy
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    AbstractWifiPhy();
+
+    void StartTx(Ptr<const WifiPpdu> ppdu) override;
+    int64_t AssignStreams(int64_t stream) override;
+
+    /**
+     * Add a signal that only interferes with receptions at this PHY, e.g. from a
+     * non-Wi-Fi source. Like any energy on air, it makes an idle PHY CCA busy while the
+     * total power is above the CCA-ED threshold.
+     *
+     * \param duration how long the signal lasts
+     * \param powerW the received power of the signal in Watts
+     */
+    void AddInterference(Time duration, double powerW);
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * Called when the first bit of a PPDU arrives at this PHY.
+     *
+     * \param ppdu the arriving PPDU
+     * \param rxPowerDbm its received power including the RX gain
+     */
+    void StartReceive(Ptr<WifiPpdu> ppdu, double rxPowerDbm);
+
+    /**
+     * Called when the last bit of the PPDU being received has arrived.
+     */
+    void EndReceive();
+
+    /**
+     * Retire the signals that ended and integrate the interference energy up to now.
+     */
+    void UpdateInterference();
+
+    /**
+     * Integrate the interference energy seen by the current reception up to a given time.
+     *
+     * \param time the time up to which to integrate
+     */
+    void AccumulateInterference(Time time);
+
+    /**
+     * Switch an idle or CCA busy PHY to CCA busy until the power on air falls below the
+     * CCA-ED threshold, if it is above it now.
+     */
+    void MaybeSwitchToCcaBusy();
+
+    /**
+     * \return the thermal noise power over the channel width in Watts
+     */
+    double GetNoisePowerW();
+
+    /**
+     * \param mode the mode of the frame
+     * \param txVector the TXVECTOR of the frame
+     * \param snr the effective SINR (linear)
+     * \param size the size of the frame in bytes
+     * \return the frame error probability
+     */
+    double GetPer(WifiMode mode, const WifiTxVector& txVector, double snr, uint32_t size);
+
+    static constexpr double BOLTZMANN_CONSTANT = 1.3803e-23; //!< Same as InterferenceHelper
+    static constexpr double LUT_MIN_SNR_DB = -5;             //!< Lowest SNR of the tables
+    static constexpr double LUT_MAX_SNR_DB = 45;             //!< Highest SNR of the tables
+    static constexpr double LUT_STEP_DB = 0.25;              //!< SNR resolution of the tables
+    static constexpr uint32_t LUT_FRAME_SIZE = 1500;         //!< Frame size of the tables
+
+    Ptr<PropagationLossModel> m_loss;   //!< Loss model of the channel
+    Ptr<PropagationDelayModel> m_delay; //!< Delay model of the channel
+
+    std::multimap<Time, double> m_signals; //!< Power of the signals on air, by end time
+    double m_totalPowerW{0};               //!< Sum of the power of the signals on air
+    Time m_lastUpdate;                     //!< Time the interference was integrated up to
+
+    Ptr<WifiPpdu> m_rxPpdu;    //!< PPDU being received, if any
+    double m_rxPowerW{0};      //!< Received power of that PPDU
+    Time m_rxStart;            //!< Start of the reception
+    double m_interferenceJ{0}; //!< Interference energy seen by the reception
+    EventId m_endRxEvent;      //!< End of the reception
+
+    Ptr<TableBasedErrorRateModel> m_errorModel;          //!< Source of the lookup tables
+    std::map<uint32_t, std::vector<double>> m_perTables; //!< PER by SNR, per mode UID
+    Ptr<UniformRandomVariable> m_random;                 //!< Frame error decisions
+    Ptr<PreambleDetectionModel> m_preambleDetection;     //!< Null to lock on every frame
+};
+
+/**
+ * Installs AbstractWifiPhy instances on a YansWifiChannel. Everything else, including
+ * the attributes, behaves like YansWifiPhyHelper.
+ */
+class AbstractWifiPhyHelper : public YansWifiPhyHelper
+{
+  public:
+    AbstractWifiPhyHelper()
+    {
+        m_phy.at(0).SetTypeId("ns3::AbstractWifiPhy");
+    }
+};
+
+// Every including translation unit registers the type, through the one inline GetTypeId
+NS_OBJECT_ENSURE_REGISTERED(AbstractWifiPhy);
+
+inline TypeId
+AbstractWifiPhy::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::AbstractWifiPhy")
+            .SetParent<YansWifiPhy>()
+            .SetGroupName("Wifi")
+            .AddConstructor<AbstractWifiPhy>()
+            .AddAttribute("PreambleDetectionModel",
+                          "Decides whether the PHY locks on an arriving frame, null to lock on "
+                          "every frame",
+                          StringValue("ns3::ThresholdPreambleDetectionModel"),
+                          MakePointerAccessor(&AbstractWifiPhy::m_preambleDetection),
+                          MakePointerChecker<PreambleDetectionModel>());
+    return tid;
+}
+
+inline AbstractWifiPhy::AbstractWifiPhy()
+    : m_errorModel(CreateObject<TableBasedErrorRateModel>()),
+      m_random(CreateObject<UniformRandomVariable>())
+{
+}
+
+inline void
+AbstractWifiPhy::DoDispose()
+{
+    m_endRxEvent.Cancel();
+    m_rxPpdu = nullptr;
+    m_loss = nullptr;
+    m_delay = nullptr;
+    m_errorModel = nullptr;
+    m_random = nullptr;
+    m_preambleDetection = nullptr;
+    m_signals.clear();
+    YansWifiPhy::DoDispose();
+}
+
+inline void
+AbstractWifiPhy::StartTx(Ptr<const WifiPpdu> ppdu)
+{
+    Ptr<YansWifiChannel> channel = DynamicCast<YansWifiChannel>(GetChannel());
+    NS_ASSERT_MSG(channel, "AbstractWifiPhy needs a YansWifiChannel");
+
+    // The state already switched to TX, which aborts the reception in progress
+    if (m_endRxEvent.IsRunning())
+    {
+        m_endRxEvent.Cancel();
+        UpdateInterference();
+        NotifyRxDrop(m_rxPpdu->GetPsdu(), RECEPTION_ABORTED_BY_TX);
+        m_rxPpdu = nullptr;
+    }
+
+    if (!m_loss)
+    {
+        PointerValue loss;
+        channel->GetAttribute("PropagationLossModel", loss);
+        m_loss = loss.Get<PropagationLossModel>();
+        PointerValue delay;
+        channel->GetAttribute("PropagationDelayModel", delay);
+        m_delay = delay.Get<PropagationDelayModel>();
+    }
+
+    Ptr<MobilityModel> senderMobility = GetMobility();
+    double txPowerDbm = GetTxPowerForTransmission(ppdu) + GetTxGain();
+
+    for (std::size_t i = 0; i < channel->GetNDevices(); i++)
+    {
+        Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice>(channel->GetDevice(i));
+        Ptr<AbstractWifiPhy> receiver = DynamicCast<AbstractWifiPhy>(device->GetPhy());
+        if (!receiver || receiver == this)
+        {
+            continue;
+        }
+
+        Ptr<MobilityModel> receiverMobility = receiver->GetMobility();
+        double rxPowerDbm = m_loss->CalcRxPower(txPowerDbm, senderMobility, receiverMobility) +
+                            receiver->GetRxGain();
+        // Like the Yans channel, signals below the sensitivity are not delivered at all
+        if (rxPowerDbm < receiver->GetRxSensitivity())
+        {
+            continue;
+        }
+
+        Time delay = m_delay->GetDelay(senderMobility, receiverMobility);
+        Simulator::ScheduleWithContext(device->GetNode()->GetId(),
+                                       delay,
+                                       &AbstractWifiPhy::StartReceive,
+                                       receiver,
+                                       ppdu->Copy(),
+                                       rxPowerDbm);
+    }
+}
+
+inline int64_t
+AbstractWifiPhy::AssignStreams(int64_t stream)
+{
+    int64_t streams = YansWifiPhy::AssignStreams(stream);
+    m_random->SetStream(stream + streams);
+    return streams + 1;
+}
+
+inline void
+AbstractWifiPhy::AddInterference(Time duration, double powerW)
+{
+    UpdateInterference();
+    m_signals.emplace(Simulator::Now() + duration, powerW);
+    m_totalPowerW += powerW;
+    MaybeSwitchToCcaBusy();
+}
+
+inline void
+AbstractWifiPhy::StartReceive(Ptr<WifiPpdu> ppdu, double rxPowerDbm)
+{
+    Time duration = ppdu->GetTxDuration();
+    double rxPowerW = DbmToW(rxPowerDbm);
+    AddInterference(duration, rxPowerW);
+
+    // A frame arriving while busy only adds to the interference of the ongoing activity
+    if (!IsStateIdle() && !IsStateCcaBusy())
+    {
+        return;
+    }
+    // Neither does a frame whose preamble is not detected
+    double snr = rxPowerW / (GetNoisePowerW() + std::max(m_totalPowerW - rxPowerW, 0.0));
+    if (m_preambleDetection &&
+        !m_preambleDetection->IsPreambleDetected(rxPowerW, snr, GetChannelWidth()))
+    {
+        NotifyRxDrop(ppdu->GetPsdu(), PREAMBLE_DETECT_FAILURE);
+        return;
+    }
+
+    m_rxPpdu = ppdu;
+    m_rxPowerW = rxPowerW;
+    m_rxStart = Simulator::Now();
+    m_interferenceJ = 0;
+    GetState()->SwitchToRx(duration);
+    m_endRxEvent = Simulator::Schedule(duration, &AbstractWifiPhy::EndReceive, this);
+}
+
+inline void
+AbstractWifiPhy::EndReceive()
+{
+    UpdateInterference();
+
+    Ptr<WifiPpdu> ppdu = m_rxPpdu;
+    m_rxPpdu = nullptr;
+
+    const WifiTxVector& txVector = ppdu->GetTxVector();
+    Ptr<const WifiPsdu> psdu = ppdu->GetPsdu();
+
+    double noiseW = GetNoisePowerW();
+    double interferenceW = m_interferenceJ / (Simulator::Now() - m_rxStart).GetSeconds();
+    double snr = m_rxPowerW / (noiseW + interferenceW);
+
+    // One decision per MPDU so that A-MPDUs are partially received like with the full PHY
+    std::vector<bool> statusPerMpdu;
+    bool anyReceived = false;
+    for (std::size_t i = 0; i < psdu->GetNMpdus(); i++)
+    {
+        uint32_t size = psdu->IsAggregate() ? psdu->GetAmpduSubframeSize(i) : psdu->GetSize();
+        bool received = m_random->GetValue() >= GetPer(txVector.GetMode(), txVector, snr, size);
+        statusPerMpdu.push_back(received);
+        anyReceived |= received;
+    }
+
+    SignalNoiseDbm signalNoise;
+    signalNoise.signal = WToDbm(m_rxPowerW);
+    signalNoise.noise = WToDbm(noiseW + interferenceW);
+    NotifyMonitorSnifferRx(psdu, GetFrequency(), txVector, signalNoise, statusPerMpdu, SU_STA_ID);
+
+    if (anyReceived)
+    {
+        RxSignalInfo rxSignalInfo{snr, WToDbm(m_rxPowerW)};
+        GetState()->NotifyRxPsduSucceeded(psdu, rxSignalInfo, txVector, SU_STA_ID, statusPerMpdu);
+        GetState()->SwitchFromRxEndOk();
+    }
+    else
+    {
+        GetState()->NotifyRxPsduFailed(psdu, snr);
+        GetState()->SwitchFromRxEndError();
+    }
+    MaybeSwitchToCcaBusy();
+}
+
+inline void
+AbstractWifiPhy::UpdateInterference()
+{
+    Time now = Simulator::Now();
+    while (!m_signals.empty() && m_signals.begin()->first <= now)
+    {
+        AccumulateInterference(m_signals.begin()->first);
+        m_totalPowerW -= m_signals.begin()->second;
+        m_signals.erase(m_signals.begin());
+    }
+    if (m_signals.empty())
+    {
+        // Do not let rounding errors of the running sum accumulate
+        m_totalPowerW = 0;
+    }
+    AccumulateInterference(now);
+}
+
+inline void
+AbstractWifiPhy::AccumulateInterference(Time time)
+{
+    if (m_rxPpdu && time > m_lastUpdate)
+    {
+        double interferenceW = std::max(m_totalPowerW - m_rxPowerW, 0.0);
+        m_interferenceJ += interferenceW * (time - m_lastUpdate).GetSeconds();
+    }
+    m_lastUpdate = std::max(m_lastUpdate, time);
+}
+
+inline void
+AbstractWifiPhy::MaybeSwitchToCcaBusy()
+{
+    if (!IsStateIdle() && !IsStateCcaBusy())
+    {
+        return;
+    }
+
+    // The signals end in order, so the power falls below the threshold at the end of the
+    // first one that takes it there
+    Time now = Simulator::Now();
+    Time end = now;
+    double thresholdW = DbmToW(GetCcaEdThreshold());
+    double powerW = m_totalPowerW;
+    for (auto signal = m_signals.begin(); signal != m_signals.end() && powerW >= thresholdW;
+         signal++)
+    {
+        powerW -= signal->second;
+        end = signal->first;
+    }
+    if (end > now)
+    {
+        GetState()->SwitchMaybeToCcaBusy(end - now, WIFI_CHANLIST_PRIMARY, {});
+    }
+}
+
+inline double
+AbstractWifiPhy::GetNoisePowerW()
+{
+    DoubleValue noiseFigureDb;
+    GetAttribute("RxNoiseFigure", noiseFigureDb);
+    return BOLTZMANN_CONSTANT * 290 * GetChannelWidth() * 1e6 * DbToRatio(noiseFigureDb.Get());
+}
+
+inline double
+AbstractWifiPhy::GetPer(WifiMode mode, const WifiTxVector& txVector, double snr, uint32_t size)
+{
+    auto table = m_perTables.find(mode.GetUid());
+    if (table == m_perTables.end())
+    {
+        std::vector<double> per;
+        for (double snrDb = LUT_MIN_SNR_DB; snrDb <= LUT_MAX_SNR_DB; snrDb += LUT_STEP_DB)
+        {
+            per.push_back(1 - m_errorModel->GetChunkSuccessRate(mode,
+                                                                txVector,
+                                                                DbToRatio(snrDb),
+                                                                LUT_FRAME_SIZE * 8));
+        }
+        table = m_perTables.emplace(mode.GetUid(), per).first;
+    }
+
+    const std::vector<double>& per = table->second;
+    double position = (RatioToDb(snr) - LUT_MIN_SNR_DB) / LUT_STEP_DB;
+    double referencePer;
+    if (position <= 0)
+    {
+        referencePer = per.front();
+    }
+    else if (position >= per.size() - 1)
+    {
+        referencePer = per.back();
+    }
+    else
+    {
+        std::size_t index = position;
+        double fraction = position - index;
+        referencePer = per[index] + fraction * (per[index + 1] - per[index]);
+    }
+
+    // Scale from the reference size assuming independent bit errors
+    return 1 - std::pow(1 - referencePer, static_cast<double>(size) / LUT_FRAME_SIZE);
+}
+
+} // namespace ns3
+
+#endif /* ABSTRACT_WIFI_PHY_H */
@@ -0,0 +1,847 @@
+#include "equivalence-tests.h"
+#include "parallel-for.h"
+
+#include "ns3/command-line.h"
+#include "ns3/core-module.h"
+#include "ns3/log.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("AggregateResults");
+
+/**
+ * A result table mapped into memory: a CSV file with a header line, or a binary file.
+ *
+ * A binary table starts with the magic "RTAB", a uint32 column count and a uint64 row
+ * count, followed by every column name as a uint32 length and its characters, and the
+ * rows as native doubles. It is what --convert writes, and is read without parsing.
+ */
+struct Table
+{
+    std::string path;
+    std::string baseName;
+    const char* data = nullptr;
+    size_t size = 0;
+    std::vector<std::string> columns;
+    bool binary = false;
+    size_t bodyOffset = 0; // Start of the first row
+    uint64_t rows = 0;     // Binary tables only
+};
+
+/**
+ * What a row is grouped by: a column, bucketed if it is numeric and a width is given, or
+ * the file name or model of the table.
+ */
+struct GroupKey
+{
+    enum Kind
+    {
+        COLUMN,
+        FILE_NAME,
+        MODEL
+    };
+
+    std::string name;
+    Kind kind = COLUMN;
+    double bucket = 0; // Width of the buckets, 0 to group by the exact value
+};
+
+/**
+ * The values of the aggregated columns of one group.
+ */
+struct Group
+{
+    uint64_t rows = 0;
+    std::vector<std::vector<double>> values; // One vector per aggregated column
+};
+
+/// Groups by their key, the key parts joined by GROUP_KEY_SEPARATOR
+using GroupMap = std::unordered_map<std::string, Group>;
+
+static const char GROUP_KEY_SEPARATOR = '\x1f';
+
+/**
+ * Split a comma separated list into its items.
+ */
+static std::vector<std::string>
+SplitList(const std::string& list)
+{
+    std::vector<std::string> items;
+    std::istringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        if (!item.empty())
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+/**
+ * Map a table into memory and read its column names.
+ */
+static Table
+OpenTable(const std::string& path)
+{
+    Table table;
+    table.path = path;
+    table.baseName = path.substr(path.find_last_of('/') + 1);
+    int fd = open(path.c_str(), O_RDONLY);
+    NS_ABORT_MSG_IF(fd < 0, "Cannot open " << path);
+    struct stat status;
+    NS_ABORT_MSG_IF(fstat(fd, &status) != 0, "Cannot stat " << path);
+    table.size = status.st_size;
+    NS_ABORT_MSG_IF(table.size == 0, path << " is empty");
+    void* mapping = mmap(nullptr, table.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    NS_ABORT_MSG_IF(mapping == MAP_FAILED, "Cannot map " << path);
+    madvise(mapping, table.size, MADV_SEQUENTIAL);
+    table.data = static_cast<const char*>(mapping);
+
+    const size_t headerSize = 4 + sizeof(uint32_t) + sizeof(uint64_t);
+    if (table.size >= headerSize && std::memcmp(table.data, "RTAB", 4) == 0)
+    {
+        table.binary = true;
+        uint32_t columns;
+        std::memcpy(&columns, table.data + 4, sizeof(columns));
+        std::memcpy(&table.rows, table.data + 4 + sizeof(columns), sizeof(table.rows));
+        // Every column name takes at least its length field
+        NS_ABORT_MSG_IF(columns == 0, path << " has no columns");
+        NS_ABORT_MSG_IF(columns > (table.size - headerSize) / sizeof(uint32_t),
+                        path << " is truncated");
+        size_t offset = headerSize;
+        for (uint32_t column = 0; column < columns; column++)
+        {
+            uint32_t length = 0;
+            NS_ABORT_MSG_IF(offset + sizeof(length) > table.size, path << " is truncated");
+            std::memcpy(&length, table.data + offset, sizeof(length));
+            offset += sizeof(length);
+            NS_ABORT_MSG_IF(offset + length > table.size, path << " is truncated");
+            table.columns.emplace_back(table.data + offset, length);
+            offset += length;
+        }
+        table.bodyOffset = offset;
+        // Divided instead of multiplied, so that a crafted row count cannot overflow
+        NS_ABORT_MSG_IF(table.rows > (table.size - offset) / sizeof(double) / columns,
+                        path << " is truncated");
+    }
+    else
+    {
+        const char* end = static_cast<const char*>(std::memchr(table.data, '\n', table.size));
+        std::string header(table.data, end ? end : table.data + table.size);
+        if (!header.empty() && header.back() == '\r')
+        {
+            header.pop_back();
+        }
+        std::istringstream stream(header);
+        for (std::string column; std::getline(stream, column, ',');)
+        {
+            table.columns.push_back(column);
+        }
+        table.bodyOffset = end ? end - table.data + 1 : table.size;
+    }
+    return table;
+}
+
+/**
+ * Index of a column in a table, or -1.
+ */
+static int
+ColumnIndex(const Table& table, const std::string& name)
+{
+    auto found = std::find(table.columns.begin(), table.columns.end(), name);
+    return found == table.columns.end() ? -1 : found - table.columns.begin();
+}
+
+/**
+ * The model of a table without a model column, from its name: output_<Model>[_...].csv.
+ */
+static std::string
+ModelFromFileName(const std::string& baseName)
+{
+    if (baseName.rfind("output_", 0) != 0)
+    {
+        return baseName;
+    }
+    size_t end = baseName.find_first_of("_.", 7);
+    return baseName.substr(7, end == std::string::npos ? std::string::npos : end - 7);
+}
+
+/**
+ * Append a number to a group key in its shortest exact form.
+ */
+static void
+AppendNumber(std::string& key, double value)
+{
+    char buffer[32];
+    auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    key.append(buffer, end);
+}
+
+/**
+ * Parse a number, skipping spaces around it.
+ *
+ * \return the number, or NaN if the field is not one
+ */
+static double
+ParseNumber(std::string_view field)
+{
+    while (!field.empty() && (field.front() == ' ' || field.front() == '"'))
+    {
+        field.remove_prefix(1);
+    }
+    double value;
+    auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+    return error == std::errc() ? value : std::numeric_limits<double>::quiet_NaN();
+}
+
+/**
+ * How the columns of a table take part in the aggregation.
+ */
+struct TablePlan
+{
+    std::vector<int> keyColumns;   // Column of every key, -1 for those not from a column
+    std::vector<std::string> keyConstants; // Key parts that are the same for every row
+    std::vector<int> valueColumns; // Column of every aggregated value, -1 if missing
+    int lastColumn = -1;           // Highest column index any of them needs
+};
+
+static TablePlan
+PlanTable(const Table& table,
+          const std::vector<GroupKey>& keys,
+          const std::vector<std::string>& values)
+{
+    TablePlan plan;
+    for (const GroupKey& key : keys)
+    {
+        int column = key.kind == GroupKey::FILE_NAME ? -1 : ColumnIndex(table, key.name);
+        std::string constant;
+        if (key.kind == GroupKey::FILE_NAME)
+        {
+            constant = table.baseName;
+        }
+        else if (key.kind == GroupKey::MODEL && column < 0)
+        {
+            constant = ModelFromFileName(table.baseName);
+        }
+        else
+        {
+            NS_ABORT_MSG_IF(column < 0, table.path << " has no column " << key.name);
+        }
+        plan.keyColumns.push_back(column);
+        plan.keyConstants.push_back(constant);
+        plan.lastColumn = std::max(plan.lastColumn, column);
+    }
+    for (const std::string& value : values)
+    {
+        int column = ColumnIndex(table, value);
+        plan.valueColumns.push_back(column);
+        plan.lastColumn = std::max(plan.lastColumn, column);
+    }
+    return plan;
+}
+
+/**
+ * Add a row to the groups of a thread.
+ *
+ * \param field returns the text of a CSV column, or is unused for binary rows
+ * \param number returns the value of a column
+ */
+template <typename Field, typename Number>
+static void
+AddRow(const std::vector<GroupKey>& keys,
+       const TablePlan& plan,
+       Field field,
+       Number number,
+       std::string& key,
+       GroupMap& groups)
+{
+    key.clear();
+    for (size_t k = 0; k < keys.size(); k++)
+    {
+        if (k > 0)
+        {
+            key += GROUP_KEY_SEPARATOR;
+        }
+        int column = plan.keyColumns[k];
+        if (column < 0)
+        {
+            key += plan.keyConstants[k];
+        }
+        else if (keys[k].bucket > 0)
+        {
+            double value = number(column);
+            if (std::isnan(value))
+            {
+                return;
+            }
+            AppendNumber(key, std::floor(value / keys[k].bucket) * keys[k].bucket);
+        }
+        else
+        {
+            field(key, column);
+        }
+    }
+
+    Group& group = groups[key];
+    if (group.values.empty())
+    {
+        group.values.resize(plan.valueColumns.size());
+    }
+    group.rows++;
+    for (size_t v = 0; v < plan.valueColumns.size(); v++)
+    {
+        int column = plan.valueColumns[v];
+        double value = column < 0 ? std::numeric_limits<double>::quiet_NaN() : number(column);
+        if (!std::isnan(value))
+        {
+            group.values[v].push_back(value);
+        }
+    }
+}
+
+/**
+ * Group the rows of the lines in [begin, end) of a CSV table.
+ */
+static void
+GroupCsvRange(const char* begin,
+              const char* end,
+              const std::vector<GroupKey>& keys,
+              const TablePlan& plan,
+              GroupMap& groups)
+{
+    std::vector<std::string_view> fields(plan.lastColumn + 1);
+    std::string key;
+    const char* line = begin;
+    while (line < end)
+    {
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        lineEnd = lineEnd ? lineEnd : end;
+        const char* stop = lineEnd > line && lineEnd[-1] == '\r' ? lineEnd - 1 : lineEnd;
+
+        size_t count = 0;
+        const char* field = line;
+        while (count < fields.size())
+        {
+            const char* comma = static_cast<const char*>(std::memchr(field, ',', stop - field));
+            const char* fieldEnd = comma ? comma : stop;
+            fields[count++] = std::string_view(field, fieldEnd - field);
+            if (!comma)
+            {
+                break;
+            }
+            field = comma + 1;
+        }
+        if (line < stop && count == fields.size())
+        {
+            AddRow(
+                keys,
+                plan,
+                [&fields](std::string& key, int column) {
+                    key.append(fields[column].data(), fields[column].size());
+                },
+                [&fields](int column) { return ParseNumber(fields[column]); },
+                key,
+                groups);
+        }
+        line = lineEnd + 1;
+    }
+}
+
+/**
+ * Group the rows in [begin, end) of a binary table.
+ */
+static void
+GroupBinaryRange(const Table& table,
+                 uint64_t begin,
+                 uint64_t end,
+                 const std::vector<GroupKey>& keys,
+                 const TablePlan& plan,
+                 GroupMap& groups)
+{
+    const size_t rowSize = table.columns.size() * sizeof(double);
+    const char* body = table.data + table.bodyOffset;
+    std::string key;
+    for (uint64_t row = begin; row < end; row++)
+    {
+        const char* values = body + row * rowSize;
+        auto number = [values](int column) {
+            double value;
+            std::memcpy(&value, values + column * sizeof(double), sizeof(value));
+            return value;
+        };
+        AddRow(
+            keys,
+            plan,
+            [&number](std::string& key, int column) { AppendNumber(key, number(column)); },
+            number,
+            key,
+            groups);
+    }
+}
+
+/**
+ * Write a CSV table as a binary table next to it, with every field that is not a number
+ * as NaN, so that later aggregations map it instead of parsing it.
+ */
+static void
+ConvertTable(const Table& table, unsigned threads)
+{
+    NS_ABORT_MSG_IF(table.binary, table.path << " is already binary");
+    size_t columns = table.columns.size();
+    std::vector<size_t> bounds =
+        SplitAtLines(table.data + table.bodyOffset, table.size - table.bodyOffset, threads);
+    std::vector<std::vector<double>> parts(threads);
+    RunThreads(threads, [&](unsigned thread) {
+        const char* line = table.data + table.bodyOffset + bounds[thread];
+        const char* end = table.data + table.bodyOffset + bounds[thread + 1];
+        while (line < end)
+        {
+            const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+            lineEnd = lineEnd ? lineEnd : end;
+            if (lineEnd > line)
+            {
+                const char* field = line;
+                for (size_t column = 0; column < columns; column++)
+                {
+                    const char* comma =
+                        field ? static_cast<const char*>(std::memchr(field, ',', lineEnd - field))
+                              : nullptr;
+                    parts[thread].push_back(
+                        field ? ParseNumber(std::string_view(field, (comma ? comma : lineEnd) -
+                                                                        field))
+                              : std::numeric_limits<double>::quiet_NaN());
+                    field = comma ? comma + 1 : nullptr;
+                }
+            }
+            line = lineEnd + 1;
+        }
+    });
+
+    uint64_t rows = 0;
+    for (const std::vector<double>& part : parts)
+    {
+        rows += part.size() / columns;
+    }
+    std::string path = table.path + ".rtab";
+    std::ofstream file(path, std::ios::binary);
+    uint32_t columnCount = columns;
+    file.write("RTAB", 4);
+    file.write(reinterpret_cast<const char*>(&columnCount), sizeof(columnCount));
+    file.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+    for (const std::string& name : table.columns)
+    {
+        uint32_t length = name.size();
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(name.data(), length);
+    }
+    for (const std::vector<double>& part : parts)
+    {
+        file.write(reinterpret_cast<const char*>(part.data()), part.size() * sizeof(double));
+    }
+    NS_ABORT_MSG_IF(!file, "Cannot write " << path);
+    NS_LOG_UNCOND("Converted " << table.path << " to " << path << " with " << rows << " rows");
+}
+
+/**
+ * Quantile of the two-sided Student t distribution: the t that a statistic with the
+ * given degrees of freedom exceeds in absolute value with probability 1 - confidence,
+ * found by bisection on the incomplete beta function.
+ */
+static double
+StudentQuantile(double dof, double confidence)
+{
+    double low = 0;
+    double high = 1e4;
+    for (int i = 0; i < 100; i++)
+    {
+        double t = (low + high) / 2;
+        double pValue = RegularizedIncompleteBeta(dof / 2, 0.5, dof / (dof + t * t));
+        (pValue > 1 - confidence ? low : high) = t;
+    }
+    return (low + high) / 2;
+}
+
+/**
+ * Quantile of sorted values, interpolated linearly between the closest ranks.
+ */
+static double
+Quantile(const std::vector<double>& sorted, double q)
+{
+    double rank = q * (sorted.size() - 1);
+    size_t low = rank;
+    size_t high = std::min(low + 1, sorted.size() - 1);
+    return sorted[low] + (rank - low) * (sorted[high] - sorted[low]);
+}
+
+/**
+ * Split a group key into its parts.
+ */
+static std::vector<std::string>
+KeyParts(const std::string& key)
+{
+    std::vector<std::string> parts;
+    std::istringstream stream(key);
+    for (std::string part; std::getline(stream, part, GROUP_KEY_SEPARATOR);)
+    {
+        parts.push_back(part);
+    }
+    if (!key.empty() && key.back() == GROUP_KEY_SEPARATOR)
+    {
+        parts.emplace_back();
+    }
+    return parts;
+}
+
+/**
+ * Order key parts numerically where both are numbers, and as text otherwise.
+ */
+static bool
+KeyPartsLess(const std::vector<std::string>& a, const std::vector<std::string>& b)
+{
+    for (size_t i = 0; i < std::min(a.size(), b.size()); i++)
+    {
+        double x = ParseNumber(a[i]);
+        double y = ParseNumber(b[i]);
+        if (!std::isnan(x) && !std::isnan(y))
+        {
+            if (x != y)
+            {
+                return x < y;
+            }
+        }
+        else if (a[i] != b[i])
+        {
+            return a[i] < b[i];
+        }
+    }
+    return a.size() < b.size();
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string input;
+    std::string groupBy = "model,distanceMeters";
+    std::string valueList = "rssDBm,throughputKbps";
+    std::string quantileList = "0.1,0.5,0.9";
+    double confidence = 0.95;
+    std::string cutoff;
+    std::string cutoffKey = "distanceMeters";
+    double cutoffThreshold = 0;
+    std::string output = "output_aggregate.csv";
+    bool convert = false;
+    unsigned threads = std::max(std::thread::hardware_concurrency(), 1U);
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("input",
+                 "Comma separated result tables: CSV files with a header line, or binary RTAB "
+                 "files written by --convert",
+                 input);
+    cmd.AddValue("groupBy",
+                 "Comma separated keys: column names, <column>:<width> to group a numeric "
+                 "column into buckets of that width, file for the file name, and model for a "
+                 "model column or else the model in an output_<Model>*.csv file name",
+                 groupBy);
+    cmd.AddValue("values", "Comma separated numeric columns to aggregate", valueList);
+    cmd.AddValue("quantiles", "Comma separated quantiles of every value", quantileList);
+    cmd.AddValue("confidence", "Level of the confidence interval of the means", confidence);
+    cmd.AddValue("cutoff",
+                 "Value whose mean decides the cutoff of every group of the other keys, e.g. "
+                 "throughputKbps; writes <output>_cutoff.csv",
+                 cutoff);
+    cmd.AddValue("cutoffKey", "Numeric key the cutoff is searched along", cutoffKey);
+    cmd.AddValue("cutoffThreshold",
+                 "A group is cut off where the mean of the cutoff value is at most this",
+                 cutoffThreshold);
+    cmd.AddValue("output", "Where to write one row per group", output);
+    cmd.AddValue("convert",
+                 "Instead of aggregating, write every CSV input as a binary <input>.rtab",
+                 convert);
+    cmd.AddValue("threads", "Number of threads parsing and aggregating", threads);
+    cmd.Parse(argc, argv);
+    threads = std::max(threads, 1U);
+
+    std::vector<Table> tables;
+    for (const std::string& path : SplitList(input))
+    {
+        tables.push_back(OpenTable(path));
+    }
+    NS_ABORT_MSG_IF(tables.empty(), "--input is required");
+    if (convert)
+    {
+        for (const Table& table : tables)
+        {
+            ConvertTable(table, threads);
+        }
+        return 0;
+    }
+
+    std::vector<GroupKey> keys;
+    for (const std::string& item : SplitList(groupBy))
+    {
+        GroupKey key;
+        size_t colon = item.find(':');
+        key.name = item.substr(0, colon);
+        if (colon != std::string::npos)
+        {
+            key.bucket = std::stod(item.substr(colon + 1));
+            NS_ABORT_MSG_IF(!(key.bucket > 0), "Invalid bucket width in " << item);
+        }
+        key.kind = key.name == "file"    ? GroupKey::FILE_NAME
+                   : key.name == "model" ? GroupKey::MODEL
+                                         : GroupKey::COLUMN;
+        keys.push_back(key);
+    }
+    std::vector<std::string> values = SplitList(valueList);
+    std::vector<double> quantiles;
+    for (const std::string& quantile : SplitList(quantileList))
+    {
+        quantiles.push_back(std::stod(quantile));
+        NS_ABORT_MSG_IF(quantiles.back() < 0 || quantiles.back() > 1,
+                        "Invalid quantile " << quantile);
+    }
+    int cutoffValue = -1;
+    int cutoffKeyIndex = -1;
+    if (!cutoff.empty())
+    {
+        cutoffValue = std::find(values.begin(), values.end(), cutoff) - values.begin();
+        NS_ABORT_MSG_IF(cutoffValue == int(values.size()), cutoff << " is not in --values");
+        for (size_t k = 0; k < keys.size(); k++)
+        {
+            cutoffKeyIndex = keys[k].name == cutoffKey ? k : cutoffKeyIndex;
+        }
+        NS_ABORT_MSG_IF(cutoffKeyIndex < 0, cutoffKey << " is not in --groupBy");
+    }
+
+    // Every thread groups its share of every table into groups of its own, which are
+    // merged afterwards, so that the scan needs no locks
+    auto start = std::chrono::steady_clock::now();
+    std::vector<GroupMap> threadGroups(threads);
+    size_t bytes = 0;
+    for (const Table& table : tables)
+    {
+        TablePlan plan = PlanTable(table, keys, values);
+        bytes += table.size;
+        if (table.binary)
+        {
+            ParallelFor(table.rows, threads, [&](size_t begin, size_t end, unsigned thread) {
+                GroupBinaryRange(table, begin, end, keys, plan, threadGroups[thread]);
+            });
+        }
+        else
+        {
+            const char* body = table.data + table.bodyOffset;
+            std::vector<size_t> bounds = SplitAtLines(body, table.size - table.bodyOffset, threads);
+            RunThreads(threads, [&](unsigned thread) {
+                GroupCsvRange(body + bounds[thread],
+                              body + bounds[thread + 1],
+                              keys,
+                              plan,
+                              threadGroups[thread]);
+            });
+        }
+        munmap(const_cast<char*>(table.data), table.size);
+    }
+    GroupMap groups = std::move(threadGroups[0]);
+    for (unsigned thread = 1; thread < threads; thread++)
+    {
+        for (auto& [key, group] : threadGroups[thread])
+        {
+            Group& merged = groups[key];
+            if (merged.values.empty())
+            {
+                merged = std::move(group);
+                continue;
+            }
+            merged.rows += group.rows;
+            for (size_t v = 0; v < values.size(); v++)
+            {
+                merged.values[v].insert(merged.values[v].end(),
+                                        group.values[v].begin(),
+                                        group.values[v].end());
+            }
+        }
+    }
+    double scanSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Statistics of every group, computed in parallel over the groups
+    struct Row
+    {
+        std::vector<std::string> key;
+        uint64_t rows;
+        std::vector<double> stats; // Per value: count, mean, stddev, ci, quantiles
+    };
+    std::vector<Row> rows;
+    std::vector<Group*> rowGroups;
+    for (auto& [key, group] : groups)
+    {
+        rows.push_back({KeyParts(key), group.rows, {}});
+        rowGroups.push_back(&group);
+    }
+    const size_t statsPerValue = 4 + quantiles.size();
+    ParallelFor(rows.size(), threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t r = begin; r < end; r++)
+        {
+            for (std::vector<double>& sample : rowGroups[r]->values)
+            {
+                std::sort(sample.begin(), sample.end());
+                double n = sample.size();
+                double mean = NAN;
+                double deviation = NAN;
+                double interval = NAN;
+                if (n > 0)
+                {
+                    mean = 0;
+                    for (double value : sample)
+                    {
+                        mean += value;
+                    }
+                    mean /= n;
+                }
+                if (n > 1)
+                {
+                    double squares = 0;
+                    for (double value : sample)
+                    {
+                        squares += (value - mean) * (value - mean);
+                    }
+                    deviation = std::sqrt(squares / (n - 1));
+                    interval = StudentQuantile(n - 1, confidence) * deviation / std::sqrt(n);
+                }
+                rows[r].stats.insert(rows[r].stats.end(), {n, mean, deviation, interval});
+                for (double q : quantiles)
+                {
+                    rows[r].stats.push_back(n > 0 ? Quantile(sample, q) : NAN);
+                }
+            }
+        }
+    });
+    std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+        return KeyPartsLess(a.key, b.key);
+    });
+
+    std::ofstream file(output);
+    file << std::setprecision(10);
+    for (const GroupKey& key : keys)
+    {
+        file << key.name << ",";
+    }
+    file << "rows";
+    for (const std::string& value : values)
+    {
+        file << "," << value << "Count," << value << "Mean," << value << "StdDev," << value
+             << "Ci";
+        for (const std::string& quantile : SplitList(quantileList))
+        {
+            file << "," << value << "Q" << quantile;
+        }
+    }
+    file << "\n";
+    for (const Row& row : rows)
+    {
+        for (const std::string& part : row.key)
+        {
+            file << part << ",";
+        }
+        file << row.rows;
+        for (double stat : row.stats)
+        {
+            file << ",";
+            if (!std::isnan(stat))
+            {
+                file << stat;
+            }
+        }
+        file << "\n";
+    }
+    NS_ABORT_MSG_IF(!file, "Cannot write " << output);
+
+    if (cutoffValue >= 0)
+    {
+        // Along the cutoff key in ascending order, the last value above the threshold and
+        // the first one at or below it after that, for every combination of the other keys
+        std::map<std::vector<std::string>, std::pair<double, double>> cutoffs;
+        std::vector<std::vector<std::string>> order;
+        for (const Row& row : rows)
+        {
+            std::vector<std::string> others = row.key;
+            others.erase(others.begin() + cutoffKeyIndex);
+            double position = ParseNumber(row.key[cutoffKeyIndex]);
+            double mean = row.stats[cutoffValue * statsPerValue + 1];
+            auto [entry, inserted] = cutoffs.try_emplace(others, NAN, NAN);
+            if (inserted)
+            {
+                order.push_back(others);
+            }
+            auto& [lastAbove, firstBelow] = entry->second;
+            if (mean > cutoffThreshold)
+            {
+                lastAbove = position;
+                firstBelow = NAN;
+            }
+            else if (std::isnan(firstBelow))
+            {
+                firstBelow = position;
+            }
+        }
+
+        std::string cutoffFile = output.substr(0, output.rfind('.')) + "_cutoff.csv";
+        std::ofstream file(cutoffFile);
+        for (size_t k = 0; k < keys.size(); k++)
+        {
+            if (int(k) != cutoffKeyIndex)
+            {
+                file << keys[k].name << ",";
+            }
+        }
+        file << "lastAbove,cutoff\n";
+        for (const std::vector<std::string>& others : order)
+        {
+            for (const std::string& part : others)
+            {
+                file << part << ",";
+            }
+            auto [lastAbove, firstBelow] = cutoffs[others];
+            if (!std::isnan(lastAbove))
+            {
+                file << lastAbove;
+            }
+            file << ",";
+            if (!std::isnan(firstBelow))
+            {
+                file << firstBelow;
+            }
+            file << "\n";
+        }
+        NS_ABORT_MSG_IF(!file, "Cannot write " << cutoffFile);
+    }
+
+    NS_LOG_UNCOND("Scanned " << bytes / 1e6 << " MB into " << groups.size() << " groups in "
+                             << scanSeconds << " s, " << bytes / 1e9 / scanSeconds << " GB/s");
+    return 0;
+}
@@ -0,0 +1,283 @@
+#ifndef ANTENNA_GAIN_LOSS_MODEL_H
+#define ANTENNA_GAIN_LOSS_MODEL_H
+
+#include "ns3/angles.h"
+#include "ns3/antenna-model.h"
+#include "ns3/mobility-model.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/simple-ref-count.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * The gain of an antenna sampled on a regular azimuth/inclination grid, looked up with
+ * bilinear interpolation.
+ *
+ * Evaluating an AntennaModel, or interpolating a measured pattern, for every frame costs
+ * trigonometry and, for measured patterns, a search of the grid. The table moves that
+ * work to its construction, leaving two index computations and four loads per lookup.
+ */
+class AntennaGainTable : public SimpleRefCount<AntennaGainTable>
+{
+  public:
+    /**
+     * Sample an antenna model.
+     *
+     * \param antenna the antenna, with its boresight at azimuth 0 and inclination 90°
+     * \param resolutionDeg the grid spacing in degrees
+     */
+    AntennaGainTable(Ptr<AntennaModel> antenna, double resolutionDeg = 1)
+        : AntennaGainTable(resolutionDeg)
+    {
+        Fill([antenna](double azimuth, double inclination) {
+            return antenna->GetGainDb(Angles(azimuth, inclination));
+        });
+    }
+
+    /**
+     * Load a measured pattern and resample it on the table grid.
+     *
+     * The file holds one "azimuth inclination gain" triple per line, in degrees and dBi,
+     * separated by spaces or commas, covering a rectangular grid of any spacing. Lines
+     * that do not start with a number, such as a header, are skipped. Azimuths wrap
+     * around, inclinations outside the measured range take the gain of the nearest one.
+     *
+     * \param path the pattern file
+     * \param resolutionDeg the grid spacing in degrees
+     */
+    AntennaGainTable(const std::string& path, double resolutionDeg = 1)
+        : AntennaGainTable(resolutionDeg)
+    {
+        std::ifstream file(path);
+        NS_ABORT_MSG_IF(!file, "Cannot read antenna pattern " << path);
+
+        std::map<std::pair<double, double>, double> pattern;
+        std::vector<double> azimuths;
+        std::vector<double> inclinations;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::replace(line.begin(), line.end(), ',', ' ');
+            std::istringstream stream(line);
+            double azimuth;
+            double inclination;
+            double gainDb;
+            if (!(stream >> azimuth >> inclination >> gainDb))
+            {
+                continue;
+            }
+            azimuth = std::remainder(azimuth, 360.0);
+            azimuth = azimuth == 180 ? -180 : azimuth;
+            pattern[{azimuth, inclination}] = gainDb;
+            azimuths.push_back(azimuth);
+            inclinations.push_back(inclination);
+        }
+        for (std::vector<double>* values : {&azimuths, &inclinations})
+        {
+            std::sort(values->begin(), values->end());
+            values->erase(std::unique(values->begin(), values->end()), values->end());
+        }
+        NS_ABORT_MSG_IF(pattern.empty() || pattern.size() != azimuths.size() * inclinations.size(),
+                        "Antenna pattern " << path << " is not a rectangular grid");
+
+        // Bracket a value on the measured grid: the indices of its neighbours and its
+        // weight towards the upper one
+        auto bracket = [](const std::vector<double>& grid, double value, bool wrap) {
+            auto upper = std::upper_bound(grid.begin(), grid.end(), value);
+            if (upper == grid.begin() || upper == grid.end())
+            {
+                if (!wrap || grid.size() == 1)
+                {
+                    size_t index = upper == grid.begin() ? 0 : grid.size() - 1;
+                    return std::make_tuple(index, index, 0.0);
+                }
+                double span = grid.front() + 360 - grid.back();
+                double offset = value >= grid.back() ? value - grid.back()
+                                                     : value + 360 - grid.back();
+                return std::make_tuple(grid.size() - 1, size_t(0), offset / span);
+            }
+            size_t high = upper - grid.begin();
+            return std::make_tuple(high - 1,
+                                   high,
+                                   (value - grid[high - 1]) / (grid[high] - grid[high - 1]));
+        };
+
+        Fill([&](double azimuth, double inclination) {
+            auto [a0, a1, aw] = bracket(azimuths, azimuth * 180 / M_PI, true);
+            auto [i0, i1, iw] = bracket(inclinations, inclination * 180 / M_PI, false);
+            auto gain = [&](size_t a, size_t i) {
+                return pattern.at({azimuths[a], inclinations[i]});
+            };
+            return (1 - iw) * ((1 - aw) * gain(a0, i0) + aw * gain(a1, i0)) +
+                   iw * ((1 - aw) * gain(a0, i1) + aw * gain(a1, i1));
+        });
+    }
+
+    /**
+     * \param azimuth the azimuth relative to the boresight in radians, any value
+     * \param inclination the inclination in radians, from 0 (zenith) to pi
+     * \return the gain in dBi
+     */
+    double GetGainDb(double azimuth, double inclination) const
+    {
+        double a = (azimuth + M_PI) * m_stepsPerRadian;
+        a -= std::floor(a / m_azimuthSteps) * m_azimuthSteps;
+        double i = std::clamp(inclination * m_stepsPerRadian, 0.0, double(m_inclinationSteps));
+
+        size_t a0 = std::min(size_t(a), m_azimuthSteps - 1);
+        size_t i0 = std::min(size_t(i), m_inclinationSteps - 1);
+        double aw = a - a0;
+        double iw = i - i0;
+
+        const double* row0 = &m_gainDb[i0 * (m_azimuthSteps + 1)];
+        const double* row1 = row0 + m_azimuthSteps + 1;
+        return (1 - iw) * ((1 - aw) * row0[a0] + aw * row0[a0 + 1]) +
+               iw * ((1 - aw) * row1[a0] + aw * row1[a0 + 1]);
+    }
+
+  private:
+    explicit AntennaGainTable(double resolutionDeg)
+        : m_azimuthSteps(std::lround(360 / resolutionDeg)),
+          m_inclinationSteps(std::lround(180 / resolutionDeg)),
+          m_stepsPerRadian(m_azimuthSteps / (2 * M_PI))
+    {
+        NS_ABORT_MSG_IF(m_azimuthSteps < 2 || m_inclinationSteps < 1,
+                        "Antenna table resolution too coarse");
+    }
+
+    /**
+     * Sample the gain on the grid. Rows are inclinations, and every row repeats its first
+     * azimuth at its end, so that the interpolation never wraps.
+     */
+    template <typename GainFunction>
+    void Fill(GainFunction gainDb)
+    {
+        m_gainDb.resize((m_inclinationSteps + 1) * (m_azimuthSteps + 1));
+        for (size_t i = 0; i <= m_inclinationSteps; i++)
+        {
+            for (size_t a = 0; a <= m_azimuthSteps; a++)
+            {
+                m_gainDb[i * (m_azimuthSteps + 1) + a] =
+                    gainDb((a % m_azimuthSteps) / m_stepsPerRadian - M_PI, i / m_stepsPerRadian);
+            }
+        }
+    }
+
+    size_t m_azimuthSteps;        //!< Grid intervals over the full circle
+    size_t m_inclinationSteps;    //!< Grid intervals from zenith to nadir
+    double m_stepsPerRadian;      //!< Grid resolution
+    std::vector<double> m_gainDb; //!< Gains, inclination-major
+};
+
+/**
+ * A loss model that adds the directional gain of the transmitting and the receiving
+ * antenna, taken from their gain tables, to the received power.
+ *
+ * Chained after the path loss models of a channel, it lets the scalar TxGain and RxGain
+ * of the PHYs represent cable and system gains only, while the pattern depends on where
+ * the peer is. Nodes without an antenna are isotropic.
+ */
+class AntennaGainLossModel : public PropagationLossModel
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    /**
+     * Give a node a directional antenna.
+     *
+     * \param mobility the mobility model of the node
+     * \param table the gain table of its antenna
+     * \param orientation the azimuth of its boresight in radians
+     */
+    void AddAntenna(Ptr<MobilityModel> mobility,
+                    Ptr<const AntennaGainTable> table,
+                    double orientation);
+
+  private:
+    /// The antenna of a node
+    struct Antenna
+    {
+        Ptr<const AntennaGainTable> table; //!< Its pattern
+        double orientation;                //!< Azimuth of its boresight
+    };
+
+    double DoCalcRxPower(double txPowerDbm,
+                         Ptr<MobilityModel> a,
+                         Ptr<MobilityModel> b) const override;
+    int64_t DoAssignStreams(int64_t stream) override;
+
+    /**
+     * \return the gain of the antenna at from towards to, 0 if from has none
+     */
+    double GetGainDb(Ptr<MobilityModel> from, Ptr<MobilityModel> to) const;
+
+    std::unordered_map<const MobilityModel*, Antenna> m_antennas; //!< Antennas by node position
+};
+
+NS_OBJECT_ENSURE_REGISTERED(AntennaGainLossModel);
+
+inline TypeId
+AntennaGainLossModel::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::AntennaGainLossModel")
+                            .SetParent<PropagationLossModel>()
+                            .SetGroupName("Propagation")
+                            .AddConstructor<AntennaGainLossModel>();
+    return tid;
+}
+
+inline void
+AntennaGainLossModel::AddAntenna(Ptr<MobilityModel> mobility,
+                                 Ptr<const AntennaGainTable> table,
+                                 double orientation)
+{
+    m_antennas[PeekPointer(mobility)] = {table, orientation};
+}
+
+inline double
+AntennaGainLossModel::GetGainDb(Ptr<MobilityModel> from, Ptr<MobilityModel> to) const
+{
+    auto antenna = m_antennas.find(PeekPointer(from));
+    if (antenna == m_antennas.end())
+    {
+        return 0;
+    }
+    Vector direction = to->GetPosition() - from->GetPosition();
+    double distance = direction.GetLength();
+    double azimuth = std::atan2(direction.y, direction.x) - antenna->second.orientation;
+    double inclination = distance > 0 ? std::acos(direction.z / distance) : M_PI / 2;
+    return antenna->second.table->GetGainDb(azimuth, inclination);
+}
+
+inline double
+AntennaGainLossModel::DoCalcRxPower(double txPowerDbm,
+                                    Ptr<MobilityModel> a,
+                                    Ptr<MobilityModel> b) const
+{
+    return txPowerDbm + GetGainDb(a, b) + GetGainDb(b, a);
+}
+
+inline int64_t
+AntennaGainLossModel::DoAssignStreams(int64_t stream)
+{
+    return 0;
+}
+
+} // namespace ns3
+
+#endif /* ANTENNA_GAIN_LOSS_MODEL_H */
@@ -0,0 +1,237 @@
+#ifndef BACKGROUND_INTERFERENCE_H
+#define BACKGROUND_INTERFERENCE_H
+
+#include "ns3/callback.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/double.h"
+#include "ns3/event-id.h"
+#include "ns3/interference-helper.h"
+#include "ns3/mobility-model.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/pointer.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/wifi-phy.h"
+#include "ns3/wifi-utils.h"
+
+#include <cmath>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * An aggregate co-channel interference process standing in for many interfering nodes.
+ *
+ * Instead of full nodes with stacks, applications and MACs, every interferer is only a
+ * position and a duty cycle. A single scheduled process advances in bursts: at each burst
+ * every interferer is active with the probability of its duty cycle, draws a transmit
+ * power from the configured distribution and reaches each receiver through the loss
+ * model of the channel. The powers are summed and injected into the interference tracker
+ * of the receiving PHYs for the duration of the burst, so the cost in events is one per
+ * burst regardless of the number of interferers. The PHYs sense the injected power for
+ * CCA like that of any other signal.
+ */
+class BackgroundInterference : public Object
+{
+  public:
+    /// Adds a signal of the given duration and power in Watts to a PHY's interference
+    typedef Callback<void, Time, double> InjectCallback;
+
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    /**
+     * \param lossModel the loss model between the interferers and the receivers
+     */
+    void SetLossModel(Ptr<PropagationLossModel> lossModel);
+
+    /**
+     * \param position the position of the interferer
+     * \param dutyCycle the fraction of time the interferer transmits
+     */
+    void AddInterferer(Vector position, double dutyCycle);
+
+    /**
+     * \param position the position of the interferer
+     * \param dutyCycle the fraction of time the interferer transmits
+     * \param txPowerDbm the transmit power of the interferer, instead of one drawn from
+     *        the TxPower distribution at every burst
+     */
+    void AddInterferer(Vector position, double dutyCycle, double txPowerDbm);
+
+    /**
+     * \param mobility the position of the receiver
+     * \param inject adds the aggregate interference to the receiving PHY
+     */
+    void AddReceiver(Ptr<MobilityModel> mobility, InjectCallback inject);
+
+    /**
+     * Start the process.
+     *
+     * \param start when the first burst begins
+     */
+    void Start(Time start);
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /// An interfering transmitter
+    struct Interferer
+    {
+        Ptr<MobilityModel> mobility; //!< Its position
+        double dutyCycle;            //!< Fraction of time it transmits
+        double txPowerDbm;           //!< Its transmit power, NaN to draw it per burst
+    };
+
+    /// A PHY the interference is injected into
+    struct Receiver
+    {
+        Ptr<MobilityModel> mobility; //!< Its position
+        InjectCallback inject;       //!< Adds interference to its tracker
+    };
+
+    /**
+     * Draw the active interferers of a burst and inject their summed power.
+     */
+    void Burst();
+
+    Time m_burstDuration;                   //!< Duration of a burst
+    Ptr<RandomVariableStream> m_txPowerDbm; //!< Transmit power distribution
+    Ptr<UniformRandomVariable> m_activity;  //!< Draws the active interferers
+    Ptr<PropagationLossModel> m_loss;       //!< Interferer to receiver loss
+    std::vector<Interferer> m_interferers;  //!< All interferers
+    std::vector<Receiver> m_receivers;      //!< All receivers
+    EventId m_burstEvent;                   //!< Next burst
+};
+
+/**
+ * Inject interference into the InterferenceHelper of a full (Yans) PHY as a foreign,
+ * non-Wi-Fi signal, and let the PHY switch to CCA busy if the energy on air exceeds its
+ * CCA-ED threshold. Meant to be bound with MakeBoundCallback.
+ *
+ * \param helper the interference helper of the PHY
+ * \param phy the PHY
+ * \param duration the duration of the signal
+ * \param powerW the received power of the signal in Watts
+ */
+inline void
+InjectForeignSignal(Ptr<InterferenceHelper> helper, Ptr<WifiPhy> phy, Time duration, double powerW)
+{
+    // Yans PHYs use a single dummy band
+    RxPowerWattPerChannelBand rxPower;
+    rxPower.insert({std::make_pair(0, 0), powerW});
+    helper->AddForeignSignal(duration, rxPower, phy->GetCurrentFrequencyRange());
+    phy->SwitchMaybeToCcaBusy();
+}
+
+NS_OBJECT_ENSURE_REGISTERED(BackgroundInterference);
+
+inline TypeId
+BackgroundInterference::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::BackgroundInterference")
+            .SetParent<Object>()
+            .SetGroupName("Wifi")
+            .AddConstructor<BackgroundInterference>()
+            .AddAttribute("BurstDuration",
+                          "Duration of a burst, i.e. how often the set of active interferers "
+                          "is redrawn",
+                          TimeValue(MilliSeconds(1)),
+                          MakeTimeAccessor(&BackgroundInterference::m_burstDuration),
+                          MakeTimeChecker())
+            .AddAttribute("TxPower",
+                          "Distribution of the transmit power of an active interferer in dBm",
+                          StringValue("ns3::ConstantRandomVariable[Constant=10.0]"),
+                          MakePointerAccessor(&BackgroundInterference::m_txPowerDbm),
+                          MakePointerChecker<RandomVariableStream>());
+    return tid;
+}
+
+inline void
+BackgroundInterference::DoDispose()
+{
+    m_burstEvent.Cancel();
+    m_txPowerDbm = nullptr;
+    m_activity = nullptr;
+    m_loss = nullptr;
+    m_interferers.clear();
+    m_receivers.clear();
+    Object::DoDispose();
+}
+
+inline void
+BackgroundInterference::SetLossModel(Ptr<PropagationLossModel> lossModel)
+{
+    m_loss = lossModel;
+}
+
+inline void
+BackgroundInterference::AddInterferer(Vector position, double dutyCycle)
+{
+    AddInterferer(position, dutyCycle, NAN);
+}
+
+inline void
+BackgroundInterference::AddInterferer(Vector position, double dutyCycle, double txPowerDbm)
+{
+    Ptr<MobilityModel> mobility = CreateObject<ConstantPositionMobilityModel>();
+    mobility->SetPosition(position);
+    m_interferers.push_back({mobility, dutyCycle, txPowerDbm});
+}
+
+inline void
+BackgroundInterference::AddReceiver(Ptr<MobilityModel> mobility, InjectCallback inject)
+{
+    m_receivers.push_back({mobility, inject});
+}
+
+inline void
+BackgroundInterference::Start(Time start)
+{
+    NS_ASSERT_MSG(m_loss, "BackgroundInterference needs a loss model");
+    m_activity = CreateObject<UniformRandomVariable>();
+    m_burstEvent = Simulator::Schedule(start, &BackgroundInterference::Burst, this);
+}
+
+inline void
+BackgroundInterference::Burst()
+{
+    std::vector<double> powerW(m_receivers.size(), 0);
+    for (const Interferer& interferer : m_interferers)
+    {
+        if (m_activity->GetValue() >= interferer.dutyCycle)
+        {
+            continue;
+        }
+        double txPowerDbm = std::isnan(interferer.txPowerDbm) ? m_txPowerDbm->GetValue()
+                                                              : interferer.txPowerDbm;
+        for (std::size_t i = 0; i < m_receivers.size(); i++)
+        {
+            powerW[i] += DbmToW(
+                m_loss->CalcRxPower(txPowerDbm, interferer.mobility, m_receivers[i].mobility));
+        }
+    }
+
+    for (std::size_t i = 0; i < m_receivers.size(); i++)
+    {
+        if (powerW[i] > 0)
+        {
+            m_receivers[i].inject(m_burstDuration, powerW[i]);
+        }
+    }
+
+    m_burstEvent = Simulator::Schedule(m_burstDuration, &BackgroundInterference::Burst, this);
+}
+
+} // namespace ns3
+
+#endif /* BACKGROUND_INTERFERENCE_H */
@@ -0,0 +1,233 @@
+#ifndef CPU_PLACEMENT_H
+#define CPU_PLACEMENT_H
+
+#include <dirent.h>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/**
+ * Where a logical CPU sits in the machine.
+ */
+struct CpuInfo
+{
+    int cpu;     //!< Logical CPU number
+    int node;    //!< NUMA node
+    int package; //!< Socket
+    int core;    //!< Core within the socket
+    int thread;  //!< Rank of the CPU among the SMT siblings of its core
+};
+
+/**
+ * Read an integer from a sysfs file.
+ *
+ * \return the value, or fallback if the file cannot be read
+ */
+inline int
+ReadSysfsInt(const std::string& path, int fallback)
+{
+    std::ifstream file(path);
+    int value;
+    return file >> value ? value : fallback;
+}
+
+/**
+ * \return the NUMA node of a logical CPU, 0 if sysfs does not tell
+ */
+inline int
+ReadCpuNode(int cpu)
+{
+    int node = 0;
+    std::string directory = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    if (DIR* dir = opendir(directory.c_str()))
+    {
+        while (dirent* entry = readdir(dir))
+        {
+            if (std::strncmp(entry->d_name, "node", 4) == 0)
+            {
+                node = std::atoi(entry->d_name + 4);
+            }
+        }
+        closedir(dir);
+    }
+    return node;
+}
+
+/**
+ * Read the topology of the CPUs this process may run on from sysfs. Machines without
+ * NUMA or topology information are treated as one node with one thread per core.
+ */
+inline std::vector<CpuInfo>
+ReadCpuTopology()
+{
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+
+    std::vector<CpuInfo> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (!CPU_ISSET(cpu, &allowed))
+        {
+            continue;
+        }
+        std::string directory = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        CpuInfo info{cpu, ReadCpuNode(cpu), 0, cpu, 0};
+        info.package = ReadSysfsInt(directory + "/topology/physical_package_id", 0);
+        info.core = ReadSysfsInt(directory + "/topology/core_id", cpu);
+        cpus.push_back(info);
+    }
+
+    // Siblings are ranked by CPU number, which is how Linux enumerates them
+    std::map<std::tuple<int, int>, int> siblings;
+    for (CpuInfo& info : cpus)
+    {
+        info.thread = siblings[{info.package, info.core}]++;
+    }
+    return cpus;
+}
+
+/**
+ * Order the CPUs in which workers are pinned to them: worker slot i runs on the i-th
+ * CPU of the order, wrapping around if there are more workers than CPUs.
+ *
+ * - compact fills one core after the other, SMT siblings first, and one node after the
+ *   other, keeping workers close together;
+ * - spread takes one thread of every core, alternating between the NUMA nodes, before
+ *   using any SMT sibling;
+ * - physical only uses the first thread of every core, so no two workers share a core as
+ *   long as there are no more workers than cores.
+ *
+ * \param policy compact, spread or physical
+ * \param cpus the topology
+ * \return the CPUs in pinning order, or nothing for an unknown policy
+ */
+inline std::vector<int>
+PlacementOrder(const std::string& policy, const std::vector<CpuInfo>& cpus)
+{
+    std::vector<CpuInfo> order = cpus;
+    auto compact = [](const CpuInfo& a, const CpuInfo& b) {
+        return std::tie(a.node, a.package, a.core, a.thread) <
+               std::tie(b.node, b.package, b.core, b.thread);
+    };
+    std::sort(order.begin(), order.end(), compact);
+
+    if (policy == "physical")
+    {
+        order.erase(std::remove_if(order.begin(),
+                                   order.end(),
+                                   [](const CpuInfo& info) { return info.thread != 0; }),
+                    order.end());
+    }
+    else if (policy == "spread")
+    {
+        // Rank every core within its node, then take the cores rank by rank across nodes
+        std::map<int, int> coresSeen;
+        std::map<std::tuple<int, int, int>, int> coreRank;
+        for (const CpuInfo& info : order)
+        {
+            if (coreRank.emplace(std::make_tuple(info.node, info.package, info.core),
+                                 coresSeen[info.node])
+                    .second)
+            {
+                coresSeen[info.node]++;
+            }
+        }
+        std::stable_sort(order.begin(),
+                         order.end(),
+                         [&coreRank](const CpuInfo& a, const CpuInfo& b) {
+                             int rankA = coreRank.at({a.node, a.package, a.core});
+                             int rankB = coreRank.at({b.node, b.package, b.core});
+                             return std::tie(a.thread, rankA, a.node) <
+                                    std::tie(b.thread, rankB, b.node);
+                         });
+    }
+    else if (policy != "compact")
+    {
+        return {};
+    }
+
+    std::vector<int> result;
+    for (const CpuInfo& info : order)
+    {
+        result.push_back(info.cpu);
+    }
+    return result;
+}
+
+/**
+ * Count the physical cores the first workers of a placement order run on.
+ *
+ * \param order the placement order
+ * \param workers the number of workers
+ * \param cpus the topology
+ * \return the number of distinct cores
+ */
+inline size_t
+PhysicalCoresUsed(const std::vector<int>& order, size_t workers, const std::vector<CpuInfo>& cpus)
+{
+    std::set<std::tuple<int, int>> cores;
+    for (size_t i = 0; i < workers && !order.empty(); i++)
+    {
+        int cpu = order[i % order.size()];
+        for (const CpuInfo& info : cpus)
+        {
+            if (info.cpu == cpu)
+            {
+                cores.insert({info.package, info.core});
+            }
+        }
+    }
+    return cores.size();
+}
+
+/**
+ * The CPUs forked workers are pinned to, in slot order. Empty means no pinning.
+ */
+inline std::vector<int>&
+WorkerCpus()
+{
+    static std::vector<int> cpus;
+    return cpus;
+}
+
+/**
+ * Pin the calling process to the CPU of a worker slot, if a placement is set, and bind
+ * the memory it allocates afterwards to the NUMA node of that CPU. Pages inherited from
+ * the coordinator stay where they are.
+ */
+inline void
+PinWorker(size_t slot)
+{
+    const std::vector<int>& cpus = WorkerCpus();
+    if (cpus.empty())
+    {
+        return;
+    }
+    int cpu = cpus[slot % cpus.size()];
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+
+    // Through the system call, as glibc has no wrapper and libnuma is not a dependency;
+    // the kernel expects one bit more than the mask holds
+    const int bitsPerWord = 8 * sizeof(unsigned long);
+    int node = ReadCpuNode(cpu);
+    std::vector<unsigned long> nodes(node / bitsPerWord + 1, 0);
+    nodes[node / bitsPerWord] |= 1UL << (node % bitsPerWord);
+    syscall(SYS_set_mempolicy, MPOL_BIND, nodes.data(), nodes.size() * bitsPerWord + 1);
+}
+
+#endif /* CPU_PLACEMENT_H */
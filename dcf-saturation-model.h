@@ -0,0 +1,188 @@
+#ifndef DCF_SATURATION_MODEL_H
+#define DCF_SATURATION_MODEL_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Channel access parameters of a DCF or EDCA access category. The defaults are those of
+ * the 802.11n best effort access category in the 5 GHz band, as ns-3 uses them for an
+ * ad hoc MAC.
+ */
+struct DcfParameters
+{
+    double slotSeconds = 9e-6; //!< Slot time
+    uint32_t cwMin = 15;       //!< Minimum contention window
+    uint32_t cwMax = 1023;     //!< Maximum contention window
+    uint32_t attempts = 7;     //!< Transmission attempts of a frame before it is dropped
+};
+
+/**
+ * What the model needs to know about the link of one saturated station to the receiver.
+ */
+struct DcfStation
+{
+    double errorProbability; //!< A transmission that does not collide fails, e.g. PER
+    double busySeconds;      //!< Channel time of a transmission with its response and AIFS
+    double deliveredBits;    //!< Payload delivered by a transmission that does not collide
+};
+
+/**
+ * The saturation state of the stations sharing a channel.
+ */
+struct DcfSolution
+{
+    std::vector<double> transmitProbability; //!< Probability to transmit in a slot, tau
+    std::vector<double> failureProbability;  //!< Probability a transmission fails, p
+    std::vector<double> dropProbability;     //!< Probability a frame exhausts its attempts
+    std::vector<double> throughput;          //!< Payload throughput in bit/s
+    double totalThroughput = 0;              //!< Sum of the throughput of all stations
+    double idleProbability = 0;              //!< Probability a slot is idle
+    double collisionProbability = 0;         //!< Probability a slot holds a collision
+    double meanSlotSeconds = 0;              //!< Mean duration of a slot
+    uint32_t iterations = 0;                 //!< Fixed point iterations used
+    bool converged = false;                  //!< Whether the fixed point was reached
+};
+
+/**
+ * Probability that a saturated station transmits in a random slot when each of its
+ * transmissions fails with probability p, following Bianchi's Markov chain with a finite
+ * number of attempts: the contention window doubles from cwMin + 1 slots after each failure
+ * up to cwMax + 1, and the frame is dropped after the last attempt.
+ *
+ * \param p the failure probability of a transmission
+ * \param parameters the channel access parameters
+ * \return tau
+ */
+inline double
+DcfTransmitProbability(double p, const DcfParameters& parameters)
+{
+    // tau = sum p^i / sum p^i (W_i + 1) / 2 over the backoff stages i < attempts, as the
+    // station spends (W_i + 1) / 2 slots on average in stage i, including the transmission
+    double attemptSum = 0;
+    double slotSum = 0;
+    double reach = 1;
+    double window = parameters.cwMin + 1.0;
+    for (uint32_t stage = 0; stage < parameters.attempts; stage++)
+    {
+        attemptSum += reach;
+        slotSum += reach * (window + 1) / 2;
+        reach *= p;
+        window = std::min(2 * window, parameters.cwMax + 1.0);
+    }
+    return attemptSum / slotSum;
+}
+
+/**
+ * Solve the saturation throughput model of Bianchi for stations that all hear each other
+ * and always have a frame to send, extended by a finite number of attempts and by
+ * transmission errors.
+ *
+ * A transmission of station i fails if another station transmits in the same slot or, if
+ * none does, with its error probability, so p_i = 1 - (1 - e_i) prod_{j != i} (1 - tau_j).
+ * tau_i follows from p_i by DcfTransmitProbability; the coupled equations are solved by a
+ * damped fixed point iteration. A slot is idle, holds the transmission of a single station,
+ * which takes its busy time, or holds a collision, which takes the longest busy time of the
+ * stations as the colliding frames are not known. Each station delivers its delivered bits
+ * per transmission that does not collide.
+ *
+ * Hidden stations, capture and the post-backoff of unsaturated stations are not modelled.
+ *
+ * \param stations the stations, at least one
+ * \param parameters the channel access parameters
+ * \return the solution
+ */
+inline DcfSolution
+SolveDcfSaturation(const std::vector<DcfStation>& stations, const DcfParameters& parameters)
+{
+    const uint32_t maxIterations = 10000;
+    const double tolerance = 1e-12;
+
+    // Stations with the same error probability transmit with the same probability, so the
+    // iteration runs over the distinct error probabilities, weighted by their stations
+    std::vector<double> errors;
+    std::vector<double> weights;
+    std::vector<size_t> classOf;
+    for (const DcfStation& station : stations)
+    {
+        size_t c = std::find(errors.begin(), errors.end(), station.errorProbability) -
+                   errors.begin();
+        if (c == errors.size())
+        {
+            errors.push_back(station.errorProbability);
+            weights.push_back(0);
+        }
+        weights[c]++;
+        classOf.push_back(c);
+    }
+
+    DcfSolution solution;
+    std::vector<double> tau(errors.size(), DcfTransmitProbability(0, parameters));
+    std::vector<double> p(errors.size(), 0);
+
+    // The product of 1 - tau over all stations, divided by 1 - tau of a station of class c
+    // for the stations other than it. tau never exceeds 2 / (cwMin + 2), so the division is
+    // safe
+    auto idleOfAll = [&tau, &weights]() {
+        double idle = 1;
+        for (size_t c = 0; c < tau.size(); c++)
+        {
+            idle *= std::pow(1 - tau[c], weights[c]);
+        }
+        return idle;
+    };
+    auto idleOfOthers = [&tau](double idle, size_t c) { return idle / (1 - tau[c]); };
+
+    while (solution.iterations < maxIterations && !solution.converged)
+    {
+        solution.iterations++;
+        double idle = idleOfAll();
+        for (size_t c = 0; c < tau.size(); c++)
+        {
+            p[c] = 1 - (1 - errors[c]) * idleOfOthers(idle, c);
+        }
+        double change = 0;
+        for (size_t c = 0; c < tau.size(); c++)
+        {
+            double next = DcfTransmitProbability(p[c], parameters);
+            change = std::max(change, std::fabs(next - tau[c]));
+            // Damped, as the plain iteration oscillates for many stations
+            tau[c] = (tau[c] + next) / 2;
+        }
+        solution.converged = change < tolerance;
+    }
+
+    double idle = idleOfAll();
+    double longestBusy = 0;
+    double successSum = 0;
+    double busyTime = 0;
+    std::vector<double> success;
+    for (size_t i = 0; i < stations.size(); i++)
+    {
+        size_t c = classOf[i];
+        double failure = 1 - (1 - errors[c]) * idleOfOthers(idle, c);
+        solution.transmitProbability.push_back(tau[c]);
+        solution.failureProbability.push_back(failure);
+        solution.dropProbability.push_back(std::pow(failure, parameters.attempts));
+        success.push_back(tau[c] * idleOfOthers(idle, c));
+        successSum += success.back();
+        busyTime += success.back() * stations[i].busySeconds;
+        longestBusy = std::max(longestBusy, stations[i].busySeconds);
+    }
+
+    solution.idleProbability = idle;
+    solution.collisionProbability = std::max(1 - idle - successSum, 0.0);
+    solution.meanSlotSeconds = idle * parameters.slotSeconds + busyTime +
+                               solution.collisionProbability * longestBusy;
+    for (size_t i = 0; i < stations.size(); i++)
+    {
+        solution.throughput.push_back(success[i] * stations[i].deliveredBits /
+                                      solution.meanSlotSeconds);
+        solution.totalThroughput += solution.throughput.back();
+    }
+    return solution;
+}
+
+#endif /* DCF_SATURATION_MODEL_H */
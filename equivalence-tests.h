@@ -0,0 +1,156 @@
+#ifndef EQUIVALENCE_TESTS_H
+#define EQUIVALENCE_TESTS_H
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+/**
+ * Result of a two-sample test.
+ */
+struct TwoSampleTest
+{
+    double statistic; //!< The test statistic
+    double pValue;    //!< Probability of a statistic at least as extreme if both samples
+                      //!< come from the same distribution
+};
+
+/**
+ * Complementary distribution function of the Kolmogorov distribution,
+ * Q(lambda) = 2 sum_j (-1)^(j-1) exp(-2 j^2 lambda^2).
+ */
+inline double
+KolmogorovComplement(double lambda)
+{
+    if (lambda < 1e-3)
+    {
+        return 1;
+    }
+    double sum = 0;
+    double sign = 1;
+    for (int j = 1; j <= 100; j++)
+    {
+        double term = sign * 2 * std::exp(-2 * j * j * lambda * lambda);
+        sum += term;
+        if (std::fabs(term) < 1e-12 * std::fabs(sum))
+        {
+            break;
+        }
+        sign = -sign;
+    }
+    return std::clamp(sum, 0.0, 1.0);
+}
+
+/**
+ * Two-sample Kolmogorov-Smirnov test: the statistic is the largest distance between the
+ * empirical distribution functions, its p-value the asymptotic one with the small sample
+ * correction of Stephens.
+ */
+inline TwoSampleTest
+KolmogorovSmirnovTest(std::vector<double> a, std::vector<double> b)
+{
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    double distance = 0;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.size() && j < b.size())
+    {
+        // Step over all samples equal to the smallest one left, so that ties count once
+        double value = std::min(a[i], b[j]);
+        while (i < a.size() && a[i] == value)
+        {
+            i++;
+        }
+        while (j < b.size() && b[j] == value)
+        {
+            j++;
+        }
+        distance = std::max(distance, std::fabs(double(i) / a.size() - double(j) / b.size()));
+    }
+
+    double n = double(a.size()) * b.size() / (a.size() + b.size());
+    double lambda = (std::sqrt(n) + 0.12 + 0.11 / std::sqrt(n)) * distance;
+    return {distance, KolmogorovComplement(lambda)};
+}
+
+/**
+ * Regularized incomplete beta function I_x(a, b), by the continued fraction of Lentz.
+ */
+inline double
+RegularizedIncompleteBeta(double a, double b, double x)
+{
+    if (x <= 0 || x >= 1)
+    {
+        return x <= 0 ? 0 : 1;
+    }
+    if (x > (a + 1) / (a + b + 2))
+    {
+        return 1 - RegularizedIncompleteBeta(b, a, 1 - x);
+    }
+
+    const double tiny = 1e-300;
+    double front =
+        std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) +
+                 b * std::log(1 - x)) /
+        a;
+    double c = 1;
+    double d = 1 - (a + b) * x / (a + 1);
+    d = 1 / (std::fabs(d) < tiny ? tiny : d);
+    double f = d;
+    for (int m = 1; m <= 300; m++)
+    {
+        for (int step = 0; step < 2; step++)
+        {
+            double numerator = step == 0
+                                   ? m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m))
+                                   : -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1));
+            d = 1 + numerator * d;
+            d = 1 / (std::fabs(d) < tiny ? tiny : d);
+            c = 1 + numerator / c;
+            c = std::fabs(c) < tiny ? tiny : c;
+            f *= c * d;
+        }
+        if (std::fabs(c * d - 1) < 1e-14)
+        {
+            break;
+        }
+    }
+    return front * f;
+}
+
+/**
+ * Welch's t-test of the difference of the means of two samples of at least two values
+ * each. If neither sample varies, the p-value is 1 for equal means and 0 otherwise.
+ *
+ * \return the difference of the means as the statistic, and the two-sided p-value
+ */
+inline TwoSampleTest
+WelchTest(const std::vector<double>& a, const std::vector<double>& b)
+{
+    auto moments = [](const std::vector<double>& x) {
+        double mean = std::accumulate(x.begin(), x.end(), 0.0) / x.size();
+        double squares = 0;
+        for (double value : x)
+        {
+            squares += (value - mean) * (value - mean);
+        }
+        return std::make_pair(mean, squares / (x.size() - 1) / x.size());
+    };
+    auto [meanA, errorA] = moments(a);
+    auto [meanB, errorB] = moments(b);
+    double difference = meanB - meanA;
+    double squaredError = errorA + errorB;
+    if (squaredError <= 0)
+    {
+        return {difference, difference == 0 ? 1.0 : 0.0};
+    }
+
+    double t = difference / std::sqrt(squaredError);
+    double dof = squaredError * squaredError /
+                 (errorA * errorA / (a.size() - 1) + errorB * errorB / (b.size() - 1));
+    return {difference, RegularizedIncompleteBeta(dof / 2, 0.5, dof / (dof + t * t))};
+}
+
+#endif /* EQUIVALENCE_TESTS_H */
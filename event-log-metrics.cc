@@ -0,0 +1,398 @@
+#include "event-log.h"
+
+#include "ns3/command-line.h"
+#include "ns3/core-module.h"
+#include "ns3/log.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("EventLogMetrics");
+
+/**
+ * Everything the columns are computed from, accumulated over the events of one log.
+ */
+struct RunMetrics
+{
+    EventLogHeader header;
+    std::vector<double> signal; // Signal of every received frame in dBm, sorted after decoding
+    double snrSum = 0;          // dB
+    double rssFold = 0;         // The running average the sweep reports as RSS
+    uint64_t appBytes = 0;
+    uint64_t appPackets = 0;
+    uint64_t windowBytes = 0; // Application bytes received within the window
+    uint64_t retransmissions = 0;
+    uint64_t retryLimitDrops = 0;
+    uint64_t queueDrops = 0;
+    uint64_t mcsChanges = 0;
+    std::array<uint64_t, 8> mcsHistogram{};
+    uint64_t events = 0;
+};
+
+/**
+ * A column that can be recomputed from the event logs.
+ */
+struct Column
+{
+    std::string name;
+    std::string description;
+    std::function<double(const RunMetrics&, const std::pair<double, double>&)> value;
+};
+
+/**
+ * Quantile of sorted values, interpolated linearly between the closest ranks.
+ */
+static double
+Quantile(const std::vector<double>& sorted, double q)
+{
+    if (sorted.empty())
+    {
+        return NAN;
+    }
+    double rank = q * (sorted.size() - 1);
+    size_t low = rank;
+    size_t high = std::min(low + 1, sorted.size() - 1);
+    return sorted[low] + (rank - low) * (sorted[high] - sorted[low]);
+}
+
+/**
+ * All columns the engine knows. Those that the sweep also writes are computed the same
+ * way, so that they match it: throughput counts the IPv4 and UDP headers like the flow
+ * monitor does, and rss is the same running average. Signal and noise are logged to
+ * 0.001 dB, which bounds the difference of the RSS columns.
+ */
+static std::vector<Column>
+AllColumns()
+{
+    std::vector<Column> columns = {
+        {"rss",
+         "RSS in dBm as the sweep reports it",
+         [](const RunMetrics& m, auto&) { return m.rssFold; }},
+        {"rssMean",
+         "Mean RSS in dBm",
+         [](const RunMetrics& m, auto&) {
+             double sum = 0;
+             for (double signal : m.signal)
+             {
+                 sum += signal;
+             }
+             return m.signal.empty() ? NAN : sum / m.signal.size();
+         }},
+        {"rssMedian",
+         "Median RSS in dBm",
+         [](const RunMetrics& m, auto&) { return Quantile(m.signal, 0.5); }},
+        {"rssP10",
+         "10th percentile of the RSS in dBm",
+         [](const RunMetrics& m, auto&) { return Quantile(m.signal, 0.1); }},
+        {"rssP90",
+         "90th percentile of the RSS in dBm",
+         [](const RunMetrics& m, auto&) { return Quantile(m.signal, 0.9); }},
+        {"snrMean",
+         "Mean SNR in dB",
+         [](const RunMetrics& m, auto&) {
+             return m.signal.empty() ? NAN : m.snrSum / m.signal.size();
+         }},
+        {"frames",
+         "Frames received by the server PHY",
+         [](const RunMetrics& m, auto&) { return double(m.signal.size()); }},
+        {"throughput",
+         "Throughput in Kbps as the sweep reports it, empty for TCP runs",
+         [](const RunMetrics& m, auto&) {
+             // 20 bytes of IPv4 and 8 of UDP header on top of every packet. The PacketSink
+             // of TCP receives a byte stream, whose reads do not match the segments the
+             // flow monitor counts headers for
+             if (m.header.transport == "TcpBulk")
+             {
+                 return double(NAN);
+             }
+             return (m.appBytes + 28.0 * m.appPackets) * 8.0 / m.header.simulationTime / 1024;
+         }},
+        {"goodput",
+         "Application payload received within the window in Kbps",
+         [](const RunMetrics& m, const std::pair<double, double>& window) {
+             double end = std::min(window.second, m.header.simulationTime);
+             return end > window.first ? m.windowBytes * 8.0 / (end - window.first) / 1024
+                                       : NAN;
+         }},
+        {"rxPackets",
+         "Packets received by the server application",
+         [](const RunMetrics& m, auto&) { return double(m.appPackets); }},
+        {"retransmissions",
+         "Data MPDUs sent with the Retry bit",
+         [](const RunMetrics& m, auto&) { return double(m.retransmissions); }},
+        {"retryLimitDrops",
+         "MPDUs dropped at the retry limit",
+         [](const RunMetrics& m, auto&) { return double(m.retryLimitDrops); }},
+        {"queueDrops",
+         "MPDUs dropped by the queue",
+         [](const RunMetrics& m, auto&) { return double(m.queueDrops); }},
+        {"mcsChanges",
+         "Changes of the HT MCS between data MPDUs",
+         [](const RunMetrics& m, auto&) { return double(m.mcsChanges); }},
+    };
+    for (size_t mcs = 0; mcs < RunMetrics().mcsHistogram.size(); mcs++)
+    {
+        columns.push_back({"mcs" + std::to_string(mcs),
+                           "Data MPDUs sent at HT MCS " + std::to_string(mcs),
+                           [mcs](const RunMetrics& m, auto&) {
+                               return double(m.mcsHistogram[mcs]);
+                           }});
+    }
+    return columns;
+}
+
+/**
+ * Map an event log into memory and accumulate its events.
+ *
+ * \param path the log
+ * \param windowStart start of the goodput window in seconds
+ * \param windowEnd end of the goodput window in seconds
+ * \param metrics receives the accumulated events
+ * \param bytes receives the size of the log
+ * \return whether the log could be read and is well-formed
+ */
+static bool
+DecodeRun(const std::string& path,
+          double windowStart,
+          double windowEnd,
+          RunMetrics& metrics,
+          size_t& bytes)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat status;
+    fstat(fd, &status);
+    bytes = status.st_size;
+    void* mapping = bytes ? mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+    madvise(mapping, bytes, MADV_SEQUENTIAL);
+
+    int lastMcs = -1;
+    auto accumulate = [&](const LoggedEvent& event) {
+        metrics.events++;
+        switch (event.type)
+        {
+        case PHY_RX_EVENT:
+            metrics.signal.push_back(event.signalDbm);
+            metrics.snrSum += event.signalDbm - event.noiseDbm;
+            metrics.rssFold = (event.signalDbm + metrics.rssFold) / 2;
+            break;
+        case MAC_TX_EVENT:
+            metrics.retransmissions += event.retry;
+            if (event.mcs != EVENT_LOG_NO_MCS)
+            {
+                int mcs = event.mcs;
+                if (event.mcs < metrics.mcsHistogram.size())
+                {
+                    metrics.mcsHistogram[mcs]++;
+                }
+                metrics.mcsChanges += lastMcs >= 0 && mcs != lastMcs;
+                lastMcs = mcs;
+            }
+            break;
+        case MAC_DROP_EVENT:
+            metrics.retryLimitDrops += event.dropReason == DROP_RETRY_LIMIT;
+            metrics.queueDrops += event.dropReason == DROP_QUEUE;
+            break;
+        case APP_RX_EVENT: {
+            metrics.appBytes += event.size;
+            metrics.appPackets++;
+            double time = event.timeNs * 1e-9;
+            if (time >= windowStart && time < windowEnd)
+            {
+                metrics.windowBytes += event.size;
+            }
+            break;
+        }
+        }
+    };
+    bool ok =
+        DecodeEventLog(static_cast<const uint8_t*>(mapping), bytes, metrics.header, accumulate);
+    munmap(mapping, bytes);
+    std::sort(metrics.signal.begin(), metrics.signal.end());
+    return ok;
+}
+
+/**
+ * Expand the inputs into the event logs they name: files are taken as they are,
+ * directories stand for every .evlog file in them, in name order.
+ */
+static std::vector<std::string>
+ListLogs(const std::string& inputs)
+{
+    std::vector<std::string> logs;
+    std::istringstream stream(inputs);
+    std::string input;
+    while (std::getline(stream, input, ','))
+    {
+        if (input.empty())
+        {
+            continue;
+        }
+        if (!std::filesystem::is_directory(input))
+        {
+            logs.push_back(input);
+            continue;
+        }
+        std::vector<std::string> directory;
+        for (const auto& entry : std::filesystem::directory_iterator(input))
+        {
+            if (entry.path().extension() == ".evlog")
+            {
+                directory.push_back(entry.path().string());
+            }
+        }
+        std::sort(directory.begin(), directory.end());
+        logs.insert(logs.end(), directory.begin(), directory.end());
+    }
+    return logs;
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string input = "event-logs";
+    std::string output = "output_event_metrics.csv";
+    std::string columnList;
+    unsigned threads = std::max(std::thread::hardware_concurrency(), 1U);
+    double windowStart = 0; // seconds
+    double windowEnd = -1;  // seconds, negative for the end of the run
+
+    std::vector<Column> allColumns = AllColumns();
+    std::ostringstream columnHelp;
+    columnHelp << "Comma separated columns to compute, all by default:";
+    for (const Column& column : allColumns)
+    {
+        columnHelp << "\n    " << column.name << ": " << column.description;
+    }
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("input",
+                 "Comma separated event logs, or directories of them, as written by the sweep "
+                 "with --eventLog",
+                 input);
+    cmd.AddValue("output", "Where to write one row of metrics per log", output);
+    cmd.AddValue("columns", columnHelp.str(), columnList);
+    cmd.AddValue("threads", "Number of threads decoding logs", threads);
+    cmd.AddValue("windowStart", "Start of the goodput window in seconds", windowStart);
+    cmd.AddValue("windowEnd",
+                 "End of the goodput window in seconds, negative for the end of the run",
+                 windowEnd);
+    cmd.Parse(argc, argv);
+    threads = std::max(threads, 1U);
+    if (windowEnd < 0)
+    {
+        windowEnd = INFINITY;
+    }
+
+    std::vector<const Column*> columns;
+    std::istringstream names(columnList);
+    std::string name;
+    while (std::getline(names, name, ','))
+    {
+        auto column = std::find_if(allColumns.begin(),
+                                   allColumns.end(),
+                                   [&name](const Column& c) { return c.name == name; });
+        NS_ABORT_MSG_IF(column == allColumns.end(), "Unknown column " << name);
+        columns.push_back(&*column);
+    }
+    if (columns.empty())
+    {
+        for (const Column& column : allColumns)
+        {
+            columns.push_back(&column);
+        }
+    }
+
+    std::vector<std::string> logs = ListLogs(input);
+    NS_ABORT_MSG_IF(logs.empty(), "No event logs in " << input);
+
+    // Logs differ a lot in size, so threads take the next one as they finish instead of
+    // splitting the list up front
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> rows(logs.size());
+    std::atomic<size_t> next{0};
+    std::atomic<uint64_t> totalBytes{0};
+    std::atomic<uint64_t> totalEvents{0};
+    std::vector<std::thread> workers;
+    auto work = [&]() {
+        for (size_t i = next++; i < logs.size(); i = next++)
+        {
+            RunMetrics metrics;
+            size_t bytes = 0;
+            NS_ABORT_MSG_IF(!DecodeRun(logs[i], windowStart, windowEnd, metrics, bytes),
+                            "Cannot read " << logs[i]);
+            totalBytes += bytes;
+            totalEvents += metrics.events;
+
+            std::ostringstream row;
+            row << std::setprecision(10) << logs[i] << "," << metrics.header.request << ","
+                << metrics.header.config;
+            for (const Column* column : columns)
+            {
+                // Values a run does not have are left empty
+                double value = column->value(metrics, {windowStart, windowEnd});
+                row << ",";
+                if (!std::isnan(value))
+                {
+                    row << value;
+                }
+            }
+            rows[i] = row.str();
+        }
+    };
+    for (unsigned thread = 1; thread < threads; thread++)
+    {
+        workers.emplace_back(work);
+    }
+    work();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::ofstream file(output);
+    file << "log,request,config";
+    for (const Column* column : columns)
+    {
+        file << "," << column->name;
+    }
+    file << "\n";
+    for (const std::string& row : rows)
+    {
+        file << row << "\n";
+    }
+    NS_ABORT_MSG_IF(!file, "Cannot write " << output);
+
+    NS_LOG_UNCOND("Decoded " << totalEvents << " events of " << logs.size() << " logs ("
+                             << totalBytes / 1e6 << " MB) in " << seconds << " s, "
+                             << totalBytes / 1e6 / seconds << " MB/s");
+    return 0;
+}
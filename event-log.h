@@ -0,0 +1,320 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * Kinds of events in an event log.
+ */
+enum EventLogType : uint8_t
+{
+    PHY_RX_EVENT = 1, //!< A frame received by the server PHY
+    MAC_TX_EVENT,     //!< A data MPDU sent by any MAC
+    MAC_DROP_EVENT,   //!< An MPDU dropped by any MAC
+    APP_RX_EVENT      //!< A packet received by the server application
+};
+
+/**
+ * Why an MPDU was dropped, as far as the metrics distinguish it.
+ */
+enum EventLogDropReason : uint8_t
+{
+    DROP_RETRY_LIMIT, //!< Reached the retry limit
+    DROP_QUEUE,       //!< Failed to enqueue, or its lifetime expired
+    DROP_OTHER        //!< Any other reason
+};
+
+/// MCS of frames that are not HT
+constexpr uint32_t EVENT_LOG_NO_MCS = 255;
+
+/**
+ * One decoded event. Only the fields of its type are set.
+ */
+struct LoggedEvent
+{
+    EventLogType type;  //!< Kind of the event
+    uint64_t timeNs;    //!< Simulation time in nanoseconds
+    double signalDbm;   //!< PHY_RX: signal power, to 0.001 dB
+    double noiseDbm;    //!< PHY_RX: noise power, to 0.001 dB
+    uint32_t mcs;       //!< PHY_RX and MAC_TX: HT MCS, or EVENT_LOG_NO_MCS
+    uint32_t size;      //!< PHY_RX, MAC_TX and APP_RX: bytes
+    bool retry;         //!< MAC_TX: the Retry bit
+    uint8_t dropReason; //!< MAC_DROP: an EventLogDropReason
+};
+
+/**
+ * What an event log was recorded for.
+ */
+struct EventLogHeader
+{
+    std::string request;   //!< The sweep point, as a server request
+    std::string config;    //!< Hash of the scenario configuration
+    std::string transport; //!< UdpCbr, UdpSaturating or TcpBulk
+    double simulationTime; //!< Simulated seconds
+};
+
+/**
+ * Writes the events of one simulation run to a compact binary log.
+ *
+ * The file starts with the magic "EVLG", a version byte, the request, the configuration
+ * hash and the transport, each as its length as a varint and its characters, and the
+ * simulation time as a native double. Every event follows as its type byte and the
+ * nanoseconds since the previous event as a LEB128 varint, then its fields as varints.
+ * Signal and noise are stored in units of 0.001 dB as zigzag varints of the difference to
+ * the previous frame, which mostly fits in one or two bytes, so that a received frame
+ * takes about 8 bytes instead of the 40 of its fields.
+ */
+class EventLogWriter
+{
+  public:
+    /**
+     * Create the log and write its header.
+     *
+     * \param path the file, replaced if it exists
+     * \param header what the log is recorded for
+     */
+    EventLogWriter(const std::string& path, const EventLogHeader& header)
+        : m_fd(open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644))
+    {
+        m_buffer.insert(m_buffer.end(), {'E', 'V', 'L', 'G', VERSION});
+        for (const std::string* text : {&header.request, &header.config, &header.transport})
+        {
+            PutVarint(text->size());
+            m_buffer.insert(m_buffer.end(), text->begin(), text->end());
+        }
+        const uint8_t* time = reinterpret_cast<const uint8_t*>(&header.simulationTime);
+        m_buffer.insert(m_buffer.end(), time, time + sizeof(double));
+    }
+
+    ~EventLogWriter()
+    {
+        Flush();
+        if (m_fd >= 0)
+        {
+            close(m_fd);
+        }
+    }
+
+    EventLogWriter(const EventLogWriter&) = delete;
+    EventLogWriter& operator=(const EventLogWriter&) = delete;
+
+    /**
+     * \return whether the file could be created and everything has been written so far
+     */
+    bool Ok() const
+    {
+        return m_fd >= 0 && !m_failed;
+    }
+
+    void PhyRx(uint64_t timeNs, double signalDbm, double noiseDbm, uint32_t mcs, uint32_t size)
+    {
+        Begin(PHY_RX_EVENT, timeNs);
+        int64_t signal = std::llround(signalDbm * 1000);
+        int64_t noise = std::llround(noiseDbm * 1000);
+        PutSigned(signal - m_lastSignal);
+        PutSigned(noise - m_lastNoise);
+        m_lastSignal = signal;
+        m_lastNoise = noise;
+        PutVarint(mcs);
+        PutVarint(size);
+    }
+
+    void MacTx(uint64_t timeNs, bool retry, uint32_t mcs, uint32_t size)
+    {
+        Begin(MAC_TX_EVENT, timeNs);
+        PutVarint(retry);
+        PutVarint(mcs);
+        PutVarint(size);
+    }
+
+    void MacDrop(uint64_t timeNs, EventLogDropReason reason)
+    {
+        Begin(MAC_DROP_EVENT, timeNs);
+        PutVarint(reason);
+    }
+
+    void AppRx(uint64_t timeNs, uint32_t size)
+    {
+        Begin(APP_RX_EVENT, timeNs);
+        PutVarint(size);
+    }
+
+    /**
+     * Write the buffered events to the file.
+     */
+    void Flush()
+    {
+        size_t written = 0;
+        while (m_fd >= 0 && written < m_buffer.size())
+        {
+            ssize_t n = write(m_fd, m_buffer.data() + written, m_buffer.size() - written);
+            if (n < 0)
+            {
+                m_failed = true;
+                break;
+            }
+            written += n;
+        }
+        m_buffer.clear();
+    }
+
+    static constexpr uint8_t VERSION = 1; //!< Version of the file format
+
+  private:
+    void Begin(EventLogType type, uint64_t timeNs)
+    {
+        if (m_buffer.size() > FLUSH_SIZE)
+        {
+            Flush();
+        }
+        m_buffer.push_back(type);
+        PutVarint(timeNs - m_lastTime);
+        m_lastTime = timeNs;
+    }
+
+    void PutVarint(uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            m_buffer.push_back(uint8_t(value) | 0x80);
+            value >>= 7;
+        }
+        m_buffer.push_back(uint8_t(value));
+    }
+
+    void PutSigned(int64_t value)
+    {
+        PutVarint((uint64_t(value) << 1) ^ uint64_t(value >> 63));
+    }
+
+    static constexpr size_t FLUSH_SIZE = 1 << 16; //!< Buffered bytes that trigger a write
+
+    int m_fd;                      //!< The log file
+    bool m_failed = false;         //!< Whether a write failed
+    std::vector<uint8_t> m_buffer; //!< Events not written yet
+    uint64_t m_lastTime = 0;       //!< Time of the previous event
+    int64_t m_lastSignal = 0;      //!< Signal of the previous frame in 0.001 dB
+    int64_t m_lastNoise = 0;       //!< Noise of the previous frame in 0.001 dB
+};
+
+/**
+ * Decode an event log held in memory, see EventLogWriter for the format.
+ *
+ * \param data the log
+ * \param size its size
+ * \param header receives its header
+ * \param handle called with every event, in order
+ * \return whether the log is well-formed; a truncated log is decoded up to its last
+ *         complete event and reported as malformed
+ */
+template <typename Handler>
+inline bool
+DecodeEventLog(const uint8_t* data, size_t size, EventLogHeader& header, Handler&& handle)
+{
+    const uint8_t* position = data;
+    const uint8_t* end = data + size;
+    auto getVarint = [&position, end](uint64_t& value) {
+        value = 0;
+        for (int shift = 0; position < end && shift < 64; shift += 7)
+        {
+            uint8_t byte = *position++;
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto getSigned = [&getVarint](int64_t& value) {
+        uint64_t raw;
+        bool ok = getVarint(raw);
+        value = int64_t(raw >> 1) ^ -int64_t(raw & 1);
+        return ok;
+    };
+
+    if (size < 5 || std::memcmp(data, "EVLG", 4) != 0 || data[4] != EventLogWriter::VERSION)
+    {
+        return false;
+    }
+    position += 5;
+    for (std::string* text : {&header.request, &header.config, &header.transport})
+    {
+        uint64_t length;
+        if (!getVarint(length) || uint64_t(end - position) < length)
+        {
+            return false;
+        }
+        text->assign(reinterpret_cast<const char*>(position), length);
+        position += length;
+    }
+    if (end - position < std::ptrdiff_t(sizeof(double)))
+    {
+        return false;
+    }
+    std::memcpy(&header.simulationTime, position, sizeof(double));
+    position += sizeof(double);
+
+    LoggedEvent event{};
+    int64_t signal = 0;
+    int64_t noise = 0;
+    while (position < end)
+    {
+        event.type = EventLogType(*position++);
+        uint64_t delta = 0;
+        uint64_t a = 0;
+        uint64_t b = 0;
+        bool ok = getVarint(delta);
+        event.timeNs += delta;
+        switch (event.type)
+        {
+        case PHY_RX_EVENT: {
+            int64_t signalDelta = 0;
+            int64_t noiseDelta = 0;
+            ok = ok && getSigned(signalDelta) && getSigned(noiseDelta) && getVarint(a) &&
+                 getVarint(b);
+            signal += signalDelta;
+            noise += noiseDelta;
+            event.signalDbm = signal / 1000.0;
+            event.noiseDbm = noise / 1000.0;
+            event.mcs = a;
+            event.size = b;
+            break;
+        }
+        case MAC_TX_EVENT: {
+            uint64_t retry = 0;
+            ok = ok && getVarint(retry) && getVarint(a) && getVarint(b);
+            event.retry = retry;
+            event.mcs = a;
+            event.size = b;
+            break;
+        }
+        case MAC_DROP_EVENT:
+            ok = ok && getVarint(a);
+            event.dropReason = a;
+            break;
+        case APP_RX_EVENT:
+            ok = ok && getVarint(a);
+            event.size = a;
+            break;
+        default:
+            return false;
+        }
+        if (!ok)
+        {
+            return false;
+        }
+        handle(event);
+    }
+    return true;
+}
+
+#endif /* EVENT_LOG_H */
@@ -0,0 +1,337 @@
+#ifndef FAST_PROPAGATION_LOSS_MODELS_H
+#define FAST_PROPAGATION_LOSS_MODELS_H
+
+#include "fast-math.h"
+
+#include "ns3/double.h"
+#include "ns3/mobility-model.h"
+#include "ns3/propagation-loss-model.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace ns3
+{
+
+/**
+ * Squared distance between two nodes, which the fast models take the logarithm of
+ * directly instead of the square root.
+ */
+inline double
+SquaredDistance(Ptr<MobilityModel> a, Ptr<MobilityModel> b)
+{
+    Vector d = a->GetPosition() - b->GetPosition();
+    return d.x * d.x + d.y * d.y + d.z * d.z;
+}
+
+/**
+ * ns3::FriisPropagationLossModel with FastLog10 instead of log10, within
+ * FAST_MATH_MAX_ERROR_DB of it. It has the same attributes.
+ */
+class FastFriisPropagationLossModel : public PropagationLossModel
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+  private:
+    double DoCalcRxPower(double txPowerDbm,
+                         Ptr<MobilityModel> a,
+                         Ptr<MobilityModel> b) const override;
+    int64_t DoAssignStreams(int64_t stream) override;
+
+    double m_frequency;  //!< Frequency in Hz
+    double m_systemLoss; //!< System loss, linear
+    double m_minLoss;    //!< Minimum loss in dB
+
+    mutable std::array<double, 2> m_cacheKey{}; //!< Frequency and system loss of m_offsetDb
+    mutable double m_offsetDb = 0;              //!< 10 log10(16 pi^2 L / lambda^2)
+};
+
+/**
+ * ns3::TwoRayGroundPropagationLossModel with FastLog10 instead of log10, within
+ * FAST_MATH_MAX_ERROR_DB of it. It has the same attributes.
+ */
+class FastTwoRayGroundPropagationLossModel : public PropagationLossModel
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+  private:
+    double DoCalcRxPower(double txPowerDbm,
+                         Ptr<MobilityModel> a,
+                         Ptr<MobilityModel> b) const override;
+    int64_t DoAssignStreams(int64_t stream) override;
+
+    double m_frequency;    //!< Frequency in Hz
+    double m_systemLoss;   //!< System loss, linear
+    double m_minDistance;  //!< Distance below which there is no loss
+    double m_heightAboveZ; //!< Antenna height above the node
+
+    mutable std::array<double, 2> m_cacheKey{}; //!< Frequency and system loss of the offsets
+    mutable double m_lambda = 0;                //!< Wavelength
+    mutable double m_friisOffsetDb = 0;         //!< 10 log10(16 pi^2 L / lambda^2)
+    mutable double m_systemLossDb = 0;          //!< 10 log10(L)
+};
+
+/**
+ * ns3::ThreeLogDistancePropagationLossModel with FastLog10 instead of log10, within
+ * FAST_MATH_MAX_ERROR_DB of it. It has the same attributes.
+ */
+class FastThreeLogDistancePropagationLossModel : public PropagationLossModel
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+  private:
+    double DoCalcRxPower(double txPowerDbm,
+                         Ptr<MobilityModel> a,
+                         Ptr<MobilityModel> b) const override;
+    int64_t DoAssignStreams(int64_t stream) override;
+
+    double m_distance0;     //!< Start of the first segment
+    double m_distance1;     //!< Start of the second segment
+    double m_distance2;     //!< Start of the third segment
+    double m_exponent0;     //!< Path loss exponent of the first segment
+    double m_exponent1;     //!< Path loss exponent of the second segment
+    double m_exponent2;     //!< Path loss exponent of the third segment
+    double m_referenceLoss; //!< Path loss at distance0 in dB
+
+    mutable std::array<double, 3> m_cacheKey{};   //!< Distances of the cached logarithms
+    mutable std::array<double, 3> m_logDistance{}; //!< log10 of the distances
+};
+
+NS_OBJECT_ENSURE_REGISTERED(FastFriisPropagationLossModel);
+NS_OBJECT_ENSURE_REGISTERED(FastTwoRayGroundPropagationLossModel);
+NS_OBJECT_ENSURE_REGISTERED(FastThreeLogDistancePropagationLossModel);
+
+inline TypeId
+FastFriisPropagationLossModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::FastFriisPropagationLossModel")
+            .SetParent<PropagationLossModel>()
+            .SetGroupName("Propagation")
+            .AddConstructor<FastFriisPropagationLossModel>()
+            .AddAttribute("Frequency",
+                          "The carrier frequency (in Hz) at which propagation occurs.",
+                          DoubleValue(5.150e9),
+                          MakeDoubleAccessor(&FastFriisPropagationLossModel::m_frequency),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("SystemLoss",
+                          "The system loss (linear factor >= 1, not in dB)",
+                          DoubleValue(1.0),
+                          MakeDoubleAccessor(&FastFriisPropagationLossModel::m_systemLoss),
+                          MakeDoubleChecker<double>(1.0))
+            .AddAttribute("MinLoss",
+                          "The minimum value (dB) of the total loss, used at short ranges.",
+                          DoubleValue(0.0),
+                          MakeDoubleAccessor(&FastFriisPropagationLossModel::m_minLoss),
+                          MakeDoubleChecker<double>());
+    return tid;
+}
+
+inline double
+FastFriisPropagationLossModel::DoCalcRxPower(double txPowerDbm,
+                                             Ptr<MobilityModel> a,
+                                             Ptr<MobilityModel> b) const
+{
+    if (m_cacheKey != std::array<double, 2>{m_frequency, m_systemLoss})
+    {
+        double lambda = 299792458.0 / m_frequency;
+        m_offsetDb = 10 * std::log10(16 * M_PI * M_PI * m_systemLoss / (lambda * lambda));
+        m_cacheKey = {m_frequency, m_systemLoss};
+    }
+    double squaredDistance = SquaredDistance(a, b);
+    if (squaredDistance <= 0)
+    {
+        return txPowerDbm - m_minLoss;
+    }
+    double lossDb = m_offsetDb + 10 * FastLog10(squaredDistance);
+    return txPowerDbm - std::max(lossDb, m_minLoss);
+}
+
+inline int64_t
+FastFriisPropagationLossModel::DoAssignStreams(int64_t stream)
+{
+    return 0;
+}
+
+inline TypeId
+FastTwoRayGroundPropagationLossModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::FastTwoRayGroundPropagationLossModel")
+            .SetParent<PropagationLossModel>()
+            .SetGroupName("Propagation")
+            .AddConstructor<FastTwoRayGroundPropagationLossModel>()
+            .AddAttribute("Frequency",
+                          "The carrier frequency (in Hz) at which propagation occurs.",
+                          DoubleValue(5.150e9),
+                          MakeDoubleAccessor(&FastTwoRayGroundPropagationLossModel::m_frequency),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("SystemLoss",
+                          "The system loss (linear factor >= 1, not in dB)",
+                          DoubleValue(1.0),
+                          MakeDoubleAccessor(&FastTwoRayGroundPropagationLossModel::m_systemLoss),
+                          MakeDoubleChecker<double>(1.0))
+            .AddAttribute("MinDistance",
+                          "The distance under which the propagation model refuses to give results "
+                          "(m)",
+                          DoubleValue(0.5),
+                          MakeDoubleAccessor(&FastTwoRayGroundPropagationLossModel::m_minDistance),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("HeightAboveZ",
+                          "The height of the antenna (m) above the node's Z coordinate",
+                          DoubleValue(0),
+                          MakeDoubleAccessor(&FastTwoRayGroundPropagationLossModel::m_heightAboveZ),
+                          MakeDoubleChecker<double>());
+    return tid;
+}
+
+inline double
+FastTwoRayGroundPropagationLossModel::DoCalcRxPower(double txPowerDbm,
+                                                    Ptr<MobilityModel> a,
+                                                    Ptr<MobilityModel> b) const
+{
+    if (m_cacheKey != std::array<double, 2>{m_frequency, m_systemLoss})
+    {
+        m_lambda = 299792458.0 / m_frequency;
+        m_friisOffsetDb =
+            10 * std::log10(16 * M_PI * M_PI * m_systemLoss / (m_lambda * m_lambda));
+        m_systemLossDb = 10 * std::log10(m_systemLoss);
+        m_cacheKey = {m_frequency, m_systemLoss};
+    }
+
+    double squaredDistance = SquaredDistance(a, b);
+    if (squaredDistance <= m_minDistance * m_minDistance)
+    {
+        return txPowerDbm;
+    }
+
+    double txAntHeight = a->GetPosition().z + m_heightAboveZ;
+    double rxAntHeight = b->GetPosition().z + m_heightAboveZ;
+    double dCross = (4 * M_PI * txAntHeight * rxAntHeight) / m_lambda;
+    if (dCross >= 0 && squaredDistance <= dCross * dCross)
+    {
+        return txPowerDbm - m_friisOffsetDb - 10 * FastLog10(squaredDistance);
+    }
+    double heights = txAntHeight * rxAntHeight;
+    return txPowerDbm - m_systemLossDb +
+           10 * FastLog10(heights * heights / (squaredDistance * squaredDistance));
+}
+
+inline int64_t
+FastTwoRayGroundPropagationLossModel::DoAssignStreams(int64_t stream)
+{
+    return 0;
+}
+
+inline TypeId
+FastThreeLogDistancePropagationLossModel::GetTypeId()
+{
+    using Model = FastThreeLogDistancePropagationLossModel;
+    static TypeId tid =
+        TypeId("ns3::FastThreeLogDistancePropagationLossModel")
+            .SetParent<PropagationLossModel>()
+            .SetGroupName("Propagation")
+            .AddConstructor<Model>()
+            .AddAttribute("Distance0",
+                          "Beginning of the first (near) distance field",
+                          DoubleValue(1.0),
+                          MakeDoubleAccessor(&Model::m_distance0),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("Distance1",
+                          "Beginning of the second (middle) distance field.",
+                          DoubleValue(200.0),
+                          MakeDoubleAccessor(&Model::m_distance1),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("Distance2",
+                          "Beginning of the third (far) distance field.",
+                          DoubleValue(500.0),
+                          MakeDoubleAccessor(&Model::m_distance2),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("Exponent0",
+                          "The exponent for the first field.",
+                          DoubleValue(1.9),
+                          MakeDoubleAccessor(&Model::m_exponent0),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("Exponent1",
+                          "The exponent for the second field.",
+                          DoubleValue(3.8),
+                          MakeDoubleAccessor(&Model::m_exponent1),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("Exponent2",
+                          "The exponent for the third field.",
+                          DoubleValue(3.8),
+                          MakeDoubleAccessor(&Model::m_exponent2),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("ReferenceLoss",
+                          "The reference loss at distance d0 (dB). (Default is Friis at 1m with "
+                          "5.15 GHz)",
+                          DoubleValue(46.6777),
+                          MakeDoubleAccessor(&Model::m_referenceLoss),
+                          MakeDoubleChecker<double>());
+    return tid;
+}
+
+inline double
+FastThreeLogDistancePropagationLossModel::DoCalcRxPower(double txPowerDbm,
+                                                        Ptr<MobilityModel> a,
+                                                        Ptr<MobilityModel> b) const
+{
+    if (m_cacheKey != std::array<double, 3>{m_distance0, m_distance1, m_distance2})
+    {
+        m_logDistance = {std::log10(m_distance0),
+                         std::log10(m_distance1),
+                         std::log10(m_distance2)};
+        m_cacheKey = {m_distance0, m_distance1, m_distance2};
+    }
+
+    double squaredDistance = SquaredDistance(a, b);
+    if (squaredDistance < m_distance0 * m_distance0)
+    {
+        return txPowerDbm;
+    }
+    // log10 of the distance, without taking the square root first
+    double logDistance = 0.5 * FastLog10(squaredDistance);
+    double pathLossDb;
+    if (squaredDistance < m_distance1 * m_distance1)
+    {
+        pathLossDb = m_referenceLoss + 10 * m_exponent0 * (logDistance - m_logDistance[0]);
+    }
+    else if (squaredDistance < m_distance2 * m_distance2)
+    {
+        pathLossDb = m_referenceLoss + 10 * m_exponent0 * (m_logDistance[1] - m_logDistance[0]) +
+                     10 * m_exponent1 * (logDistance - m_logDistance[1]);
+    }
+    else
+    {
+        pathLossDb = m_referenceLoss + 10 * m_exponent0 * (m_logDistance[1] - m_logDistance[0]) +
+                     10 * m_exponent1 * (m_logDistance[2] - m_logDistance[1]) +
+                     10 * m_exponent2 * (logDistance - m_logDistance[2]);
+    }
+    return txPowerDbm - pathLossDb;
+}
+
+inline int64_t
+FastThreeLogDistancePropagationLossModel::DoAssignStreams(int64_t stream)
+{
+    return 0;
+}
+
+} // namespace ns3
+
+#endif /* FAST_PROPAGATION_LOSS_MODELS_H */
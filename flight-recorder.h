@@ -0,0 +1,306 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/pcap-file-wrapper.h"
+#include "ns3/radiotap-header.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-helper.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/wifi-phy-common.h"
+#include "ns3/wifi-tx-vector.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/// Shortest stall trigger in seconds; the stall check polls at half of it
+constexpr double FLIGHT_RECORDER_MIN_STALL = 1e-3;
+
+/**
+ * When the flight recorder dumps its rings. A trigger is off when its threshold is zero.
+ */
+struct FlightRecorderTriggers
+{
+    double stall = 0;      //!< Seconds without an application packet while the client sends
+    double rssOutlier = 0; //!< dB a frame may deviate from the running mean RSS
+    bool lost = false;     //!< Whether a run that ends without any packet received triggers
+    uint32_t frames = 256; //!< Frames kept per node, rounded up to a power of two
+};
+
+/**
+ * Parse triggers from comma separated stall:<seconds>, rss:<dB>, lost and frames:<count>.
+ * A stall shorter than FLIGHT_RECORDER_MIN_STALL is rejected, as its check would poll
+ * faster than the time resolution.
+ *
+ * \param text the triggers
+ * \param triggers receives them
+ * \param error receives a description of what is wrong with the text
+ * \return whether the text is valid
+ */
+inline bool
+ParseFlightRecorderTriggers(const std::string& text,
+                            FlightRecorderTriggers& triggers,
+                            std::string& error)
+{
+    std::istringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        size_t colon = item.find(':');
+        std::string key = item.substr(0, colon);
+        double value = 0;
+        if (colon != std::string::npos)
+        {
+            std::istringstream number(item.substr(colon + 1));
+            if (!(number >> value) || !number.eof() || value <= 0)
+            {
+                error = "Invalid flight recorder trigger " + item;
+                return false;
+            }
+        }
+        if (key == "lost" && colon == std::string::npos)
+        {
+            triggers.lost = true;
+        }
+        else if (key == "stall" && value >= FLIGHT_RECORDER_MIN_STALL)
+        {
+            triggers.stall = value;
+        }
+        else if (key == "rss" && value > 0)
+        {
+            triggers.rssOutlier = value;
+        }
+        else if (key == "frames" && value >= 1)
+        {
+            triggers.frames = value;
+        }
+        else
+        {
+            error = "Invalid flight recorder trigger " + item;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Always-on record of the most recent frames each node sent and received, and of the
+ * MPDUs its MAC dropped, to look at what led up to an anomaly without tracing every
+ * frame of a sweep.
+ *
+ * Every node has a ring of a fixed number of slots that is allocated up front. Recording
+ * a frame overwrites the oldest slot: it keeps a reference to the packet instead of a
+ * copy and assigns a few fields, so the cost per frame is a handful of stores and no
+ * allocation. Only Dump writes anything: a pcap file per node with a radiotap header on
+ * every frame, readable by Wireshark, and a metadata file.
+ */
+class FlightRecorder
+{
+  public:
+    /**
+     * \param nodes the number of nodes
+     * \param frames the frames kept per node, rounded up to a power of two
+     */
+    FlightRecorder(uint32_t nodes, uint32_t frames)
+    {
+        uint32_t capacity = 1;
+        while (capacity < frames)
+        {
+            capacity <<= 1;
+        }
+        m_nodes.resize(nodes);
+        for (NodeRing& ring : m_nodes)
+        {
+            ring.frames.resize(capacity);
+            ring.drops.resize(capacity);
+        }
+    }
+
+    void RecordTx(uint32_t node,
+                  Ptr<const Packet> packet,
+                  uint16_t channelFreqMhz,
+                  const WifiTxVector& txVector)
+    {
+        Frame& frame = NextFrame(node);
+        frame.tx = true;
+        frame.packet = packet;
+        frame.channelFreqMhz = channelFreqMhz;
+        frame.txVector = txVector;
+    }
+
+    void RecordRx(uint32_t node,
+                  Ptr<const Packet> packet,
+                  uint16_t channelFreqMhz,
+                  const WifiTxVector& txVector,
+                  SignalNoiseDbm signalNoise)
+    {
+        Frame& frame = NextFrame(node);
+        frame.tx = false;
+        frame.packet = packet;
+        frame.channelFreqMhz = channelFreqMhz;
+        frame.txVector = txVector;
+        frame.signalNoise = signalNoise;
+    }
+
+    void RecordDrop(uint32_t node, WifiMacDropReason reason)
+    {
+        NodeRing& ring = m_nodes[node];
+        ring.drops[ring.dropCount++ & (ring.drops.size() - 1)] = {Simulator::Now(), reason};
+    }
+
+    /**
+     * Write the rings to <prefix>_node<N>.pcap, oldest frame first, and <prefix>.txt with
+     * the reason, the given description of the run and the dropped MPDUs.
+     *
+     * \param prefix the prefix of the files
+     * \param reason what triggered the dump
+     * \param description lines describing the run
+     */
+    void Dump(const std::string& prefix,
+              const std::string& reason,
+              const std::string& description) const
+    {
+        std::ofstream metadata(prefix + ".txt");
+        metadata << "reason " << reason << "\n"
+                 << "time " << Simulator::Now().GetSeconds() << "\n"
+                 << description;
+
+        PcapHelper pcapHelper;
+        for (uint32_t node = 0; node < m_nodes.size(); node++)
+        {
+            const NodeRing& ring = m_nodes[node];
+            std::string fileName = prefix + "_node" + std::to_string(node) + ".pcap";
+            Ptr<PcapFileWrapper> file =
+                pcapHelper.CreateFile(fileName, std::ios::out, PcapHelper::DLT_IEEE802_11_RADIO);
+            uint64_t size = ring.frames.size();
+            for (uint64_t i = ring.frameCount > size ? ring.frameCount - size : 0;
+                 i < ring.frameCount;
+                 i++)
+            {
+                const Frame& frame = ring.frames[i & (size - 1)];
+                Ptr<Packet> packet = frame.packet->Copy();
+                packet->AddHeader(RadiotapFor(frame));
+                file->Write(frame.time, packet);
+            }
+            metadata << "node " << node << " frames " << ring.frameCount << " kept "
+                     << std::min(ring.frameCount, size) << " pcap " << fileName << "\n";
+
+            size = ring.drops.size();
+            for (uint64_t i = ring.dropCount > size ? ring.dropCount - size : 0;
+                 i < ring.dropCount;
+                 i++)
+            {
+                const Drop& drop = ring.drops[i & (size - 1)];
+                metadata << "drop node " << node << " time " << drop.time.GetSeconds()
+                         << " reason " << DropReasonName(drop.reason) << "\n";
+            }
+        }
+    }
+
+  private:
+    /// A frame as the PHY sent or received it
+    struct Frame
+    {
+        Time time;
+        bool tx;
+        Ptr<const Packet> packet;
+        uint16_t channelFreqMhz;
+        WifiTxVector txVector;
+        SignalNoiseDbm signalNoise; // Received frames only
+    };
+
+    /// An MPDU the MAC dropped
+    struct Drop
+    {
+        Time time;
+        WifiMacDropReason reason;
+    };
+
+    /// The rings of one node; the counts only grow and are masked into slot indices
+    struct NodeRing
+    {
+        std::vector<Frame> frames;
+        uint64_t frameCount = 0;
+        std::vector<Drop> drops;
+        uint64_t dropCount = 0;
+    };
+
+    static const char* DropReasonName(WifiMacDropReason reason)
+    {
+        switch (reason)
+        {
+        case WIFI_MAC_DROP_FAILED_ENQUEUE:
+            return "failedEnqueue";
+        case WIFI_MAC_DROP_EXPIRED_LIFETIME:
+            return "expiredLifetime";
+        case WIFI_MAC_DROP_REACHED_RETRY_LIMIT:
+            return "retryLimit";
+        default:
+            return "other";
+        }
+    }
+
+    Frame& NextFrame(uint32_t node)
+    {
+        NodeRing& ring = m_nodes[node];
+        Frame& frame = ring.frames[ring.frameCount++ & (ring.frames.size() - 1)];
+        frame.time = Simulator::Now();
+        return frame;
+    }
+
+    /**
+     * The radiotap header of a frame, built like the one of the wifi pcap traces but only
+     * with the fields every PHY of the sweep fills in.
+     */
+    static RadiotapHeader RadiotapFor(const Frame& frame)
+    {
+        RadiotapHeader header;
+        header.SetTsft(frame.time.GetMicroSeconds());
+        header.SetFrameFlags(RadiotapHeader::FRAME_FLAG_FCS_INCLUDED);
+        uint16_t channelFlags = RadiotapHeader::CHANNEL_FLAG_OFDM |
+                                (frame.channelFreqMhz < 2500
+                                     ? RadiotapHeader::CHANNEL_FLAG_SPECTRUM_2GHZ
+                                     : RadiotapHeader::CHANNEL_FLAG_SPECTRUM_5GHZ);
+        header.SetChannelFields(frame.channelFreqMhz, channelFlags);
+
+        WifiMode mode = frame.txVector.GetMode();
+        if (mode.GetModulationClass() == WIFI_MOD_CLASS_HT)
+        {
+            uint8_t known = RadiotapHeader::MCS_KNOWN_BANDWIDTH | RadiotapHeader::MCS_KNOWN_INDEX |
+                            RadiotapHeader::MCS_KNOWN_GUARD_INTERVAL;
+            uint8_t flags = frame.txVector.GetChannelWidth() == 40
+                                ? RadiotapHeader::MCS_FLAGS_BANDWIDTH_40
+                                : RadiotapHeader::MCS_FLAGS_BANDWIDTH_20;
+            if (frame.txVector.GetGuardInterval() == 400)
+            {
+                flags |= RadiotapHeader::MCS_FLAGS_GUARD_INTERVAL;
+            }
+            header.SetMcsFields(known, flags, mode.GetMcsValue());
+        }
+        else
+        {
+            header.SetRate(mode.GetDataRate(frame.txVector) / 500000);
+        }
+
+        if (!frame.tx)
+        {
+            header.SetAntennaSignalPower(frame.signalNoise.signal);
+            header.SetAntennaNoisePower(frame.signalNoise.noise);
+        }
+        return header;
+    }
+
+    std::vector<NodeRing> m_nodes; //!< The rings of every node
+};
+
+} // namespace ns3
+
+#endif /* FLIGHT_RECORDER_H */
@@ -0,0 +1,141 @@
+#ifndef LOSS_PARAMETERS_H
+#define LOSS_PARAMETERS_H
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Parameters of the propagation loss models of the sweep. The defaults are the textbook
+ * values the sweep has always used; the exponents of ThreeLogDistance are those of ns-3.
+ */
+struct LossParameters
+{
+    double friisFrequency = 5.18e9; // Hz
+    double friisSystemLoss = 1;     // linear
+
+    double fixedRss = -75; // dBm
+
+    double threeLogDistance0 = 1;         // meters
+    double threeLogDistance1 = 100;       // meters
+    double threeLogDistance2 = 500;       // meters
+    double threeLogExponent0 = 1.9;       // Path loss exponent from Distance0
+    double threeLogExponent1 = 3.8;       // Path loss exponent from Distance1
+    double threeLogExponent2 = 3.8;       // Path loss exponent from Distance2
+    double threeLogReferenceLoss = 46.77; // dB at Distance0
+
+    double twoRayFrequency = 5.18e9; // Hz
+    double twoRaySystemLoss = 1;     // linear
+    double twoRayMinDistance = 0.5;  // meters
+
+    double nakagamiDistance1 = 80;  // meters
+    double nakagamiDistance2 = 200; // meters
+    double nakagamiM0 = 1.5;        // Shape below Distance1
+    double nakagamiM1 = 0.75;       // Shape from Distance1
+    double nakagamiM2 = 0.75;       // Shape from Distance2
+
+    /**
+     * \return every parameter with its key, <model>.<ns-3 attribute>
+     */
+    std::vector<std::pair<std::string, double*>> Fields()
+    {
+        return FieldsOf(*this);
+    }
+
+    /**
+     * \return every parameter with its key, <model>.<ns-3 attribute>
+     */
+    std::vector<std::pair<std::string, const double*>> Fields() const
+    {
+        return FieldsOf(*this);
+    }
+
+    /**
+     * \return the parameters as "key=value" lines
+     */
+    std::string ToString() const
+    {
+        std::ostringstream text;
+        text << std::setprecision(17);
+        for (const auto& [key, value] : Fields())
+        {
+            text << key << "=" << *value << "\n";
+        }
+        return text.str();
+    }
+
+  private:
+    template <typename Parameters>
+    static std::vector<std::pair<std::string, decltype(&std::declval<Parameters&>().fixedRss)>>
+    FieldsOf(Parameters& p)
+    {
+        return {{"Friis.Frequency", &p.friisFrequency},
+                {"Friis.SystemLoss", &p.friisSystemLoss},
+                {"FixedRSS.Rss", &p.fixedRss},
+                {"ThreeLogDistance.Distance0", &p.threeLogDistance0},
+                {"ThreeLogDistance.Distance1", &p.threeLogDistance1},
+                {"ThreeLogDistance.Distance2", &p.threeLogDistance2},
+                {"ThreeLogDistance.Exponent0", &p.threeLogExponent0},
+                {"ThreeLogDistance.Exponent1", &p.threeLogExponent1},
+                {"ThreeLogDistance.Exponent2", &p.threeLogExponent2},
+                {"ThreeLogDistance.ReferenceLoss", &p.threeLogReferenceLoss},
+                {"TwoRayGround.Frequency", &p.twoRayFrequency},
+                {"TwoRayGround.SystemLoss", &p.twoRaySystemLoss},
+                {"TwoRayGround.MinDistance", &p.twoRayMinDistance},
+                {"Nakagami.Distance1", &p.nakagamiDistance1},
+                {"Nakagami.Distance2", &p.nakagamiDistance2},
+                {"Nakagami.m0", &p.nakagamiM0},
+                {"Nakagami.m1", &p.nakagamiM1},
+                {"Nakagami.m2", &p.nakagamiM2}};
+    }
+};
+
+/**
+ * Read a parameter set written by the calibration tool: "key=value" lines, where lines
+ * starting with # are comments. Keys that are left out keep their default value.
+ *
+ * \param path the file
+ * \param parameters receives the values
+ * \param error receives a description of what went wrong
+ * \return whether the file was read
+ */
+inline bool
+ReadLossParameters(const std::string& path, LossParameters& parameters, std::string& error)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        error = "Cannot read " + path;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+        size_t separator = line.find('=');
+        bool found = false;
+        for (auto& [key, value] : parameters.Fields())
+        {
+            if (separator != std::string::npos && line.compare(0, separator, key) == 0 &&
+                key.size() == separator)
+            {
+                *value = std::stod(line.substr(separator + 1));
+                found = true;
+            }
+        }
+        if (!found)
+        {
+            error = "Unknown loss parameter line in " + path + ": " + line;
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif /* LOSS_PARAMETERS_H */
@@ -0,0 +1,384 @@
+#ifndef NODE_PLACEMENT_H
+#define NODE_PLACEMENT_H
+
+#include "parallel-for.h"
+
+#include "ns3/abort.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/node-container.h"
+#include "ns3/position-allocator.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/vector.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Positions and attributes of many nodes, read from a file without a copy per node.
+ *
+ * The file is either a CSV file with a header line naming its columns, or a binary table
+ * in the RTAB format of aggregate-results: the magic "RTAB", a uint32 column count, a
+ * uint64 row count, every column name as a uint32 length and its characters, and the
+ * rows as native doubles. A binary file is memory mapped and read in place; a CSV file is
+ * parsed once, on several threads, into the same row layout.
+ *
+ * The columns x and y are required. z is the ground elevation (0 if missing) and
+ * antennaHeight the height of the antenna above it, so that a node is placed at
+ * z + antennaHeight. Any other column, e.g. txPower, is a per-node attribute.
+ */
+class NodePlacement : public SimpleRefCount<NodePlacement>
+{
+  public:
+    /**
+     * \param path the position file
+     * \param threads the threads parsing a CSV file
+     */
+    NodePlacement(const std::string& path, unsigned threads = 1)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        NS_ABORT_MSG_IF(fd < 0, "Cannot open position file " << path);
+        struct stat status;
+        NS_ABORT_MSG_IF(fstat(fd, &status) != 0, "Cannot stat position file " << path);
+        m_size = status.st_size;
+        NS_ABORT_MSG_IF(m_size == 0, "Position file " << path << " is empty");
+        void* mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        NS_ABORT_MSG_IF(mapping == MAP_FAILED, "Cannot map position file " << path);
+        m_mapping = static_cast<const char*>(mapping);
+
+        const size_t headerSize = 4 + sizeof(uint32_t) + sizeof(uint64_t);
+        if (m_size >= headerSize && std::memcmp(m_mapping, "RTAB", 4) == 0)
+        {
+            uint32_t columns;
+            std::memcpy(&columns, m_mapping + 4, sizeof(columns));
+            std::memcpy(&m_rows, m_mapping + 4 + sizeof(columns), sizeof(m_rows));
+            // Every column name takes at least its length field
+            NS_ABORT_MSG_IF(columns == 0, path << " has no columns");
+            NS_ABORT_MSG_IF(columns > (m_size - headerSize) / sizeof(uint32_t),
+                            path << " is truncated");
+            size_t offset = headerSize;
+            for (uint32_t column = 0; column < columns; column++)
+            {
+                uint32_t length = 0;
+                NS_ABORT_MSG_IF(offset + sizeof(length) > m_size, path << " is truncated");
+                std::memcpy(&length, m_mapping + offset, sizeof(length));
+                offset += sizeof(length);
+                NS_ABORT_MSG_IF(offset + length > m_size, path << " is truncated");
+                m_columns.emplace_back(m_mapping + offset, length);
+                offset += length;
+            }
+            // Divided instead of multiplied, so that a crafted row count cannot overflow
+            NS_ABORT_MSG_IF(m_rows > (m_size - offset) / sizeof(double) / columns,
+                            path << " is truncated");
+            m_body = m_mapping + offset;
+        }
+        else
+        {
+            ParseCsv(path, threads);
+            munmap(const_cast<char*>(m_mapping), m_size);
+            m_mapping = nullptr;
+            m_body = reinterpret_cast<const char*>(m_parsed.data());
+        }
+
+        m_x = Column("x");
+        m_y = Column("y");
+        m_z = Column("z");
+        m_antennaHeight = Column("antennaHeight");
+        NS_ABORT_MSG_IF(m_x < 0 || m_y < 0, "Position file " << path << " has no x and y");
+    }
+
+    ~NodePlacement()
+    {
+        if (m_mapping)
+        {
+            munmap(const_cast<char*>(m_mapping), m_size);
+        }
+    }
+
+    NodePlacement(const NodePlacement&) = delete;
+    NodePlacement& operator=(const NodePlacement&) = delete;
+
+    /// \return the number of nodes
+    uint64_t GetRows() const
+    {
+        return m_rows;
+    }
+
+    /// \return the names of the columns
+    const std::vector<std::string>& GetColumns() const
+    {
+        return m_columns;
+    }
+
+    /// \return whether the file was mapped instead of parsed
+    bool IsMapped() const
+    {
+        return m_mapping != nullptr;
+    }
+
+    /**
+     * \param name the name of a column
+     * \return its index, or -1 if the file does not have it
+     */
+    int Column(const std::string& name) const
+    {
+        auto found = std::find(m_columns.begin(), m_columns.end(), name);
+        return found == m_columns.end() ? -1 : found - m_columns.begin();
+    }
+
+    /**
+     * \param row the node
+     * \param column the index of a column
+     * \return the value, NaN if a CSV field is not a number
+     */
+    double GetValue(uint64_t row, int column) const
+    {
+        double value;
+        std::memcpy(&value,
+                    m_body + (row * m_columns.size() + column) * sizeof(double),
+                    sizeof(value));
+        return value;
+    }
+
+    /**
+     * \param row the node
+     * \param defaultHeight the antenna height of files without an antennaHeight column
+     * \return the position of its antenna
+     */
+    Vector GetPosition(uint64_t row, double defaultHeight) const
+    {
+        return Vector(GetValue(row, m_x),
+                      GetValue(row, m_y),
+                      (m_z < 0 ? 0 : GetValue(row, m_z)) +
+                          (m_antennaHeight < 0 ? defaultHeight : GetValue(row, m_antennaHeight)));
+    }
+
+    /**
+     * Check that every value is a number and that every node, with the antenna height of
+     * its row if the file has one, lies within a box.
+     *
+     * \param min the lower corner of the box
+     * \param max the upper corner of the box
+     * \param error receives the first node that does not
+     * \return whether all nodes are valid
+     */
+    bool Validate(const Vector& min, const Vector& max, std::string& error) const
+    {
+        for (uint64_t row = 0; row < m_rows; row++)
+        {
+            for (size_t column = 0; column < m_columns.size(); column++)
+            {
+                if (!std::isfinite(GetValue(row, column)))
+                {
+                    error = "Node " + std::to_string(row) + " has no valid " + m_columns[column];
+                    return false;
+                }
+            }
+            Vector position = GetPosition(row, 0);
+            if (position.x < min.x || position.y < min.y || position.z < min.z ||
+                position.x > max.x || position.y > max.y || position.z > max.z)
+            {
+                std::ostringstream message;
+                message << "Node " << row << " at " << position << " is out of bounds";
+                error = message.str();
+                return false;
+            }
+        }
+        return true;
+    }
+
+  private:
+    /**
+     * Parse the lines of a mapped CSV file in parallel into rows of doubles.
+     */
+    void ParseCsv(const std::string& path, unsigned threads)
+    {
+        const char* headerEnd = static_cast<const char*>(std::memchr(m_mapping, '\n', m_size));
+        std::string header(m_mapping, headerEnd ? headerEnd : m_mapping + m_size);
+        if (!header.empty() && header.back() == '\r')
+        {
+            header.pop_back();
+        }
+        std::istringstream stream(header);
+        for (std::string column; std::getline(stream, column, ',');)
+        {
+            m_columns.push_back(column);
+        }
+
+        const char* body = headerEnd ? headerEnd + 1 : m_mapping + m_size;
+        size_t size = m_mapping + m_size - body;
+        size_t columns = m_columns.size();
+        std::vector<size_t> bounds = SplitAtLines(body, size, threads);
+        std::vector<std::vector<double>> parts(threads);
+        RunThreads(threads, [&](unsigned thread) {
+            const char* line = body + bounds[thread];
+            const char* end = body + bounds[thread + 1];
+            while (line < end)
+            {
+                const char* lineEnd =
+                    static_cast<const char*>(std::memchr(line, '\n', end - line));
+                lineEnd = lineEnd ? lineEnd : end;
+                if (lineEnd > line && *line != '#')
+                {
+                    const char* field = line;
+                    for (size_t column = 0; column < columns; column++)
+                    {
+                        while (field < lineEnd && *field == ' ')
+                        {
+                            field++;
+                        }
+                        double value = NAN;
+                        auto [next, error] = std::from_chars(field, lineEnd, value);
+                        parts[thread].push_back(error == std::errc() ? value : NAN);
+                        const char* comma =
+                            static_cast<const char*>(std::memchr(field, ',', lineEnd - field));
+                        field = comma ? comma + 1 : lineEnd;
+                    }
+                }
+                line = lineEnd + 1;
+            }
+        });
+
+        for (const std::vector<double>& part : parts)
+        {
+            m_parsed.insert(m_parsed.end(), part.begin(), part.end());
+        }
+        m_rows = columns > 0 ? m_parsed.size() / columns : 0;
+        NS_ABORT_MSG_IF(columns == 0, "Position file " << path << " has no header line");
+    }
+
+    const char* m_mapping = nullptr;    //!< The mapped binary file, null for CSV files
+    size_t m_size = 0;                  //!< Size of the mapping
+    const char* m_body = nullptr;       //!< The first row
+    uint64_t m_rows = 0;                //!< Number of nodes
+    std::vector<std::string> m_columns; //!< Names of the columns
+    std::vector<double> m_parsed;       //!< The rows of a CSV file
+    int m_x = -1;                       //!< Column of x
+    int m_y = -1;                       //!< Column of y
+    int m_z = -1;                       //!< Column of the ground elevation, -1 if missing
+    int m_antennaHeight = -1;           //!< Column of the antenna height, -1 if missing
+};
+
+/**
+ * Write positions and attributes as a binary position file.
+ *
+ * \param path the file
+ * \param columns the names of the columns
+ * \param values the rows, one value per column each
+ * \return whether the file was written
+ */
+inline bool
+WriteNodePlacement(const std::string& path,
+                   const std::vector<std::string>& columns,
+                   const std::vector<double>& values)
+{
+    std::ofstream file(path, std::ios::binary);
+    uint32_t columnCount = columns.size();
+    uint64_t rows = values.size() / columns.size();
+    file.write("RTAB", 4);
+    file.write(reinterpret_cast<const char*>(&columnCount), sizeof(columnCount));
+    file.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+    for (const std::string& name : columns)
+    {
+        uint32_t length = name.size();
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(name.data(), length);
+    }
+    file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+    return bool(file);
+}
+
+/**
+ * A position allocator that hands out the positions of a NodePlacement in order, reading
+ * them from the placement instead of holding a list of its own. Like the
+ * ListPositionAllocator it starts over after the last node.
+ */
+class PlacementPositionAllocator : public PositionAllocator
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::PlacementPositionAllocator")
+                                .SetParent<PositionAllocator>()
+                                .SetGroupName("Mobility")
+                                .AddConstructor<PlacementPositionAllocator>();
+        return tid;
+    }
+
+    /**
+     * \param placement the positions
+     * \param defaultHeight the antenna height of files without an antennaHeight column
+     */
+    void SetPlacement(Ptr<const NodePlacement> placement, double defaultHeight)
+    {
+        m_placement = placement;
+        m_defaultHeight = defaultHeight;
+        m_next = 0;
+    }
+
+    Vector GetNext() const override
+    {
+        NS_ABORT_MSG_IF(!m_placement || m_placement->GetRows() == 0, "No positions");
+        Vector position = m_placement->GetPosition(m_next, m_defaultHeight);
+        m_next = (m_next + 1) % m_placement->GetRows();
+        return position;
+    }
+
+    int64_t AssignStreams(int64_t stream) override
+    {
+        return 0;
+    }
+
+  private:
+    Ptr<const NodePlacement> m_placement; //!< The positions
+    double m_defaultHeight = 0;           //!< Antenna height if the file has none
+    mutable uint64_t m_next = 0;          //!< The next node
+};
+
+NS_OBJECT_ENSURE_REGISTERED(PlacementPositionAllocator);
+
+/**
+ * Give every node a constant position from a placement, in the order of the rows, without
+ * the object factory and attribute lookups the MobilityHelper does per node.
+ *
+ * \param nodes the nodes, at most as many as the placement has rows
+ * \param placement the positions
+ * \param defaultHeight the antenna height of files without an antennaHeight column
+ */
+inline void
+InstallPlacement(const NodeContainer& nodes, const NodePlacement& placement, double defaultHeight)
+{
+    NS_ABORT_MSG_IF(nodes.GetN() > placement.GetRows(),
+                    "Placing " << nodes.GetN() << " nodes with " << placement.GetRows()
+                               << " positions");
+    for (uint32_t i = 0; i < nodes.GetN(); i++)
+    {
+        Ptr<ConstantPositionMobilityModel> mobility =
+            CreateObject<ConstantPositionMobilityModel>();
+        mobility->SetPosition(placement.GetPosition(i, defaultHeight));
+        nodes.Get(i)->AggregateObject(mobility);
+    }
+}
+
+} // namespace ns3
+
+#endif /* NODE_PLACEMENT_H */
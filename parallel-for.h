@@ -0,0 +1,67 @@
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * Run function(thread) on the given number of threads and wait for all of them.
+ */
+template <typename Function>
+inline void
+RunThreads(unsigned threads, Function function)
+{
+    std::vector<std::thread> workers;
+    for (unsigned thread = 1; thread < threads; thread++)
+    {
+        workers.emplace_back(function, thread);
+    }
+    function(0);
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+/**
+ * Split [0, count) into one contiguous range per thread and run function(begin, end,
+ * thread) on each of them in parallel.
+ */
+template <typename Function>
+inline void
+ParallelFor(size_t count, unsigned threads, Function function)
+{
+    RunThreads(threads, [&](unsigned thread) {
+        function(count * thread / threads, count * (thread + 1) / threads, thread);
+    });
+}
+
+/**
+ * Split text into about equal parts that start at the beginning of a line, so that every
+ * part can be parsed by a thread of its own.
+ *
+ * \param data the text
+ * \param size its size
+ * \param parts the number of parts
+ * \return parts + 1 offsets, part i is [bounds[i], bounds[i + 1])
+ */
+inline std::vector<size_t>
+SplitAtLines(const char* data, size_t size, unsigned parts)
+{
+    std::vector<size_t> bounds = {0};
+    for (unsigned part = 1; part < parts; part++)
+    {
+        size_t position = std::max(size * part / parts, bounds.back());
+        while (position < size && position > 0 && data[position - 1] != '\n')
+        {
+            position++;
+        }
+        bounds.push_back(position);
+    }
+    bounds.push_back(size);
+    return bounds;
+}
+
+#endif /* PARALLEL_FOR_H */
@@ -0,0 +1,856 @@
+#include "loss-parameters.h"
+#include "parallel-for.h"
+
+#include "ns3/command-line.h"
+#include "ns3/core-module.h"
+#include "ns3/log.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("PropagationCalibration");
+
+/**
+ * Field measurements, one entry per sample in every column.
+ */
+struct Measurements
+{
+    std::vector<double> distance; // meters
+    std::vector<double> rss;      // dBm
+    std::vector<double> height;   // Effective antenna height in meters, empty if not measured
+};
+
+/**
+ * Parse CSV lines of distance, RSS and optionally height. Lines that do not start with
+ * two numbers, such as a header, are skipped.
+ */
+static void
+ParseCsvRange(const char* begin, const char* end, Measurements& part, bool& allHeights)
+{
+    const char* line = begin;
+    while (line < end)
+    {
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        lineEnd = lineEnd ? lineEnd : end;
+
+        std::array<double, 3> values;
+        size_t count = 0;
+        const char* field = line;
+        while (count < values.size() && field < lineEnd)
+        {
+            while (field < lineEnd && (*field == ' ' || *field == '\t'))
+            {
+                field++;
+            }
+            auto [next, error] = std::from_chars(field, lineEnd, values[count]);
+            if (error != std::errc())
+            {
+                break;
+            }
+            count++;
+            field = next;
+            while (field < lineEnd && (*field == ' ' || *field == '\t' || *field == ','))
+            {
+                field++;
+            }
+        }
+
+        if (count >= 2)
+        {
+            part.distance.push_back(values[0]);
+            part.rss.push_back(values[1]);
+            if (count == 3)
+            {
+                part.height.push_back(values[2]);
+            }
+            else
+            {
+                allHeights = false;
+            }
+        }
+        line = lineEnd + 1;
+    }
+}
+
+/**
+ * Load measurements from a CSV file or a binary file.
+ *
+ * The file is mapped into memory. A CSV file is split at line boundaries into one range
+ * per thread, which are parsed in parallel. A binary file starts with the magic "RSSB", a
+ * uint32 column count (2 or 3) and a uint64 row count, followed by the rows as doubles in
+ * host byte order.
+ */
+static Measurements
+LoadMeasurements(const std::string& path, unsigned threads)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    NS_ABORT_MSG_IF(fd < 0, "Cannot open " << path);
+    struct stat status;
+    fstat(fd, &status);
+    size_t size = status.st_size;
+    NS_ABORT_MSG_IF(size == 0, path << " is empty");
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    NS_ABORT_MSG_IF(mapping == MAP_FAILED, "Cannot map " << path);
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    const char* data = static_cast<const char*>(mapping);
+
+    Measurements measurements;
+    const size_t headerSize = 4 + sizeof(uint32_t) + sizeof(uint64_t);
+    if (size >= headerSize && std::memcmp(data, "RSSB", 4) == 0)
+    {
+        uint32_t columns;
+        uint64_t rows;
+        std::memcpy(&columns, data + 4, sizeof(columns));
+        std::memcpy(&rows, data + 4 + sizeof(columns), sizeof(rows));
+        NS_ABORT_MSG_IF(columns < 2 || columns > 3 ||
+                            size < headerSize + rows * columns * sizeof(double),
+                        path << " is not a valid binary measurement file");
+
+        measurements.distance.resize(rows);
+        measurements.rss.resize(rows);
+        measurements.height.resize(columns == 3 ? rows : 0);
+        const char* values = data + headerSize;
+        ParallelFor(rows, threads, [&](size_t begin, size_t end, unsigned) {
+            for (size_t row = begin; row < end; row++)
+            {
+                double sample[3];
+                std::memcpy(sample,
+                            values + row * columns * sizeof(double),
+                            columns * sizeof(double));
+                measurements.distance[row] = sample[0];
+                measurements.rss[row] = sample[1];
+                if (columns == 3)
+                {
+                    measurements.height[row] = sample[2];
+                }
+            }
+        });
+    }
+    else
+    {
+        std::vector<size_t> bounds = SplitAtLines(data, size, threads);
+
+        std::vector<Measurements> parts(threads);
+        std::vector<char> allHeights(threads, true);
+        RunThreads(threads, [&](unsigned thread) {
+            bool heights = true;
+            ParseCsvRange(data + bounds[thread], data + bounds[thread + 1], parts[thread], heights);
+            allHeights[thread] = heights;
+        });
+
+        bool heights = std::all_of(allHeights.begin(), allHeights.end(), [](char h) { return h; });
+        for (Measurements& part : parts)
+        {
+            measurements.distance.insert(measurements.distance.end(),
+                                         part.distance.begin(),
+                                         part.distance.end());
+            measurements.rss.insert(measurements.rss.end(), part.rss.begin(), part.rss.end());
+            if (heights)
+            {
+                measurements.height.insert(measurements.height.end(),
+                                           part.height.begin(),
+                                           part.height.end());
+            }
+        }
+    }
+
+    munmap(mapping, size);
+    return measurements;
+}
+
+/**
+ * Measurements sorted by distance, with what the fits need precomputed.
+ */
+struct Samples
+{
+    std::vector<double> distance;  // meters
+    std::vector<double> logDistance; // log10 of the distance
+    std::vector<double> rss;       // dBm
+    std::vector<double> pathLoss;  // dB, from the transmit power and gains
+    std::vector<double> height;    // meters, one per sample
+};
+
+static Samples
+PrepareSamples(const Measurements& measurements,
+               double txPowerDbm,
+               double defaultHeight,
+               unsigned threads)
+{
+    std::vector<size_t> order(measurements.distance.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&measurements](size_t a, size_t b) {
+        return measurements.distance[a] < measurements.distance[b];
+    });
+    order.erase(std::remove_if(order.begin(),
+                               order.end(),
+                               [&measurements](size_t i) {
+                                   return !(measurements.distance[i] > 0) ||
+                                          !std::isfinite(measurements.rss[i]);
+                               }),
+                order.end());
+
+    Samples samples;
+    size_t n = order.size();
+    for (std::vector<double>* column : {&samples.distance,
+                                        &samples.logDistance,
+                                        &samples.rss,
+                                        &samples.pathLoss,
+                                        &samples.height})
+    {
+        column->resize(n);
+    }
+    ParallelFor(n, threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; i++)
+        {
+            size_t source = order[i];
+            samples.distance[i] = measurements.distance[source];
+            samples.logDistance[i] = std::log10(samples.distance[i]);
+            samples.rss[i] = measurements.rss[source];
+            samples.pathLoss[i] = txPowerDbm - samples.rss[i];
+            samples.height[i] =
+                measurements.height.empty() ? defaultHeight : measurements.height[source];
+        }
+    });
+    return samples;
+}
+
+/**
+ * Sum kernel(i) over all samples in parallel.
+ */
+template <typename Kernel>
+static double
+ParallelSum(size_t count, unsigned threads, Kernel kernel)
+{
+    std::vector<double> partial(threads, 0);
+    ParallelFor(count, threads, [&](size_t begin, size_t end, unsigned thread) {
+        double sum = 0;
+        for (size_t i = begin; i < end; i++)
+        {
+            sum += kernel(i);
+        }
+        partial[thread] = sum;
+    });
+    return std::accumulate(partial.begin(), partial.end(), 0.0);
+}
+
+static const double SPEED_OF_LIGHT = 299792458.0;
+
+/**
+ * Friis path loss in dB without system loss, as in ns3::FriisPropagationLossModel.
+ */
+static double
+FriisLossDb(double logDistance, double frequency)
+{
+    return 20 * std::log10(4 * M_PI * frequency / SPEED_OF_LIGHT) + 20 * logDistance;
+}
+
+/**
+ * Two-ray ground path loss in dB without system loss, as in
+ * ns3::TwoRayGroundPropagationLossModel with both antennas at the same height.
+ */
+static double
+TwoRayLossDb(double distance, double logDistance, double height, double frequency)
+{
+    double lambda = SPEED_OF_LIGHT / frequency;
+    if (distance <= 4 * M_PI * height * height / lambda)
+    {
+        return FriisLossDb(logDistance, frequency);
+    }
+    return 40 * logDistance - 40 * std::log10(height);
+}
+
+/**
+ * Path loss of ns3::ThreeLogDistancePropagationLossModel in dB.
+ */
+static double
+ThreeLogLossDb(double logDistance, const LossParameters& p)
+{
+    double u0 = std::log10(p.threeLogDistance0);
+    double u1 = std::log10(p.threeLogDistance1);
+    double u2 = std::log10(p.threeLogDistance2);
+    if (logDistance < u0)
+    {
+        return 0;
+    }
+    return p.threeLogReferenceLoss + 10 * p.threeLogExponent0 * (std::min(logDistance, u1) - u0) +
+           10 * p.threeLogExponent1 * std::clamp(logDistance - u1, 0.0, u2 - u1) +
+           10 * p.threeLogExponent2 * std::max(logDistance - u2, 0.0);
+}
+
+/**
+ * Prefix sums over the samples sorted by distance, so that the sums over any distance
+ * range take two lookups.
+ */
+template <size_t N>
+struct PrefixSums
+{
+    std::vector<std::array<double, N>> sums; // sums[i] covers the samples before i
+
+    std::array<double, N> Range(size_t begin, size_t end) const
+    {
+        std::array<double, N> range;
+        for (size_t k = 0; k < N; k++)
+        {
+            range[k] = sums[end][k] - sums[begin][k];
+        }
+        return range;
+    }
+};
+
+template <size_t N, typename Terms>
+static PrefixSums<N>
+MakePrefixSums(size_t count, Terms terms)
+{
+    PrefixSums<N> prefix;
+    prefix.sums.resize(count + 1);
+    prefix.sums[0].fill(0);
+    for (size_t i = 0; i < count; i++)
+    {
+        std::array<double, N> values = terms(i);
+        for (size_t k = 0; k < N; k++)
+        {
+            prefix.sums[i + 1][k] = prefix.sums[i][k] + values[k];
+        }
+    }
+    return prefix;
+}
+
+/**
+ * Candidate breakpoint distances: log-spaced between the smallest and largest distance.
+ */
+static std::vector<double>
+CandidateDistances(double minDistance, double maxDistance, size_t count)
+{
+    std::vector<double> candidates;
+    for (size_t i = 1; i <= count; i++)
+    {
+        candidates.push_back(minDistance *
+                             std::pow(maxDistance / minDistance, double(i) / (count + 1)));
+    }
+    return candidates;
+}
+
+/**
+ * Solve A x = b for a small dense system by Gaussian elimination with partial pivoting.
+ *
+ * \return whether the system is regular
+ */
+template <size_t N>
+static bool
+Solve(std::array<std::array<double, N>, N> a, std::array<double, N> b, std::array<double, N>& x)
+{
+    for (size_t col = 0; col < N; col++)
+    {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < N; row++)
+        {
+            if (std::fabs(a[row][col]) > std::fabs(a[pivot][col]))
+            {
+                pivot = row;
+            }
+        }
+        if (std::fabs(a[pivot][col]) < 1e-12)
+        {
+            return false;
+        }
+        std::swap(a[col], a[pivot]);
+        std::swap(b[col], b[pivot]);
+        for (size_t row = col + 1; row < N; row++)
+        {
+            double factor = a[row][col] / a[col][col];
+            for (size_t k = col; k < N; k++)
+            {
+                a[row][k] -= factor * a[col][k];
+            }
+            b[row] -= factor * b[col];
+        }
+    }
+    for (size_t col = N; col-- > 0;)
+    {
+        double sum = b[col];
+        for (size_t k = col + 1; k < N; k++)
+        {
+            sum -= a[col][k] * x[k];
+        }
+        x[col] = sum / a[col][col];
+    }
+    return true;
+}
+
+/**
+ * Fit ReferenceLoss and the three exponents of ThreeLogDistance by least squares for
+ * every pair of candidate breakpoints Distance1 < Distance2, in parallel, and keep the
+ * pair with the smallest residual. Distance0 stays fixed, as ns-3 applies no loss below
+ * it. The model is linear in the fitted parameters, so every pair is solved in closed
+ * form from prefix sums of the samples.
+ *
+ * \return the residual sum of squares, or -1 if no pair could be fitted
+ */
+static double
+FitThreeLogDistance(const Samples& samples, LossParameters& parameters, unsigned threads)
+{
+    const size_t minSegment = 10;
+    size_t first = std::lower_bound(samples.distance.begin(),
+                                    samples.distance.end(),
+                                    parameters.threeLogDistance0) -
+                   samples.distance.begin();
+    size_t n = samples.distance.size();
+    if (n - first < 3 * minSegment)
+    {
+        return -1;
+    }
+
+    // Sums of 1, u, u^2, PL, PL u and PL^2 with u the log distance
+    PrefixSums<6> prefix = MakePrefixSums<6>(n, [&samples](size_t i) {
+        double u = samples.logDistance[i];
+        double pl = samples.pathLoss[i];
+        return std::array<double, 6>{1, u, u * u, pl, pl * u, pl * pl};
+    });
+
+    std::vector<double> candidates =
+        CandidateDistances(samples.distance[first], samples.distance.back(), 48);
+    std::vector<std::pair<double, double>> pairs;
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        for (size_t j = i + 1; j < candidates.size(); j++)
+        {
+            pairs.emplace_back(candidates[i], candidates[j]);
+        }
+    }
+
+    struct Fit
+    {
+        double rss = -1;
+        std::array<double, 4> theta{};
+        std::pair<double, double> breakpoints;
+    };
+
+    std::vector<Fit> best(threads);
+    double u0 = std::log10(parameters.threeLogDistance0);
+    ParallelFor(pairs.size(), threads, [&](size_t begin, size_t end, unsigned thread) {
+        for (size_t p = begin; p < end; p++)
+        {
+            auto [d1, d2] = pairs[p];
+            double u1 = std::log10(d1);
+            double u2 = std::log10(d2);
+            size_t b1 = std::lower_bound(samples.distance.begin() + first,
+                                         samples.distance.end(),
+                                         d1) -
+                        samples.distance.begin();
+            size_t b2 = std::lower_bound(samples.distance.begin() + b1,
+                                         samples.distance.end(),
+                                         d2) -
+                        samples.distance.begin();
+            if (b1 - first < minSegment || b2 - b1 < minSegment || n - b2 < minSegment)
+            {
+                continue;
+            }
+
+            // Within a segment the features are c + u g, see ThreeLogLossDb
+            std::array<std::array<double, 4>, 3> c = {
+                {{1, -10 * u0, 0, 0},
+                 {1, 10 * (u1 - u0), -10 * u1, 0},
+                 {1, 10 * (u1 - u0), 10 * (u2 - u1), -10 * u2}}};
+            std::array<std::array<double, 4>, 3> g = {
+                {{0, 10, 0, 0}, {0, 0, 10, 0}, {0, 0, 0, 10}}};
+            std::array<std::pair<size_t, size_t>, 3> ranges = {{{first, b1}, {b1, b2}, {b2, n}}};
+
+            std::array<std::array<double, 4>, 4> a{};
+            std::array<double, 4> b{};
+            double ss = 0;
+            for (size_t s = 0; s < 3; s++)
+            {
+                auto [count, su, suu, sp, spu, spp] =
+                    prefix.Range(ranges[s].first, ranges[s].second);
+                for (size_t k = 0; k < 4; k++)
+                {
+                    for (size_t l = 0; l < 4; l++)
+                    {
+                        a[k][l] += count * c[s][k] * c[s][l] +
+                                   su * (c[s][k] * g[s][l] + g[s][k] * c[s][l]) +
+                                   suu * g[s][k] * g[s][l];
+                    }
+                    b[k] += sp * c[s][k] + spu * g[s][k];
+                }
+                ss += spp;
+            }
+
+            std::array<double, 4> theta;
+            if (!Solve(a, b, theta))
+            {
+                continue;
+            }
+            double residual = ss;
+            for (size_t k = 0; k < 4; k++)
+            {
+                residual -= 2 * theta[k] * b[k];
+                for (size_t l = 0; l < 4; l++)
+                {
+                    residual += theta[k] * a[k][l] * theta[l];
+                }
+            }
+            if (best[thread].rss < 0 || residual < best[thread].rss)
+            {
+                best[thread] = {residual, theta, pairs[p]};
+            }
+        }
+    });
+
+    Fit fit;
+    for (const Fit& candidate : best)
+    {
+        if (candidate.rss >= 0 && (fit.rss < 0 || candidate.rss < fit.rss))
+        {
+            fit = candidate;
+        }
+    }
+    if (fit.rss < 0)
+    {
+        return -1;
+    }
+    parameters.threeLogReferenceLoss = fit.theta[0];
+    parameters.threeLogExponent0 = fit.theta[1];
+    parameters.threeLogExponent1 = fit.theta[2];
+    parameters.threeLogExponent2 = fit.theta[3];
+    parameters.threeLogDistance1 = fit.breakpoints.first;
+    parameters.threeLogDistance2 = fit.breakpoints.second;
+    return fit.rss;
+}
+
+static double
+Digamma(double x)
+{
+    double result = 0;
+    for (; x < 6; x++)
+    {
+        result -= 1 / x;
+    }
+    double f = 1 / (x * x);
+    return result + std::log(x) - 0.5 / x -
+           f * (1.0 / 12 - f * (1.0 / 120 - f * (1.0 / 252 - f * (1.0 / 240 - f / 132))));
+}
+
+static double
+Trigamma(double x)
+{
+    double result = 0;
+    for (; x < 6; x++)
+    {
+        result += 1 / (x * x);
+    }
+    double f = 1 / (x * x);
+    return result + 1 / x + f / 2 +
+           f / x * (1.0 / 6 - f * (1.0 / 30 - f * (1.0 / 42 - f / 30)));
+}
+
+/**
+ * Maximum likelihood Nakagami shape of power samples normalised to unit mean, i.e. of a
+ * Gamma(m, 1/m) distribution, from their count, sum and sum of logarithms.
+ *
+ * \param logLikelihood receives the log-likelihood at the estimate
+ * \return the shape, clamped to [0.5, 100]
+ */
+static double
+NakagamiShape(double count, double sum, double logSum, double& logLikelihood)
+{
+    // The estimate solves ln m - digamma(m) = s
+    double s = (sum - logSum) / count - 1;
+    double m = 100;
+    if (s > 1e-6)
+    {
+        m = (3 - s + std::sqrt((s - 3) * (s - 3) + 24 * s)) / (12 * s);
+        for (int iteration = 0; iteration < 20; iteration++)
+        {
+            double step = (std::log(m) - Digamma(m) - s) / (1 / m - Trigamma(m));
+            m = std::max(m - step, m / 10);
+            if (std::fabs(step) < 1e-10 * m)
+            {
+                break;
+            }
+        }
+    }
+    m = std::clamp(m, 0.5, 100.0);
+    logLikelihood = count * (m * std::log(m) - std::lgamma(m)) + (m - 1) * logSum - m * sum;
+    return m;
+}
+
+/**
+ * Fit the shapes and distances of the Nakagami model by maximum likelihood.
+ *
+ * The sweep uses Nakagami fading on its own, so only the fading is fitted: every sample
+ * is normalised by the mean linear power of its window of neighbours in distance, and
+ * the shapes m0, m1 and m2 are estimated for every pair of candidate distances in
+ * parallel, keeping the pair with the highest likelihood.
+ *
+ * \return the log-likelihood, or NaN if there are too few samples
+ */
+static double
+FitNakagami(const Samples& samples, LossParameters& parameters, size_t window, unsigned threads)
+{
+    const size_t minSegment = 30;
+    size_t n = samples.distance.size();
+    if (n < 3 * minSegment || window == 0)
+    {
+        return NAN;
+    }
+
+    std::vector<double> power(n);
+    ParallelFor(n, threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; i++)
+        {
+            power[i] = std::pow(10, samples.rss[i] / 10);
+        }
+    });
+    std::vector<double> normalised(n);
+    ParallelFor((n + window - 1) / window, threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t w = begin; w < end; w++)
+        {
+            size_t from = w * window;
+            size_t to = std::min(from + window, n);
+            double mean = std::accumulate(power.begin() + from, power.begin() + to, 0.0) /
+                          (to - from);
+            for (size_t i = from; i < to; i++)
+            {
+                normalised[i] = power[i] / mean;
+            }
+        }
+    });
+
+    PrefixSums<3> prefix = MakePrefixSums<3>(n, [&normalised](size_t i) {
+        return std::array<double, 3>{1, normalised[i], std::log(normalised[i])};
+    });
+
+    std::vector<double> candidates =
+        CandidateDistances(samples.distance.front(), samples.distance.back(), 48);
+    std::vector<std::pair<double, double>> pairs;
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        for (size_t j = i + 1; j < candidates.size(); j++)
+        {
+            pairs.emplace_back(candidates[i], candidates[j]);
+        }
+    }
+
+    struct Fit
+    {
+        double logLikelihood = -INFINITY;
+        std::array<double, 3> shapes{};
+        std::pair<double, double> distances;
+    };
+
+    std::vector<Fit> best(threads);
+    ParallelFor(pairs.size(), threads, [&](size_t begin, size_t end, unsigned thread) {
+        for (size_t p = begin; p < end; p++)
+        {
+            size_t b1 = std::lower_bound(samples.distance.begin(),
+                                         samples.distance.end(),
+                                         pairs[p].first) -
+                        samples.distance.begin();
+            size_t b2 = std::lower_bound(samples.distance.begin() + b1,
+                                         samples.distance.end(),
+                                         pairs[p].second) -
+                        samples.distance.begin();
+            if (b1 < minSegment || b2 - b1 < minSegment || n - b2 < minSegment)
+            {
+                continue;
+            }
+
+            Fit fit{0, {}, pairs[p]};
+            std::array<std::pair<size_t, size_t>, 3> ranges = {{{0, b1}, {b1, b2}, {b2, n}}};
+            for (size_t s = 0; s < 3; s++)
+            {
+                auto [count, sum, logSum] = prefix.Range(ranges[s].first, ranges[s].second);
+                double logLikelihood;
+                fit.shapes[s] = NakagamiShape(count, sum, logSum, logLikelihood);
+                fit.logLikelihood += logLikelihood;
+            }
+            if (fit.logLikelihood > best[thread].logLikelihood)
+            {
+                best[thread] = fit;
+            }
+        }
+    });
+
+    Fit fit;
+    for (const Fit& candidate : best)
+    {
+        if (candidate.logLikelihood > fit.logLikelihood)
+        {
+            fit = candidate;
+        }
+    }
+    if (!std::isfinite(fit.logLikelihood))
+    {
+        return NAN;
+    }
+    parameters.nakagamiM0 = fit.shapes[0];
+    parameters.nakagamiM1 = fit.shapes[1];
+    parameters.nakagamiM2 = fit.shapes[2];
+    parameters.nakagamiDistance1 = fit.distances.first;
+    parameters.nakagamiDistance2 = fit.distances.second;
+    return fit.logLikelihood;
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string input;
+    std::string output = "calibrated-loss-parameters.txt";
+    unsigned threads = std::max(std::thread::hardware_concurrency(), 1U);
+    double txPower = 10;  // dBm
+    double txGain = 1;    // dB
+    double rxGain = 1;    // dB
+    double antennaZ = 1.5; // meters
+    uint32_t fadingWindow = 200;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("input",
+                 "Measurements: CSV lines of distance (m), RSS (dBm) and optionally antenna "
+                 "height (m), or a binary RSSB file",
+                 input);
+    cmd.AddValue("output", "Where to write the fitted parameter set", output);
+    cmd.AddValue("threads", "Number of threads for loading and fitting", threads);
+    cmd.AddValue("txPower", "Transmit power of the measurements in dBm", txPower);
+    cmd.AddValue("txGain", "Transmit antenna gain of the measurements in dB", txGain);
+    cmd.AddValue("rxGain", "Receive antenna gain of the measurements in dB", rxGain);
+    cmd.AddValue("antennaZ",
+                 "Antenna height of the sweep in meters; the two-ray model sees twice this "
+                 "height unless the measurements have a height column",
+                 antennaZ);
+    cmd.AddValue("fadingWindow",
+                 "Samples per window over which the local mean power is taken to normalise "
+                 "the Nakagami fading",
+                 fadingWindow);
+    cmd.Parse(argc, argv);
+    NS_ABORT_MSG_IF(input.empty(), "--input is required");
+    threads = std::max(threads, 1U);
+
+    auto start = std::chrono::steady_clock::now();
+    Measurements measurements = LoadMeasurements(input, threads);
+    double loadSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    NS_LOG_UNCOND("Loaded " << measurements.distance.size() << " samples in " << loadSeconds
+                            << " s");
+
+    // The sweep places both antennas at antennaZ and the two-ray model adds HeightAboveZ,
+    // which the sweep also sets to antennaZ
+    Samples samples =
+        PrepareSamples(measurements, txPower + txGain + rxGain, 2 * antennaZ, threads);
+    size_t n = samples.distance.size();
+    NS_ABORT_MSG_IF(n == 0, "No valid samples in " << input);
+
+    LossParameters parameters;
+    std::ostringstream report;
+    report << std::setprecision(6);
+    report << "# Calibrated from " << input << " with " << n << " samples\n";
+
+    // FixedRSS: the mean RSS
+    parameters.fixedRss =
+        ParallelSum(n, threads, [&samples](size_t i) { return samples.rss[i]; }) / n;
+    double fixedRssRmse = std::sqrt(ParallelSum(n, threads, [&](size_t i) {
+                                        double e = samples.rss[i] - parameters.fixedRss;
+                                        return e * e;
+                                    }) /
+                                    n);
+    report << "# FixedRSS rmse " << fixedRssRmse << " dB\n";
+
+    // Friis and TwoRayGround: the system loss is the mean excess loss over the model
+    double friisExcess = ParallelSum(n, threads, [&](size_t i) {
+                             return samples.pathLoss[i] -
+                                    FriisLossDb(samples.logDistance[i], parameters.friisFrequency);
+                         }) /
+                         n;
+    parameters.friisSystemLoss = std::pow(10, friisExcess / 10);
+    double friisRmse = std::sqrt(ParallelSum(n, threads, [&](size_t i) {
+                                     double e = samples.pathLoss[i] - friisExcess -
+                                                FriisLossDb(samples.logDistance[i],
+                                                            parameters.friisFrequency);
+                                     return e * e;
+                                 }) /
+                                 n);
+    report << "# Friis rmse " << friisRmse << " dB\n";
+
+    auto twoRayLoss = [&](size_t i) {
+        return TwoRayLossDb(samples.distance[i],
+                            samples.logDistance[i],
+                            samples.height[i],
+                            parameters.twoRayFrequency);
+    };
+    size_t twoRayFirst = std::upper_bound(samples.distance.begin(),
+                                          samples.distance.end(),
+                                          parameters.twoRayMinDistance) -
+                         samples.distance.begin();
+    size_t twoRayCount = n - twoRayFirst;
+    if (twoRayCount > 0)
+    {
+        double twoRayExcess = ParallelSum(twoRayCount, threads, [&](size_t i) {
+                                  return samples.pathLoss[twoRayFirst + i] -
+                                         twoRayLoss(twoRayFirst + i);
+                              }) /
+                              twoRayCount;
+        parameters.twoRaySystemLoss = std::pow(10, twoRayExcess / 10);
+        double twoRayRmse = std::sqrt(ParallelSum(twoRayCount, threads, [&](size_t i) {
+                                          double e = samples.pathLoss[twoRayFirst + i] -
+                                                     twoRayExcess - twoRayLoss(twoRayFirst + i);
+                                          return e * e;
+                                      }) /
+                                      twoRayCount);
+        report << "# TwoRayGround rmse " << twoRayRmse << " dB\n";
+    }
+
+    double threeLogResidual = FitThreeLogDistance(samples, parameters, threads);
+    if (threeLogResidual >= 0)
+    {
+        double threeLogRmse = std::sqrt(ParallelSum(n, threads, [&](size_t i) {
+                                            if (samples.distance[i] < parameters.threeLogDistance0)
+                                            {
+                                                return 0.0;
+                                            }
+                                            double e = samples.pathLoss[i] -
+                                                       ThreeLogLossDb(samples.logDistance[i],
+                                                                      parameters);
+                                            return e * e;
+                                        }) /
+                                        n);
+        report << "# ThreeLogDistance rmse " << threeLogRmse << " dB\n";
+    }
+    else
+    {
+        report << "# ThreeLogDistance not fitted, too few samples\n";
+    }
+
+    double nakagamiLogLikelihood = FitNakagami(samples, parameters, fadingWindow, threads);
+    if (std::isfinite(nakagamiLogLikelihood))
+    {
+        report << "# Nakagami log-likelihood per sample " << nakagamiLogLikelihood / n << "\n";
+    }
+    else
+    {
+        report << "# Nakagami not fitted, too few samples\n";
+    }
+
+    std::ofstream outputFile(output);
+    outputFile << report.str() << parameters.ToString();
+    NS_LOG_UNCOND(report.str() << parameters.ToString());
+    double totalSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    NS_LOG_UNCOND("Fitted in " << totalSeconds - loadSeconds << " s, written to " << output);
+}
@@ -0,0 +1,198 @@
+#ifndef RESULT_RING_H
+#define RESULT_RING_H
+
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+
+/**
+ * A bounded multi-producer, single-consumer ring of records in shared memory.
+ *
+ * The coordinator creates the ring before forking its workers, which inherit the mapping
+ * and push records into it directly. Every slot holds one record of at most PayloadSize()
+ * bytes and a sequence number that hands it over between the producers and the consumer
+ * (Vyukov's bounded queue), so producers only contend on reserving a slot and never wait
+ * for each other while copying. When the ring is full, producers wait for the coordinator
+ * to drain it. The coordinator drains records in place, without copying them out first.
+ *
+ * A producer that dies between reserving and publishing a slot stalls the consumer at
+ * that slot, so workers must not be killed while pushing.
+ */
+class ResultRing
+{
+  public:
+    /**
+     * Map a ring shared with the processes forked afterwards.
+     *
+     * \param slots the number of records the ring holds
+     * \param payloadSize the maximum size of a record in bytes
+     */
+    ResultRing(size_t slots, size_t payloadSize)
+        : m_slots(slots),
+          m_payloadSize(payloadSize),
+          m_slotStride((sizeof(Slot) + payloadSize + 63) / 64 * 64),
+          m_dequeue(0)
+    {
+        m_size = sizeof(Control) + m_slots * m_slotStride;
+        void* memory =
+            mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+        {
+            perror("mmap");
+            std::abort();
+        }
+        m_control = new (memory) Control;
+        for (size_t i = 0; i < m_slots; i++)
+        {
+            new (GetSlot(i)) Slot;
+            GetSlot(i)->sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~ResultRing()
+    {
+        munmap(m_control, m_size);
+    }
+
+    ResultRing(const ResultRing&) = delete;
+    ResultRing& operator=(const ResultRing&) = delete;
+
+    /**
+     * \return the maximum size of a record in bytes
+     */
+    size_t PayloadSize() const
+    {
+        return m_payloadSize;
+    }
+
+    /**
+     * Push a record, waiting while the ring is full. Called by the workers.
+     *
+     * \param type what the record holds
+     * \param task the task that produced it
+     * \param data the record
+     * \param size its size, at most PayloadSize()
+     */
+    void Push(uint32_t type, uint32_t task, const void* data, size_t size)
+    {
+        if (size > m_payloadSize)
+        {
+            std::fprintf(stderr, "Record of %zu bytes exceeds the ring slots\n", size);
+            std::abort();
+        }
+
+        uint64_t position = m_control->enqueue.load(std::memory_order_relaxed);
+        unsigned waits = 0;
+        Slot* slot;
+        while (true)
+        {
+            slot = GetSlot(position % m_slots);
+            int64_t diff =
+                int64_t(slot->sequence.load(std::memory_order_acquire)) - int64_t(position);
+            if (diff == 0)
+            {
+                if (m_control->enqueue.compare_exchange_weak(position,
+                                                             position + 1,
+                                                             std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                // Full: back off until the coordinator has drained a slot
+                if (++waits < 64)
+                {
+                    sched_yield();
+                }
+                else
+                {
+                    usleep(50);
+                }
+                position = m_control->enqueue.load(std::memory_order_relaxed);
+            }
+            else
+            {
+                position = m_control->enqueue.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->type = type;
+        slot->task = task;
+        slot->size = size;
+        std::memcpy(GetPayload(slot), data, size);
+        slot->sequence.store(position + 1, std::memory_order_release);
+    }
+
+    /**
+     * Hand every published record to handle, in place, and release its slot afterwards.
+     * Called by the coordinator only.
+     *
+     * \param handle called with the type, task, data and size of every record; the data
+     *        is only valid during the call
+     * \return the number of records drained
+     */
+    size_t Drain(const std::function<void(uint32_t, uint32_t, const void*, size_t)>& handle)
+    {
+        size_t drained = 0;
+        while (true)
+        {
+            Slot* slot = GetSlot(m_dequeue % m_slots);
+            if (slot->sequence.load(std::memory_order_acquire) != m_dequeue + 1)
+            {
+                return drained;
+            }
+            handle(slot->type, slot->task, GetPayload(slot), slot->size);
+            slot->sequence.store(m_dequeue + m_slots, std::memory_order_release);
+            m_dequeue++;
+            drained++;
+        }
+    }
+
+  private:
+    /// State shared by all producers, on a cache line of its own
+    struct Control
+    {
+        alignas(64) std::atomic<uint64_t> enqueue{0}; //!< Next slot to reserve
+    };
+
+    /// Header of a slot, followed by its payload
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> sequence; //!< Hands the slot over, see Vyukov's queue
+        uint32_t type;                  //!< What the record holds
+        uint32_t task;                  //!< Task that produced it
+        uint64_t size;                  //!< Size of the record
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                  "The ring needs lock-free atomics to work across processes");
+
+    Slot* GetSlot(size_t index) const
+    {
+        return reinterpret_cast<Slot*>(reinterpret_cast<char*>(m_control) + sizeof(Control) +
+                                       index * m_slotStride);
+    }
+
+    static char* GetPayload(Slot* slot)
+    {
+        return reinterpret_cast<char*>(slot) + sizeof(Slot);
+    }
+
+    size_t m_slots;       //!< Number of slots
+    size_t m_payloadSize; //!< Maximum record size
+    size_t m_slotStride;  //!< Bytes from one slot to the next
+    size_t m_size;        //!< Size of the mapping
+    Control* m_control;   //!< Start of the mapping
+    uint64_t m_dequeue;   //!< Next slot to drain, only used by the coordinator
+};
+
+#endif /* RESULT_RING_H */
@@ -0,0 +1,487 @@
+#ifndef RESULT_STORE_H
+#define RESULT_STORE_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// ns-3 defines HAVE_SQLITE3 when it finds SQLite, which the stats module links
+#ifdef HAVE_SQLITE3
+#include <sqlite3.h>
+#endif
+
+/**
+ * Time and memory one simulated point took.
+ */
+struct StoredTiming
+{
+    uint64_t events;    //!< Simulator events executed
+    double runSeconds;  //!< Wall time spent in Simulator::Run()
+    double wallSeconds; //!< Wall time of the whole point
+    long peakRssKb;     //!< Peak resident set size
+};
+
+/**
+ * Statistics of one flow of a point, as the flow monitor counts them.
+ */
+struct StoredFlow
+{
+    uint32_t flowId;
+    uint64_t txBytes;
+    uint64_t rxBytes;
+    uint64_t txPackets;
+    uint64_t rxPackets;
+    uint64_t lostPackets;
+    double delaySum;  //!< seconds
+    double jitterSum; //!< seconds
+};
+
+/**
+ * MAC counters of one point.
+ */
+struct StoredMac
+{
+    uint64_t retransmissions;
+    uint64_t retryLimitDrops;
+    uint64_t queueDrops;
+    uint64_t backoffs;
+    uint64_t backoffSlots;
+    uint64_t mcsChanges;
+    std::array<uint64_t, 8> mcsHistogram;
+};
+
+/**
+ * A point as the result store holds it. Values a source does not have, such as the
+ * byte counts of an imported output file, are stored as NULL.
+ */
+struct StoredPoint
+{
+    std::string model;
+    std::string phy;
+    double distance; //!< meters
+    uint32_t seed;
+    std::optional<uint32_t> maxAmpduSize;
+    std::optional<uint32_t> maxAmsduSize;
+    std::optional<uint32_t> blockAckThreshold;
+    std::optional<uint32_t> blockAckInactivityTimeout;
+    uint32_t hops = 1;                            //!< Links of the relay chain, 1 for a single link
+    uint32_t clients = 1;                         //!< Clients contending for the channel
+    std::string transport = "UdpCbr";             //!< UdpCbr, UdpSaturating or TcpBulk
+    std::optional<std::string> congestionControl; //!< TCP only
+    std::optional<uint32_t> segmentSize;          //!< bytes, TCP only
+    std::string configHash;                       //!< Empty if unknown
+    double rss;                                   //!< dBm
+    double throughput;                            //!< Kbps
+    std::optional<double> goodput;                //!< Kbps of application payload
+    std::optional<uint64_t> rxBytes;
+    std::optional<uint64_t> rxPackets;
+    std::optional<bool> connectionLost;
+    std::optional<StoredMac> mac;
+    std::optional<StoredTiming> timing;
+    std::vector<StoredFlow> flows;
+};
+
+/**
+ * Results of many sweeps in a single SQLite database, so that they can be queried with
+ * indexes instead of by globbing and parsing output files.
+ *
+ * Every sweep or import is a run; its points reference it and the configuration they were
+ * simulated with, their timing and flow statistics reference the point. Points are indexed
+ * by model, distance, seed and configuration hash. Writes are meant to be grouped into
+ * transactions with Begin and Commit: SQLite syncs the database once per transaction, not
+ * once per row. Only one process writes, the coordinator of a sweep.
+ *
+ * The schema version is kept in PRAGMA user_version, and a database with another version
+ * is refused when it is opened.
+ *
+ * Without SQLite, the store cannot be opened and every call fails.
+ */
+class ResultStore
+{
+  public:
+    static constexpr int SCHEMA_VERSION = 1; //!< Version of the schema this build writes
+
+    /**
+     * Open or create a database and its tables.
+     *
+     * \param path the database file
+     */
+    explicit ResultStore(const std::string& path)
+    {
+#ifdef HAVE_SQLITE3
+        if (sqlite3_open(path.c_str(), &m_db) != SQLITE_OK)
+        {
+            Fail("Cannot open " + path);
+            return;
+        }
+        sqlite3_busy_timeout(m_db, 10000);
+        Exec("PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL; PRAGMA foreign_keys=ON;"
+             "CREATE TABLE IF NOT EXISTS configs(hash TEXT PRIMARY KEY, description TEXT);"
+             "CREATE TABLE IF NOT EXISTS runs(id INTEGER PRIMARY KEY, started TEXT, program "
+             "TEXT, source TEXT, configHash TEXT REFERENCES configs(hash));"
+             "CREATE TABLE IF NOT EXISTS points(id INTEGER PRIMARY KEY, run INTEGER NOT NULL "
+             "REFERENCES runs(id), model TEXT, phy TEXT, distance REAL, seed INTEGER, maxAmpduSize "
+             "INTEGER, maxAmsduSize INTEGER, blockAckThreshold INTEGER, blockAckInactivityTimeout "
+             "INTEGER, hops INTEGER, clients INTEGER, transport TEXT, congestionControl TEXT, "
+             "segmentSize INTEGER, configHash TEXT, rss REAL, throughput REAL, goodput REAL, "
+             "rxBytes INTEGER, rxPackets INTEGER, connectionLost INTEGER, retransmissions INTEGER, "
+             "retryLimitDrops INTEGER, queueDrops INTEGER, backoffs INTEGER, backoffSlots INTEGER, "
+             "mcsChanges INTEGER, mcs0 INTEGER, mcs1 INTEGER, mcs2 INTEGER, mcs3 INTEGER, mcs4 "
+             "INTEGER, mcs5 INTEGER, mcs6 INTEGER, mcs7 INTEGER);"
+             "CREATE INDEX IF NOT EXISTS pointsModel ON points(model);"
+             "CREATE INDEX IF NOT EXISTS pointsDistance ON points(distance);"
+             "CREATE INDEX IF NOT EXISTS pointsSeed ON points(seed);"
+             "CREATE INDEX IF NOT EXISTS pointsConfig ON points(configHash);"
+             "CREATE TABLE IF NOT EXISTS timing(point INTEGER PRIMARY KEY REFERENCES "
+             "points(id), events INTEGER, runSeconds REAL, wallSeconds REAL, peakRssKb "
+             "INTEGER);"
+             "CREATE TABLE IF NOT EXISTS flows(point INTEGER NOT NULL REFERENCES points(id), "
+             "flow INTEGER, txBytes INTEGER, rxBytes INTEGER, txPackets INTEGER, rxPackets "
+             "INTEGER, lostPackets INTEGER, delaySum REAL, jitterSum REAL);"
+             "CREATE INDEX IF NOT EXISTS flowsPoint ON flows(point);"
+             "CREATE TABLE IF NOT EXISTS runtime(run INTEGER NOT NULL REFERENCES runs(id), "
+             "simulationTime REAL, rss REAL, throughput REAL);");
+        CheckVersion();
+        m_insertPoint = Prepare(
+            "INSERT INTO points(run, model, phy, distance, seed, maxAmpduSize, maxAmsduSize, "
+            "blockAckThreshold, blockAckInactivityTimeout, hops, clients, transport, "
+            "congestionControl, segmentSize, configHash, rss, throughput, goodput, rxBytes, "
+            "rxPackets, connectionLost, retransmissions, retryLimitDrops, queueDrops, backoffs, "
+            "backoffSlots, mcsChanges, mcs0, mcs1, mcs2, mcs3, mcs4, mcs5, mcs6, mcs7) "
+            "VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, "
+            "?, ?, ?, ?, ?, ?, ?, ?, ?)");
+        m_insertTiming = Prepare("INSERT INTO timing(point, events, runSeconds, wallSeconds, "
+                                 "peakRssKb) VALUES(?, ?, ?, ?, ?)");
+        m_insertFlow = Prepare("INSERT INTO flows(point, flow, txBytes, rxBytes, txPackets, "
+                               "rxPackets, lostPackets, delaySum, jitterSum) "
+                               "VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?)");
+        m_insertRuntime = Prepare("INSERT INTO runtime(run, simulationTime, rss, throughput) "
+                                  "VALUES(?, ?, ?, ?)");
+#else
+        Fail("Built without SQLite, cannot open " + path);
+#endif
+    }
+
+    ~ResultStore()
+    {
+#ifdef HAVE_SQLITE3
+        for (sqlite3_stmt* statement :
+             {m_insertPoint, m_insertTiming, m_insertFlow, m_insertRuntime})
+        {
+            sqlite3_finalize(statement);
+        }
+        sqlite3_close(m_db);
+#endif
+    }
+
+    ResultStore(const ResultStore&) = delete;
+    ResultStore& operator=(const ResultStore&) = delete;
+
+    /**
+     * \return whether every call so far succeeded
+     */
+    bool Ok() const
+    {
+        return m_error.empty();
+    }
+
+    /**
+     * \return a description of the first failure
+     */
+    const std::string& Error() const
+    {
+        return m_error;
+    }
+
+    bool Begin()
+    {
+        return Exec("BEGIN");
+    }
+
+    bool Commit()
+    {
+        return Exec("COMMIT");
+    }
+
+    /**
+     * Start a run. Call it outside of a transaction, so that the run is stored even if
+     * none of its points are.
+     *
+     * \param program the program that produced the results
+     * \param source the command line, or the file the results are imported from
+     * \param configHash the hash of the configuration, empty if unknown
+     * \param configDescription what the hash was computed from, empty if unknown
+     * \return whether the run could be stored
+     */
+    bool BeginRun(const std::string& program,
+                  const std::string& source,
+                  const std::string& configHash,
+                  const std::string& configDescription)
+    {
+#ifdef HAVE_SQLITE3
+        if (!Ok())
+        {
+            return false;
+        }
+        if (!configHash.empty())
+        {
+            sqlite3_stmt* config =
+                Prepare("INSERT OR IGNORE INTO configs(hash, description) VALUES(?, ?)");
+            Bind(config, 1, configHash);
+            Bind(config, 2, configDescription);
+            Step(config);
+            sqlite3_finalize(config);
+        }
+        sqlite3_stmt* run = Prepare("INSERT INTO runs(started, program, source, configHash) "
+                                    "VALUES(datetime('now'), ?, ?, ?)");
+        Bind(run, 1, program);
+        Bind(run, 2, source);
+        Bind(run, 3, configHash.empty() ? std::optional<std::string>() : configHash);
+        Step(run);
+        sqlite3_finalize(run);
+        m_run = sqlite3_last_insert_rowid(m_db);
+#endif
+        return Ok();
+    }
+
+    /**
+     * Store a point of the current run with its timing and flows.
+     */
+    bool InsertPoint(const StoredPoint& point)
+    {
+#ifdef HAVE_SQLITE3
+        if (!Ok())
+        {
+            return false;
+        }
+        sqlite3_stmt* s = m_insertPoint;
+        int column = 1;
+        Bind(s, column++, m_run);
+        Bind(s, column++, point.model);
+        Bind(s, column++, point.phy);
+        Bind(s, column++, point.distance);
+        Bind(s, column++, point.seed);
+        Bind(s, column++, point.maxAmpduSize);
+        Bind(s, column++, point.maxAmsduSize);
+        Bind(s, column++, point.blockAckThreshold);
+        Bind(s, column++, point.blockAckInactivityTimeout);
+        Bind(s, column++, point.hops);
+        Bind(s, column++, point.clients);
+        Bind(s, column++, point.transport);
+        Bind(s, column++, point.congestionControl);
+        Bind(s, column++, point.segmentSize);
+        Bind(s,
+             column++,
+             point.configHash.empty() ? std::optional<std::string>() : point.configHash);
+        Bind(s, column++, point.rss);
+        Bind(s, column++, point.throughput);
+        Bind(s, column++, point.goodput);
+        Bind(s, column++, point.rxBytes);
+        Bind(s, column++, point.rxPackets);
+        Bind(s, column++, point.connectionLost);
+        if (point.mac)
+        {
+            const StoredMac& mac = *point.mac;
+            for (uint64_t counter : {mac.retransmissions,
+                                     mac.retryLimitDrops,
+                                     mac.queueDrops,
+                                     mac.backoffs,
+                                     mac.backoffSlots,
+                                     mac.mcsChanges})
+            {
+                Bind(s, column++, counter);
+            }
+            for (uint64_t count : mac.mcsHistogram)
+            {
+                Bind(s, column++, count);
+            }
+        }
+        Step(s);
+        sqlite3_int64 id = sqlite3_last_insert_rowid(m_db);
+
+        if (point.timing)
+        {
+            Bind(m_insertTiming, 1, id);
+            Bind(m_insertTiming, 2, point.timing->events);
+            Bind(m_insertTiming, 3, point.timing->runSeconds);
+            Bind(m_insertTiming, 4, point.timing->wallSeconds);
+            Bind(m_insertTiming, 5, point.timing->peakRssKb);
+            Step(m_insertTiming);
+        }
+        for (const StoredFlow& flow : point.flows)
+        {
+            Bind(m_insertFlow, 1, id);
+            Bind(m_insertFlow, 2, flow.flowId);
+            Bind(m_insertFlow, 3, flow.txBytes);
+            Bind(m_insertFlow, 4, flow.rxBytes);
+            Bind(m_insertFlow, 5, flow.txPackets);
+            Bind(m_insertFlow, 6, flow.rxPackets);
+            Bind(m_insertFlow, 7, flow.lostPackets);
+            Bind(m_insertFlow, 8, flow.delaySum);
+            Bind(m_insertFlow, 9, flow.jitterSum);
+            Step(m_insertFlow);
+        }
+#endif
+        return Ok();
+    }
+
+    /**
+     * Store a row of the simulation time sweep of wifi-runtime-comparison.
+     */
+    bool InsertRuntime(double simulationTime, double rss, double throughput)
+    {
+#ifdef HAVE_SQLITE3
+        if (!Ok())
+        {
+            return false;
+        }
+        Bind(m_insertRuntime, 1, m_run);
+        Bind(m_insertRuntime, 2, simulationTime);
+        Bind(m_insertRuntime, 3, rss);
+        Bind(m_insertRuntime, 4, throughput);
+        Step(m_insertRuntime);
+#endif
+        return Ok();
+    }
+
+  private:
+    void Fail(const std::string& error)
+    {
+        if (m_error.empty())
+        {
+            m_error = error;
+        }
+    }
+
+#ifdef HAVE_SQLITE3
+    bool Exec(const char* sql)
+    {
+        char* message = nullptr;
+        if (Ok() && sqlite3_exec(m_db, sql, nullptr, nullptr, &message) != SQLITE_OK)
+        {
+            Fail(std::string("SQLite: ") + (message ? message : sqlite3_errmsg(m_db)));
+        }
+        sqlite3_free(message);
+        return Ok();
+    }
+
+    /**
+     * Record SCHEMA_VERSION in a new database, and refuse one written with another schema.
+     */
+    void CheckVersion()
+    {
+        sqlite3_stmt* version = Prepare("PRAGMA user_version");
+        int stored = version && sqlite3_step(version) == SQLITE_ROW
+                         ? sqlite3_column_int(version, 0)
+                         : SCHEMA_VERSION;
+        sqlite3_finalize(version);
+        if (!Ok() || stored == SCHEMA_VERSION)
+        {
+            return;
+        }
+        if (stored != 0)
+        {
+            Fail("The database has schema version " + std::to_string(stored) + ", not " +
+                 std::to_string(SCHEMA_VERSION));
+            return;
+        }
+        std::string sql = "PRAGMA user_version = " + std::to_string(SCHEMA_VERSION);
+        Exec(sql.c_str());
+    }
+
+    sqlite3_stmt* Prepare(const char* sql)
+    {
+        sqlite3_stmt* statement = nullptr;
+        if (Ok() && sqlite3_prepare_v2(m_db, sql, -1, &statement, nullptr) != SQLITE_OK)
+        {
+            Fail(std::string("SQLite: ") + sqlite3_errmsg(m_db));
+        }
+        return statement;
+    }
+
+    /**
+     * Run a statement that returns no rows and reset it. A null statement is one that could
+     * not be prepared, whose error is already stored.
+     */
+    void Step(sqlite3_stmt* statement)
+    {
+        if (!statement)
+        {
+            Fail("SQLite: statement was not prepared");
+            return;
+        }
+        if (Ok() && sqlite3_step(statement) != SQLITE_DONE)
+        {
+            Fail(std::string("SQLite: ") + sqlite3_errmsg(m_db));
+        }
+        sqlite3_reset(statement);
+        sqlite3_clear_bindings(statement);
+    }
+
+    void Bind(sqlite3_stmt* statement, int column, double value)
+    {
+        sqlite3_bind_double(statement, column, value);
+    }
+
+    void Bind(sqlite3_stmt* statement, int column, uint64_t value)
+    {
+        sqlite3_bind_int64(statement, column, sqlite3_int64(value));
+    }
+
+    void Bind(sqlite3_stmt* statement, int column, sqlite3_int64 value)
+    {
+        sqlite3_bind_int64(statement, column, value);
+    }
+
+    void Bind(sqlite3_stmt* statement, int column, uint32_t value)
+    {
+        sqlite3_bind_int64(statement, column, value);
+    }
+
+    void Bind(sqlite3_stmt* statement, int column, long value)
+    {
+        sqlite3_bind_int64(statement, column, value);
+    }
+
+    void Bind(sqlite3_stmt* statement, int column, bool value)
+    {
+        sqlite3_bind_int(statement, column, value);
+    }
+
+    void Bind(sqlite3_stmt* statement, int column, const std::string& value)
+    {
+        sqlite3_bind_text(statement, column, value.data(), value.size(), SQLITE_TRANSIENT);
+    }
+
+    /// Binds NULL for a missing value
+    template <typename T>
+    void Bind(sqlite3_stmt* statement, int column, const std::optional<T>& value)
+    {
+        if (value)
+        {
+            Bind(statement, column, *value);
+        }
+        else
+        {
+            sqlite3_bind_null(statement, column);
+        }
+    }
+
+    sqlite3* m_db = nullptr;                 //!< The database
+    sqlite3_stmt* m_insertPoint = nullptr;   //!< Prepared once, run for every point
+    sqlite3_stmt* m_insertTiming = nullptr;  //!< Prepared once, run for every point
+    sqlite3_stmt* m_insertFlow = nullptr;    //!< Prepared once, run for every flow
+    sqlite3_stmt* m_insertRuntime = nullptr; //!< Prepared once, run for every runtime row
+    sqlite3_int64 m_run = 0;                 //!< The current run
+#else
+    bool Exec(const char*)
+    {
+        return Ok();
+    }
+#endif
+    std::string m_error; //!< The first failure, empty if there was none
+};
+
+#endif /* RESULT_STORE_H */
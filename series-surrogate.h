@@ -0,0 +1,78 @@
+#ifndef SERIES_SURROGATE_H
+#define SERIES_SURROGATE_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+/**
+ * A value estimated from the simulated points of a series rather than simulated itself.
+ */
+struct SurrogateEstimate
+{
+    double value; //!< The estimate
+    double error; //!< Estimated absolute error, infinity if it cannot be estimated
+};
+
+/**
+ * Estimate a quantity at distance x from its values at the simulated distances of a
+ * series, by linear interpolation in log distance between the two distances around x.
+ * Path loss, and with it RSS, is close to linear in log distance for all the models of
+ * the sweep, so few points go a long way.
+ *
+ * The error is estimated by leaving one out: each of the two points around x that has
+ * simulated neighbours on both sides is predicted from those neighbours, and the larger
+ * miss is the estimate. Those predictions span about twice the interval of the actual
+ * one, so the estimate is on the safe side where the quantity is smooth, and grows where
+ * it is not, such as at the cutoff distance. Without such a neighbour the error is
+ * unknown. Nothing is extrapolated beyond the simulated distances.
+ *
+ * \param distances the simulated distances, ascending and positive
+ * \param values the quantity at each of them
+ * \param x the distance to estimate the quantity at
+ * \param estimate receives the estimate
+ * \return whether x lies within the simulated distances
+ */
+inline bool
+InterpolateSeries(const std::vector<double>& distances,
+                  const std::vector<double>& values,
+                  double x,
+                  SurrogateEstimate& estimate)
+{
+    if (distances.empty() || !(x >= distances.front()) || !(x <= distances.back()))
+    {
+        return false;
+    }
+    size_t high = std::lower_bound(distances.begin(), distances.end(), x) - distances.begin();
+    if (distances[high] == x)
+    {
+        estimate = {values[high], 0};
+        return true;
+    }
+    size_t low = high - 1;
+
+    auto interpolate = [&distances, &values](size_t a, size_t b, double at) {
+        double weight = std::log(at / distances[a]) / std::log(distances[b] / distances[a]);
+        return values[a] + weight * (values[b] - values[a]);
+    };
+    estimate.value = interpolate(low, high, x);
+
+    estimate.error = -1;
+    for (size_t point : {low, high})
+    {
+        if (point > 0 && point + 1 < distances.size())
+        {
+            double miss = std::fabs(interpolate(point - 1, point + 1, distances[point]) -
+                                    values[point]);
+            estimate.error = std::max(estimate.error, miss);
+        }
+    }
+    if (estimate.error < 0)
+    {
+        estimate.error = std::numeric_limits<double>::infinity();
+    }
+    return true;
+}
+
+#endif /* SERIES_SURROGATE_H */
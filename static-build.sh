@@ -0,0 +1,146 @@
+#!/usr/bin/env bash
+#
+# Build the scenarios as static, link-time optimised binaries that only link the ns-3
+# modules they need, optionally with profile-guided optimisation, and compare them with
+# the default shared build.
+#
+# Usage:
+#   NS3_DIR=/path/to/ns-3.39 ./static-build.sh build [--pgo]
+#   ./static-build.sh benchmark <shared-binary> <static-binary>
+#
+# The build configures a separate CMake build of ns-3 in $NS3_DIR/cmake-build-static
+# with its output in $NS3_DIR/build-static, so the default build is left untouched. The
+# sources of this repository are copied to $NS3_DIR/scratch unless they already live
+# there.
+
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+
+# wifi pulls in spectrum, propagation, mobility, antenna and network by itself; stats links
+# SQLite for the result store if ns-3 finds it
+MODULES="wifi;applications;internet;flow-monitor;stats"
+
+# Requests the PGO training run sends to the server mode: every loss model, each PHY type,
+# near and far from the cutoff
+TRAINING_REQUESTS=$(
+    for model in Friis FixedRSS ThreeLogDistance TwoRayGround Nakagami; do
+        for phy in Yans Spectrum Abstract; do
+            for distance in 10 150; do
+                echo "model=$model phy=$phy distance=$distance"
+            done
+        done
+    done
+)
+
+build_dir() {
+    echo "$NS3_DIR/cmake-build-static"
+}
+
+output_dir() {
+    echo "$NS3_DIR/build-static"
+}
+
+copy_sources() {
+    if [ "$SCRIPT_DIR" != "$NS3_DIR/scratch" ]; then
+        cp "$SCRIPT_DIR"/*.cc "$SCRIPT_DIR"/*.h "$NS3_DIR/scratch/"
+    fi
+}
+
+# configure_and_build <extra CXXFLAGS>
+configure_and_build() {
+    cmake -S "$NS3_DIR" -B "$(build_dir)" \
+        -DCMAKE_BUILD_TYPE=release \
+        -DNS3_OUTPUT_DIRECTORY="$(output_dir)" \
+        -DNS3_STATIC=ON \
+        -DNS3_LINK_TIME_OPTIMIZATION=ON \
+        -DNS3_ENABLED_MODULES="$MODULES" \
+        -DNS3_EXAMPLES=OFF \
+        -DNS3_TESTS=OFF \
+        -DCMAKE_CXX_FLAGS="$1"
+    cmake --build "$(build_dir)" -j"$(nproc)"
+}
+
+find_binary() {
+    find "$(output_dir)" -type f -perm -u+x -name "*$1*" | head -n 1
+}
+
+build() {
+    : "${NS3_DIR:?Set NS3_DIR to the ns-3 source tree}"
+    copy_sources
+
+    if [ "${1:-}" = "--pgo" ]; then
+        local profile_dir="$(build_dir)/profile"
+        rm -rf "$profile_dir"
+
+        echo "Building instrumented binaries"
+        # SWEEP_PROFILE_GENERATE makes the forked workers write their profile before exiting
+        configure_and_build "-fprofile-generate=$profile_dir -DSWEEP_PROFILE_GENERATE"
+
+        echo "Training on a short sweep"
+        echo "$TRAINING_REQUESTS" |
+            "$(find_binary wifi-propagation-comparison)" \
+                --serve=- --simulationTime=3 --jobs="$(nproc)" >/dev/null
+
+        echo "Building optimised binaries"
+        configure_and_build \
+            "-fprofile-use=$profile_dir -fprofile-partial-training -Wno-missing-profile"
+    else
+        configure_and_build ""
+    fi
+
+    echo "Static binaries:"
+    find_binary wifi-propagation-comparison
+    find_binary wifi-runtime-comparison
+}
+
+# startup_seconds <binary>: mean wall time of a run that exits right after initialising
+startup_seconds() {
+    local runs=20
+    local start end
+    start=$(date +%s.%N)
+    for _ in $(seq $runs); do
+        "$1" --serve=- --warmup=false </dev/null >/dev/null 2>&1
+    done
+    end=$(date +%s.%N)
+    echo "($end - $start) / $runs" | bc -l
+}
+
+# events_per_second <binary>: simulator events per second of a single longer point
+events_per_second() {
+    # The response is the request, a tab and the serialized result, whose 7th and 8th
+    # fields are the events executed and the seconds spent in Simulator::Run()
+    echo "model=Friis phy=Yans distance=10" |
+        "$1" --serve=- --warmup=false --simulationTime=20 2>/dev/null |
+        cut -f 2 | awk '{ printf "%.0f\n", $7 / $8 }'
+}
+
+benchmark() {
+    local shared="$1"
+    local static="$2"
+    local output="output_build_benchmark.csv"
+
+    echo "build,startupSeconds,eventsPerSecond" >"$output"
+    for build in shared static; do
+        local binary
+        if [ "$build" = shared ]; then binary="$shared"; else binary="$static"; fi
+        echo "Benchmarking the $build build"
+        echo "$build,$(startup_seconds "$binary"),$(events_per_second "$binary")" >>"$output"
+    done
+    cat "$output"
+}
+
+case "${1:-}" in
+build)
+    shift
+    build "$@"
+    ;;
+benchmark)
+    shift
+    benchmark "$@"
+    ;;
+*)
+    sed -n '2,14p' "$0"
+    exit 1
+    ;;
+esac
@@ -0,0 +1,305 @@
+#ifndef SWEEP_ANALYTIC_H
+#define SWEEP_ANALYTIC_H
+
+#include "abstract-wifi-phy.h"
+#include "dcf-saturation-model.h"
+#include "sweep-scenario.h"
+
+#include "ns3/core-module.h"
+#include "ns3/ht-phy.h"
+#include "ns3/ofdm-phy.h"
+#include "ns3/yans-wifi-helper.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <string>
+#include <vector>
+
+/**
+ * The stations of the analytic saturation model for a contention point.
+ */
+struct AnalyticStations
+{
+    std::vector<DcfStation> stations; // One per client
+    double meanMcs = 0;               // MCS of the clients, averaged over the samples
+};
+
+/**
+ * Derive the stations of the analytic saturation model from the links of the clients of a
+ * contention point to the server, placed as RunPoint places them. The received power of a
+ * link is sampled from the loss chain of the point's model, so that random fading is
+ * averaged over. For every sample, the MCS is the one IdealWifiManager picks from the SNR
+ * of the previous one, and the frame error rate comes from the 802.11n MCS tables of the
+ * TableBasedErrorRateModel, the error rate model of the PHY. A transmission fails if all
+ * MPDUs of its A-MPDU are lost.
+ *
+ * Frames follow the default aggregation settings as far as the maximum A-MPDU size, the
+ * block ack window and the maximum HT PPDU duration allow. A-MSDUs are not modelled.
+ *
+ * \param config the scenario configuration
+ * \param point the contention point
+ * \param samples the received power samples per link
+ * \param parameters the channel access parameters
+ * \return the stations
+ */
+inline AnalyticStations
+DeriveDcfStations(const ScenarioConfig& config,
+                  const SweepPoint& point,
+                  uint32_t samples,
+                  const DcfParameters& parameters)
+{
+    RngSeedManager::SetRun(point.seed);
+
+    YansWifiChannelHelper wifiChannel;
+    wifiChannel.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
+    AddPropagationLoss(wifiChannel, point.model, config);
+    PointerValue lossValue;
+    wifiChannel.Create()->GetAttribute("PropagationLossModel", lossValue);
+    Ptr<PropagationLossModel> loss = lossValue.Get<PropagationLossModel>();
+
+    // Thermal noise over the 40 MHz channel set by ConfigurePhy, as in AbstractWifiPhy, and
+    // the sensitivity below which the channel does not deliver a frame at all
+    const uint16_t channelWidth = 40;
+    Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy>();
+    DoubleValue noiseFigureDb;
+    phy->GetAttribute("RxNoiseFigure", noiseFigureDb);
+    const double noiseW = 1.3803e-23 * 290 * channelWidth * 1e6 * DbToRatio(noiseFigureDb.Get());
+    const double sensitivityDbm = phy->GetRxSensitivity();
+
+    // A UDP/IPv4 packet behind LLC/SNAP in a QoS data frame, and its A-MPDU subframe
+    const uint32_t mpduSize = config.packetSize + 8 + 20 + 8 + 26 + 4;
+    const uint32_t subframeSize = 4 + (mpduSize + 3) / 4 * 4;
+    const bool aggregate = point.aggregation.maxAmpduSize >= subframeSize;
+    const Time sifs = MicroSeconds(16);
+    const Time aifs = sifs + Seconds(3 * parameters.slotSeconds); // AIFSN 3 of best effort
+
+    struct McsEntry
+    {
+        WifiTxVector txVector;
+        double snrThreshold; // Lowest SNR IdealWifiManager picks the MCS at
+        uint32_t mpdus;      // MPDUs per PPDU
+        double busySeconds;  // PPDU, response and AIFS
+    };
+
+    Ptr<TableBasedErrorRateModel> errorModel = CreateObject<TableBasedErrorRateModel>();
+    std::vector<McsEntry> mcsTable;
+    for (uint8_t mcs = 0; mcs < 8; mcs++)
+    {
+        WifiMode mode = HtPhy::GetHtMcs(mcs);
+        WifiTxVector txVector(mode, 0, WIFI_PREAMBLE_HT_MF, 800, 1, 1, 0, channelWidth, aggregate);
+        uint32_t mpdus = 1;
+        if (aggregate)
+        {
+            // As many as fit the A-MPDU size, the block ack window and the maximum HT PPDU
+            // duration
+            mpdus = std::min<uint32_t>(point.aggregation.maxAmpduSize / subframeSize, 64);
+            Time maxPpduDuration = MicroSeconds(5484);
+            while (mpdus > 1 && WifiPhy::CalculateTxDuration(mpdus * subframeSize,
+                                                             txVector,
+                                                             WIFI_PHY_BAND_5GHZ) > maxPpduDuration)
+            {
+                mpdus--;
+            }
+        }
+
+        // The Ack or compressed BlockAck goes at the highest mandatory OFDM rate that does
+        // not exceed the non-HT reference rate of the data
+        uint64_t referenceRate = mode.GetNonHtReferenceRate();
+        WifiMode responseMode = referenceRate >= 24000000   ? OfdmPhy::GetOfdmRate24Mbps()
+                                : referenceRate >= 12000000 ? OfdmPhy::GetOfdmRate12Mbps()
+                                                            : OfdmPhy::GetOfdmRate6Mbps();
+        WifiTxVector responseVector(responseMode, 0, WIFI_PREAMBLE_LONG, 800, 1, 1, 0, 20, false);
+
+        Time busy =
+            WifiPhy::CalculateTxDuration(aggregate ? mpdus * subframeSize : mpduSize,
+                                         txVector,
+                                         WIFI_PHY_BAND_5GHZ) +
+            sifs +
+            WifiPhy::CalculateTxDuration(aggregate ? 32 : 14, responseVector, WIFI_PHY_BAND_5GHZ) +
+            aifs;
+        // 1e-6 is the default BER IdealWifiManager picks the MCS for
+        double snrThreshold = errorModel->CalculateSnr(txVector, 1e-6);
+        mcsTable.push_back({txVector, snrThreshold, mpdus, busy.GetSeconds()});
+    }
+
+    Ptr<MobilityModel> server = CreateObject<ConstantPositionMobilityModel>();
+    server->SetPosition(Vector(0.0, 0.0, config.antennaZ));
+
+    // The loss models of the sweep only depend on the positions of the two ends, and the
+    // clients all sit at the same distance from the server, so links are derived once per
+    // distance
+    AnalyticStations result;
+    std::map<int64_t, DcfStation> links;
+    double mcsSum = 0;
+    for (uint32_t i = 0; i < point.clients; i++)
+    {
+        double angle = 2 * M_PI * i / point.clients;
+        Ptr<MobilityModel> client = CreateObject<ConstantPositionMobilityModel>();
+        client->SetPosition(Vector(point.distance * std::cos(angle),
+                                   point.distance * std::sin(angle),
+                                   config.antennaZ));
+        int64_t key = std::llround(client->GetDistanceFrom(server) * 1e6);
+        auto link = links.find(key);
+        if (link == links.end())
+        {
+            DcfStation station{0, 0, 0};
+            uint32_t mcs = 0;
+            for (uint32_t sample = 0; sample <= samples; sample++)
+            {
+                double rxPowerDbm =
+                    loss->CalcRxPower(config.txPower + config.txGain, client, server) +
+                    config.rxGain;
+                double snr = DbmToW(rxPowerDbm) / noiseW;
+                // The first sample only picks the MCS of the next one
+                if (sample > 0)
+                {
+                    const McsEntry& entry = mcsTable[mcs];
+                    double per = rxPowerDbm < sensitivityDbm
+                                     ? 1
+                                     : 1 - errorModel->GetChunkSuccessRate(
+                                               entry.txVector.GetMode(),
+                                               entry.txVector,
+                                               snr,
+                                               mpduSize * 8);
+                    station.errorProbability += std::pow(per, entry.mpdus);
+                    station.busySeconds += entry.busySeconds;
+                    station.deliveredBits += entry.mpdus * (1 - per) * config.packetSize * 8;
+                    mcsSum += mcs;
+                }
+                mcs = 0;
+                while (mcs + 1 < mcsTable.size() && snr >= mcsTable[mcs + 1].snrThreshold)
+                {
+                    mcs++;
+                }
+            }
+            station.errorProbability /= samples;
+            station.busySeconds /= samples;
+            station.deliveredBits /= samples;
+            link = links.emplace(key, station).first;
+        }
+        result.stations.push_back(link->second);
+    }
+    result.meanMcs = mcsSum / samples / links.size();
+    return result;
+}
+
+/**
+ * Evaluate the analytic saturation model, see SolveDcfSaturation, for the points of the
+ * contention benchmark and write the aggregate and per-client throughput with the cost of
+ * deriving the links and of solving the model to output_contention_analytic.csv.
+ *
+ * Given the simulated results of the same points, the two are compared in
+ * output_analytic_validation.csv, and the least squares factor that scales the analytic
+ * throughput to the simulated one is reported as a calibration of the model.
+ *
+ * \param config the scenario configuration
+ * \param points the contention points
+ * \param samples the received power samples per link
+ * \param simulated the simulated results of the points, or none
+ */
+inline void
+RunAnalyticContention(const ScenarioConfig& config,
+                      const std::vector<SweepPoint>& points,
+                      uint32_t samples,
+                      const std::vector<PointResult>& simulated)
+{
+    NS_ABORT_MSG_IF(config.antenna != "Isotropic", "Contending clients need isotropic antennas");
+    NS_ABORT_MSG_IF(config.interferers > 0 || config.placement,
+                    "The analytic contention model has no background interference");
+    NS_ABORT_MSG_IF(samples < 1, "The analytic contention model needs at least one sample");
+
+    const DcfParameters parameters;
+    std::ofstream analyticFile("output_contention_analytic.csv");
+    analyticFile << "model,distanceMeters,clients,mcs,throughputKbps,minClientKbps,maxClientKbps,"
+                    "fairness,transmitProbability,failureProbability,dropProbability,"
+                    "collisionProbability,iterations,linkMicroseconds,solveMicroseconds\n";
+    std::ofstream validationFile;
+    if (!simulated.empty())
+    {
+        validationFile.open("output_analytic_validation.csv");
+        validationFile << "model,distanceMeters,clients,simulatedKbps,analyticKbps,errorPercent,"
+                          "wallSeconds,analyticMicroseconds,speedup\n";
+    }
+
+    double errorSum = 0;
+    double products = 0;
+    double squares = 0;
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        const SweepPoint& point = points[i];
+        std::string model = propagationModelToString(point.model);
+
+        auto start = std::chrono::steady_clock::now();
+        AnalyticStations stations = DeriveDcfStations(config, point, samples, parameters);
+        auto derived = std::chrono::steady_clock::now();
+        DcfSolution solution = SolveDcfSaturation(stations.stations, parameters);
+        auto solved = std::chrono::steady_clock::now();
+        NS_ABORT_MSG_IF(!solution.converged,
+                        "The analytic model of " << FormatRequest(point) << " did not converge");
+
+        double linkMicroseconds =
+            std::chrono::duration<double, std::micro>(derived - start).count();
+        double solveMicroseconds =
+            std::chrono::duration<double, std::micro>(solved - derived).count();
+        double throughput = solution.totalThroughput / 1024; // Kbps
+        double sum = 0;
+        double squareSum = 0;
+        for (double clientThroughput : solution.throughput)
+        {
+            sum += clientThroughput;
+            squareSum += clientThroughput * clientThroughput;
+        }
+        double fairness = squareSum > 0 ? sum * sum / (solution.throughput.size() * squareSum) : 0;
+        auto mean = [](const std::vector<double>& values) {
+            return std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+        };
+
+        analyticFile << model << "," << point.distance << "," << point.clients << ","
+                     << stations.meanMcs << "," << throughput << ","
+                     << *std::min_element(solution.throughput.begin(), solution.throughput.end()) /
+                            1024
+                     << ","
+                     << *std::max_element(solution.throughput.begin(), solution.throughput.end()) /
+                            1024
+                     << "," << fairness << "," << mean(solution.transmitProbability) << ","
+                     << mean(solution.failureProbability) << ","
+                     << mean(solution.dropProbability) << "," << solution.collisionProbability
+                     << "," << solution.iterations << "," << linkMicroseconds << ","
+                     << solveMicroseconds << "\n";
+        NS_LOG_UNCOND(model << " with " << point.clients << " clients at " << point.distance
+                            << "m: " << throughput << " Kbps analytically, solved in "
+                            << solveMicroseconds << " us");
+
+        if (!simulated.empty())
+        {
+            // The simulated clients send from 2 s on, but their throughput is averaged
+            // over the whole simulation time
+            double analytic = throughput * (config.simulationTime - 2) / config.simulationTime;
+            double simulatedThroughput = simulated[i].throughput;
+            double errorPercent = simulatedThroughput > 0
+                                      ? 100 * (analytic - simulatedThroughput) / simulatedThroughput
+                                      : 0;
+            double analyticMicroseconds = linkMicroseconds + solveMicroseconds;
+            validationFile << model << "," << point.distance << "," << point.clients << ","
+                           << simulatedThroughput << "," << analytic << "," << errorPercent << ","
+                           << simulated[i].wallSeconds << "," << analyticMicroseconds << ","
+                           << simulated[i].wallSeconds * 1e6 / analyticMicroseconds << "\n";
+            errorSum += std::fabs(errorPercent);
+            products += analytic * simulatedThroughput;
+            squares += analytic * analytic;
+        }
+    }
+
+    if (!simulated.empty() && squares > 0)
+    {
+        NS_LOG_UNCOND("Analytic model: mean absolute error " << errorSum / points.size()
+                                                             << " %, calibration factor "
+                                                             << products / squares);
+    }
+}
+
+#endif /* SWEEP_ANALYTIC_H */
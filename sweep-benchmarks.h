@@ -0,0 +1,627 @@
+#ifndef SWEEP_BENCHMARKS_H
+#define SWEEP_BENCHMARKS_H
+
+#include "cpu-placement.h"
+#include "fast-math.h"
+#include "node-placement.h"
+#include "sweep-executor.h"
+#include "sweep-scenario.h"
+
+#include "ns3/core-module.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/parabolic-antenna-model.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Compare the task throughput of forked pre-warmed workers with starting a new process
+ * for every task, as a batch system launching one scenario binary per point would, and
+ * write the result to output_server_benchmark.csv.
+ *
+ * The new processes run this program in server mode with the same command line, minus
+ * the benchmark option, and are handed a single request on stdin. They are started
+ * directly from this process, and a task fails if its response reports an error.
+ */
+inline void
+RunServerBenchmark(int argc,
+                   char* argv[],
+                   uint32_t tasks,
+                   unsigned jobs,
+                   const std::function<std::string(const std::string&)>& handleRequest)
+{
+    const std::string request = "model=Friis phy=Yans distance=10";
+
+    std::vector<std::string> processArgs = {"/proc/self/exe"};
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.find("--benchmarkServer") != 0 && arg.find("--serve") != 0)
+        {
+            processArgs.push_back(arg);
+        }
+    }
+    processArgs.push_back("--serve=-");
+    processArgs.push_back("--warmup=false");
+    // The workers resolve /proc/self/exe to themselves, so resolve it here
+    char path[4096];
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    NS_ABORT_MSG_IF(length < 0, "Cannot resolve the path of this program");
+    processArgs[0] = std::string(path, length);
+
+    std::ofstream benchmarkFile("output_server_benchmark.csv");
+    benchmarkFile << "mode,tasks,jobs,wallSeconds,tasksPerSecond\n";
+
+    for (const std::string mode : {"forkedWorker", "processPerTask"})
+    {
+        NS_LOG_UNCOND("Benchmarking " << tasks << " tasks with " << mode);
+        auto start = std::chrono::steady_clock::now();
+        std::vector<TaskOutcome> outcomes;
+        if (mode == "forkedWorker")
+        {
+            outcomes = RunTasks(tasks, [&](size_t) { return handleRequest(request); }, jobs);
+        }
+        else
+        {
+            outcomes = RunWorkers(
+                tasks,
+                [&](size_t, const std::vector<int>& inheritedFds, size_t slot) {
+                    return StartProgram(processArgs, request + "\n", inheritedFds, slot);
+                },
+                jobs);
+        }
+        double wallSeconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        for (const TaskOutcome& outcome : outcomes)
+        {
+            // A server responds with the request, a tab and the result or "error"
+            bool failed = !outcome.succeeded || outcome.output.empty();
+            if (mode == "processPerTask" && !failed)
+            {
+                size_t tab = outcome.output.find('\t');
+                failed = tab == std::string::npos || outcome.output.substr(tab + 1) == "error\n";
+            }
+            NS_ABORT_MSG_IF(failed, "Benchmark task failed with " << mode);
+        }
+        benchmarkFile << mode << "," << tasks << "," << jobs << "," << wallSeconds << ","
+                      << tasks / wallSeconds << "\n";
+    }
+}
+
+/**
+ * Run a fixed sweep of Friis points with the Yans PHY under every pinning policy, with 1,
+ * 2, 4, ... up to maxJobs workers, and write the throughput in simulated seconds per wall
+ * second, in total, per worker and per physical core used, to
+ * output_pinning_benchmark.csv. The physical policy skips the worker counts above the
+ * number of cores, which it could only place by sharing cores.
+ */
+inline void
+RunPinningBenchmark(ResultRing& ring,
+                    uint32_t tasks,
+                    unsigned maxJobs,
+                    const ScenarioConfig& config)
+{
+    std::vector<SweepPoint> points;
+    for (uint32_t i = 0; i < tasks; i++)
+    {
+        points.push_back({FRIIS, YANS, AggregationConfig(), 1.0 + i});
+    }
+
+    std::vector<unsigned> jobCounts;
+    for (unsigned jobs = 1; jobs < maxJobs; jobs *= 2)
+    {
+        jobCounts.push_back(jobs);
+    }
+    jobCounts.push_back(maxJobs);
+
+    std::vector<CpuInfo> topology = ReadCpuTopology();
+    std::ofstream benchmarkFile("output_pinning_benchmark.csv");
+    benchmarkFile << "policy,jobs,tasks,wallSeconds,simSecondsPerWallSecond,"
+                     "simSecondsPerWallSecondPerWorker,physicalCores,"
+                     "simSecondsPerWallSecondPerCore\n";
+
+    for (const std::string policy : {"none", "compact", "spread", "physical"})
+    {
+        WorkerCpus() = PlacementOrder(policy, topology);
+        for (unsigned jobs : jobCounts)
+        {
+            if (policy == "physical" && jobs > WorkerCpus().size())
+            {
+                NS_LOG_UNCOND("Skipping " << jobs << " physical workers, there are only "
+                                          << WorkerCpus().size() << " cores");
+                continue;
+            }
+            NS_LOG_UNCOND("Benchmarking " << tasks << " tasks with " << jobs << " " << policy
+                                          << " workers");
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::optional<PointResult>> results = RunPoints(ring, points, config, jobs);
+            double wallSeconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            for (const std::optional<PointResult>& result : results)
+            {
+                NS_ABORT_MSG_IF(!result, "Benchmark task failed with " << policy << " pinning");
+            }
+
+            double throughput = tasks * config.simulationTime / wallSeconds;
+            benchmarkFile << policy << "," << jobs << "," << tasks << "," << wallSeconds << ","
+                          << throughput << "," << throughput / jobs << ",";
+            size_t cores = PhysicalCoresUsed(WorkerCpus(), jobs, topology);
+            if (cores > 0)
+            {
+                benchmarkFile << cores << "," << throughput / cores;
+            }
+            else
+            {
+                benchmarkFile << ",";
+            }
+            benchmarkFile << "\n";
+        }
+    }
+    WorkerCpus().clear();
+}
+
+/**
+ * The points of the contention benchmark: the given numbers of clients at each of the
+ * distances, for every model.
+ */
+inline std::vector<SweepPoint>
+ContentionPoints(const std::vector<PropagationModel>& models,
+                 PhyType phy,
+                 const std::vector<double>& distances,
+                 const std::vector<uint32_t>& clientCounts)
+{
+    std::vector<SweepPoint> points;
+    for (PropagationModel model : models)
+    {
+        for (double distance : distances)
+        {
+            for (uint32_t clients : clientCounts)
+            {
+                SweepPoint point{model, phy, AggregationConfig(), distance};
+                point.clients = clients;
+                points.push_back(point);
+            }
+        }
+    }
+    return points;
+}
+
+/**
+ * Simulate the points of the contention benchmark, every client sending fast enough to
+ * saturate the link on its own, and write the aggregate throughput, the spread of the
+ * throughput over the clients, the frames the server lost and the MAC retries, together
+ * with the cost of the simulation, to output_contention.csv, and the throughput of every
+ * client to output_contention_clients.csv.
+ *
+ * \return the results of the points
+ */
+inline std::vector<PointResult>
+RunContentionBenchmark(ResultRing& ring,
+                       ScenarioConfig config,
+                       const std::vector<SweepPoint>& points,
+                       double clientDataRate,
+                       unsigned jobs)
+{
+    NS_ABORT_MSG_IF(config.antenna != "Isotropic", "Contending clients need isotropic antennas");
+    config.dataRate = clientDataRate;
+
+    std::vector<std::vector<StoredFlow>> flows(points.size());
+    std::vector<std::optional<PointResult>> results =
+        RunPoints(ring,
+                  points,
+                  config,
+                  jobs,
+                  nullptr,
+                  [&flows](size_t task, const StoredFlow* taskFlows, size_t count) {
+                      flows[task].insert(flows[task].end(), taskFlows, taskFlows + count);
+                  });
+
+    std::ofstream benchmarkFile("output_contention.csv");
+    benchmarkFile << "model,distanceMeters,clients,throughputKbps,minClientKbps,maxClientKbps,"
+                     "fairness,starvedClients,retransmissions,retryLimitDrops,rxErrors,rxDrops,"
+                     "backoffs,events,runSeconds,eventsPerSecond,wallSeconds,peakRssKb\n";
+    std::ofstream clientFile("output_contention_clients.csv");
+    clientFile << "model,distanceMeters,clients,flow,throughputKbps,txPackets,rxPackets,"
+                  "lostPackets,meanDelaySeconds\n";
+    std::vector<PointResult> pointResults;
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        const SweepPoint& point = points[i];
+        NS_ABORT_MSG_IF(!results[i], "Contention point " << FormatRequest(point) << " failed");
+        const PointResult& result = *results[i];
+        pointResults.push_back(result);
+        std::string model = propagationModelToString(point.model);
+
+        // Every client is one flow. Clients without a flow never got a packet out and
+        // count as starved with no throughput
+        std::vector<double> throughputs(point.clients, 0);
+        for (size_t f = 0; f < flows[i].size() && f < throughputs.size(); f++)
+        {
+            const StoredFlow& flow = flows[i][f];
+            throughputs[f] = flow.rxBytes * 8.0 / config.simulationTime / 1024; // Kbps
+            clientFile << model << "," << point.distance << "," << point.clients << ","
+                       << flow.flowId << "," << throughputs[f] << "," << flow.txPackets << ","
+                       << flow.rxPackets << "," << flow.lostPackets << ",";
+            if (flow.rxPackets > 0)
+            {
+                clientFile << flow.delaySum / flow.rxPackets;
+            }
+            clientFile << "\n";
+        }
+
+        double sum = 0;
+        double squares = 0;
+        for (double throughput : throughputs)
+        {
+            sum += throughput;
+            squares += throughput * throughput;
+        }
+        // Jain's fairness index: 1 if all clients get the same throughput, 1/K if one gets all
+        double fairness = squares > 0 ? sum * sum / (throughputs.size() * squares) : 0;
+        size_t starved = std::count(throughputs.begin(), throughputs.end(), 0.0);
+        double eventsPerSecond = result.runSeconds > 0 ? result.events / result.runSeconds : 0;
+
+        benchmarkFile << model << "," << point.distance << "," << point.clients << ","
+                      << result.throughput << ","
+                      << *std::min_element(throughputs.begin(), throughputs.end()) << ","
+                      << *std::max_element(throughputs.begin(), throughputs.end()) << ","
+                      << fairness << "," << starved << "," << result.mac.retransmissions << ","
+                      << result.mac.retryLimitDrops << "," << result.rxErrors << ","
+                      << result.rxDrops << "," << result.mac.backoffs << "," << result.events
+                      << "," << result.runSeconds << "," << eventsPerSecond << ","
+                      << result.wallSeconds << "," << result.peakRssKb << "\n";
+        NS_LOG_UNCOND(model << " with " << point.clients << " clients at " << point.distance
+                            << "m: " << result.throughput << " Kbps, fairness " << fairness
+                            << ", " << eventsPerSecond << " events/s, " << result.wallSeconds
+                            << " s");
+    }
+    return pointResults;
+}
+
+/**
+ * Measure the setup time of placing the given number of nodes from a position file with
+ * antenna heights and transmit powers: parsed line by line into a ListPositionAllocator
+ * and installed by the MobilityHelper, as two-node scenarios place their nodes; loaded
+ * as CSV or binary NodePlacement and installed by the MobilityHelper through a
+ * PlacementPositionAllocator; and loaded from the binary file and installed in bulk.
+ * Writes the files to placement_benchmark.csv and .rtab, and the times to
+ * output_placement_benchmark.csv.
+ */
+inline void
+RunPlacementBenchmark(const ScenarioConfig& config, uint32_t nodes, unsigned threads)
+{
+    const std::vector<std::string> columns = {"x", "y", "antennaHeight", "txPower"};
+    Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable>();
+    std::vector<double> values;
+    std::ofstream csvFile("placement_benchmark.csv");
+    csvFile << std::setprecision(17) << "x,y,antennaHeight,txPower\n";
+    for (uint32_t i = 0; i < nodes; i++)
+    {
+        double row[] = {random->GetValue(-1000, 1000),
+                        random->GetValue(-1000, 1000),
+                        random->GetValue(1, 30),
+                        random->GetValue(0, 20)};
+        values.insert(values.end(), std::begin(row), std::end(row));
+        csvFile << row[0] << "," << row[1] << "," << row[2] << "," << row[3] << "\n";
+    }
+    csvFile.close();
+    NS_ABORT_MSG_IF(!WriteNodePlacement("placement_benchmark.rtab", columns, values),
+                    "Cannot write placement_benchmark.rtab");
+
+    std::ofstream benchmarkFile("output_placement_benchmark.csv");
+    benchmarkFile << "method,nodes,loadSeconds,validateSeconds,installSeconds,totalSeconds\n";
+    std::vector<Vector> reference;
+    auto measure = [&](const std::string& method,
+                       const std::function<Ptr<NodePlacement>()>& load,
+                       const std::function<void(NodeContainer&, Ptr<NodePlacement>)>& install) {
+        NodeContainer container;
+        container.Create(nodes);
+        auto start = std::chrono::steady_clock::now();
+        Ptr<NodePlacement> placement = load();
+        auto loaded = std::chrono::steady_clock::now();
+        std::string error;
+        NS_ABORT_MSG_IF(placement && !placement->Validate(Vector(-1e5, -1e5, -1e5),
+                                                          Vector(1e5, 1e5, 1e5),
+                                                          error),
+                        error);
+        auto validated = std::chrono::steady_clock::now();
+        install(container, placement);
+        auto installed = std::chrono::steady_clock::now();
+
+        // Every method has to place the nodes exactly where the first one did
+        for (uint32_t i = 0; i < nodes; i++)
+        {
+            Vector position = container.Get(i)->GetObject<MobilityModel>()->GetPosition();
+            if (reference.size() < nodes)
+            {
+                reference.push_back(position);
+            }
+            NS_ABORT_MSG_IF(position.x != reference[i].x || position.y != reference[i].y ||
+                                position.z != reference[i].z,
+                            method << " placed node " << i << " at " << position << " instead of "
+                                   << reference[i]);
+        }
+
+        double loadSeconds = std::chrono::duration<double>(loaded - start).count();
+        double validateSeconds = std::chrono::duration<double>(validated - loaded).count();
+        double installSeconds = std::chrono::duration<double>(installed - validated).count();
+        double totalSeconds = std::chrono::duration<double>(installed - start).count();
+        benchmarkFile << method << "," << nodes << "," << loadSeconds << "," << validateSeconds
+                      << "," << installSeconds << "," << totalSeconds << "\n";
+        NS_LOG_UNCOND(method << ": " << totalSeconds << " s (load " << loadSeconds
+                             << " s, validate " << validateSeconds << " s, install "
+                             << installSeconds << " s)");
+    };
+
+    Ptr<ListPositionAllocator> list;
+    measure(
+        "listAllocator",
+        [&]() -> Ptr<NodePlacement> {
+            list = CreateObject<ListPositionAllocator>();
+            std::ifstream file("placement_benchmark.csv");
+            std::string line;
+            std::getline(file, line);
+            while (std::getline(file, line))
+            {
+                std::replace(line.begin(), line.end(), ',', ' ');
+                std::istringstream stream(line);
+                double x;
+                double y;
+                double antennaHeight;
+                double txPower;
+                if (stream >> x >> y >> antennaHeight >> txPower)
+                {
+                    list->Add(Vector(x, y, antennaHeight));
+                }
+            }
+            return nullptr;
+        },
+        [&](NodeContainer& container, Ptr<NodePlacement>) {
+            MobilityHelper mobility;
+            mobility.SetPositionAllocator(list);
+            mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+            mobility.Install(container);
+        });
+
+    auto helperInstall = [&config](NodeContainer& container, Ptr<NodePlacement> placement) {
+        Ptr<PlacementPositionAllocator> allocator = CreateObject<PlacementPositionAllocator>();
+        allocator->SetPlacement(placement, config.antennaZ);
+        MobilityHelper mobility;
+        mobility.SetPositionAllocator(allocator);
+        mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+        mobility.Install(container);
+    };
+    auto bulkInstall = [&config](NodeContainer& container, Ptr<NodePlacement> placement) {
+        InstallPlacement(container, *placement, config.antennaZ);
+    };
+    measure(
+        "csvPlacement",
+        [threads]() { return Create<NodePlacement>("placement_benchmark.csv", threads); },
+        helperInstall);
+    measure(
+        "binaryPlacement",
+        []() { return Create<NodePlacement>("placement_benchmark.rtab"); },
+        helperInstall);
+    measure(
+        "binaryPlacementBulk",
+        []() { return Create<NodePlacement>("placement_benchmark.rtab"); },
+        bulkInstall);
+    Simulator::Destroy();
+}
+
+/**
+ * Measure the cost of the received power calculation per frame with isotropic antennas,
+ * with the gain table of the configured directional antenna, and with the antenna model
+ * evaluated analytically for every frame, and write it to output_antenna_benchmark.csv.
+ * An isotropic configuration is benchmarked with the parabolic antenna.
+ */
+inline void
+RunAntennaBenchmark(ScenarioConfig config, uint32_t calls)
+{
+    if (config.antenna == "Isotropic")
+    {
+        config.antenna = "Parabolic";
+    }
+
+    Ptr<MobilityModel> server = CreateObject<ConstantPositionMobilityModel>();
+    server->SetPosition(Vector(0, 0, config.antennaZ));
+    Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable>();
+    std::vector<Ptr<MobilityModel>> clients;
+    for (uint32_t i = 0; i < 1024; i++)
+    {
+        double angle = random->GetValue(0, 2 * M_PI);
+        double distance = random->GetValue(1, 500);
+        Ptr<MobilityModel> client = CreateObject<ConstantPositionMobilityModel>();
+        client->SetPosition(Vector(distance * std::cos(angle),
+                                   distance * std::sin(angle),
+                                   random->GetValue(0, 2 * config.antennaZ)));
+        clients.push_back(client);
+    }
+
+    Ptr<FriisPropagationLossModel> isotropic = CreateObject<FriisPropagationLossModel>();
+    Ptr<FriisPropagationLossModel> lookup = CreateObject<FriisPropagationLossModel>();
+    Ptr<AntennaGainLossModel> gains = CreateObject<AntennaGainLossModel>();
+    Ptr<AntennaGainTable> table = CreateAntennaGainTable(config);
+    gains->AddAntenna(server, table, 0);
+    for (const Ptr<MobilityModel>& client : clients)
+    {
+        gains->AddAntenna(client, table, M_PI);
+    }
+    lookup->SetNext(gains);
+
+    Ptr<ParabolicAntennaModel> serverAntenna = CreateObject<ParabolicAntennaModel>();
+    serverAntenna->SetAttribute("Beamwidth", DoubleValue(config.antennaBeamwidth));
+    Ptr<ParabolicAntennaModel> clientAntenna = CreateObject<ParabolicAntennaModel>();
+    clientAntenna->SetAttribute("Beamwidth", DoubleValue(config.antennaBeamwidth));
+    clientAntenna->SetAttribute("Orientation", DoubleValue(180));
+
+    std::map<std::string, std::function<double(Ptr<MobilityModel>)>> modes = {
+        {"isotropic",
+         [&](Ptr<MobilityModel> client) {
+             return isotropic->CalcRxPower(config.txPower, server, client);
+         }},
+        {"lookupTable",
+         [&](Ptr<MobilityModel> client) {
+             return lookup->CalcRxPower(config.txPower, server, client);
+         }},
+    };
+    if (config.antenna == "Parabolic")
+    {
+        modes["analytic"] = [&](Ptr<MobilityModel> client) {
+            Vector serverPosition = server->GetPosition();
+            Vector clientPosition = client->GetPosition();
+            return isotropic->CalcRxPower(config.txPower, server, client) +
+                   serverAntenna->GetGainDb(Angles(clientPosition, serverPosition)) +
+                   clientAntenna->GetGainDb(Angles(serverPosition, clientPosition));
+        };
+    }
+
+    std::map<std::string, double> nsPerCall;
+    for (const auto& [mode, calcRxPower] : modes)
+    {
+        double sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < calls; i++)
+        {
+            sum += calcRxPower(clients[i % clients.size()]);
+        }
+        nsPerCall[mode] =
+            std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+                .count() /
+            calls;
+        NS_LOG_UNCOND(mode << ": " << nsPerCall[mode] << " ns per frame (checksum " << sum
+                           << ")");
+    }
+
+    std::ofstream benchmarkFile("output_antenna_benchmark.csv");
+    benchmarkFile << "mode,antenna,calls,nsPerCall,overheadNsPerCall\n";
+    for (const auto& [mode, ns] : nsPerCall)
+    {
+        benchmarkFile << mode << "," << (mode == "isotropic" ? "Isotropic" : config.antenna)
+                      << "," << calls << "," << ns << "," << ns - nsPerCall["isotropic"]
+                      << "\n";
+    }
+}
+
+/**
+ * Stands in for a channel helper to create the loss model AddPropagationLoss would add
+ * to a channel, so that it can be called directly.
+ */
+struct LossModelCollector
+{
+    Ptr<PropagationLossModel> model;
+
+    template <typename... Args>
+    void AddPropagationLoss(const std::string& name, Args&&... args)
+    {
+        model = ObjectFactory(name, std::forward<Args>(args)...).Create<PropagationLossModel>();
+    }
+};
+
+/**
+ * Time calls of a function on the samples, summing its results so that the calls are not
+ * optimized away.
+ *
+ * \return the wall time per call in nanoseconds
+ */
+template <typename Function>
+inline double
+NsPerCall(const std::string& name, uint32_t calls, size_t samples, Function function)
+{
+    double sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < calls; i++)
+    {
+        sum += function(i % samples);
+    }
+    double nsPerCall =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+            .count() /
+        calls;
+    NS_LOG_UNCOND(name << ": " << nsPerCall << " ns per call (checksum " << sum << ")");
+    return nsPerCall;
+}
+
+/**
+ * Measure the cost of FastLog10 against log10, and of the received power calculation of
+ * the fast loss models against the reference ones, per call, with the largest difference
+ * seen, and write it to output_fastmath_benchmark.csv. The functions are called directly
+ * rather than through std::function, whose indirect call would cost as much as log10.
+ */
+inline void
+RunFastMathBenchmark(ScenarioConfig config, uint32_t calls)
+{
+    Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable>();
+    std::vector<double> values;
+    std::vector<Ptr<MobilityModel>> clients;
+    for (uint32_t i = 0; i < 1024; i++)
+    {
+        // Squared distances of 1 m to 1000 km and beyond, as the loss models see them
+        values.push_back(std::pow(10.0, random->GetValue(-12, 12)));
+        Ptr<MobilityModel> client = CreateObject<ConstantPositionMobilityModel>();
+        client->SetPosition(Vector(random->GetValue(1, 500), 0, config.antennaZ));
+        clients.push_back(client);
+    }
+    Ptr<MobilityModel> server = CreateObject<ConstantPositionMobilityModel>();
+    server->SetPosition(Vector(0, 0, config.antennaZ));
+
+    std::ofstream benchmarkFile("output_fastmath_benchmark.csv");
+    benchmarkFile << "function,calls,referenceNsPerCall,fastNsPerCall,speedup,maxErrorDB\n";
+    auto write = [&](const std::string& name, double reference, double fast, double errorDb) {
+        benchmarkFile << name << "," << calls << "," << reference << "," << fast << ","
+                      << reference / fast << "," << errorDb << "\n";
+    };
+
+    double maxErrorDb = 0;
+    for (double value : values)
+    {
+        maxErrorDb =
+            std::max(maxErrorDb, std::fabs(10 * FastLog10(value) - 10 * std::log10(value)));
+    }
+    write("log10",
+          NsPerCall("log10 reference", calls, values.size(), [&values](size_t i) {
+              return std::log10(values[i]);
+          }),
+          NsPerCall("log10 fast", calls, values.size(), [&values](size_t i) {
+              return FastLog10(values[i]);
+          }),
+          maxErrorDb);
+
+    for (PropagationModel model : {FRIIS, TWO_RAY_GROUND, THREE_LOG_DISTANCE})
+    {
+        LossModelCollector reference;
+        LossModelCollector fast;
+        config.fastMath = false;
+        AddPropagationLoss(reference, model, config);
+        config.fastMath = true;
+        AddPropagationLoss(fast, model, config);
+        auto rxPower = [&](Ptr<PropagationLossModel> loss) {
+            return [&, loss](size_t i) {
+                return loss->CalcRxPower(config.txPower, server, clients[i]);
+            };
+        };
+
+        maxErrorDb = 0;
+        for (size_t i = 0; i < clients.size(); i++)
+        {
+            double errorDb = rxPower(fast.model)(i) - rxPower(reference.model)(i);
+            maxErrorDb = std::max(maxErrorDb, std::fabs(errorDb));
+        }
+        std::string name = propagationModelToString(model);
+        write(name,
+              NsPerCall(name + " reference", calls, clients.size(), rxPower(reference.model)),
+              NsPerCall(name + " fast", calls, clients.size(), rxPower(fast.model)),
+              maxErrorDb);
+    }
+}
+
+#endif /* SWEEP_BENCHMARKS_H */
@@ -0,0 +1,740 @@
+#ifndef SWEEP_EXECUTOR_H
+#define SWEEP_EXECUTOR_H
+
+#include "cpu-placement.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#ifdef SWEEP_PROFILE_GENERATE
+extern "C" void __gcov_dump();
+#endif
+
+/**
+ * Outcome of a single sweep task that ran in a forked worker process.
+ */
+struct TaskOutcome
+{
+    std::string output;     //!< Everything the worker sent back
+    bool succeeded = false; //!< Whether the worker exited normally with status 0
+    double wallSeconds = 0; //!< Wall time from fork to exit
+    long peakRssKb = 0;     //!< Peak resident set size of the worker
+};
+
+/**
+ * A forked worker process whose output is still being collected.
+ */
+struct RunningWorker
+{
+    pid_t pid;                                   //!< Process of the worker
+    int fd;                                      //!< Read end of its output pipe
+    std::chrono::steady_clock::time_point start; //!< When it was forked
+    TaskOutcome outcome;                         //!< Collected so far
+    size_t slot;                                 //!< Worker slot, which selects its CPU
+};
+
+/**
+ * Write a whole buffer to a file descriptor, retrying on short writes.
+ */
+inline bool
+WriteAll(int fd, const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = write(fd, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+/**
+ * Find the lowest worker slot no running worker occupies.
+ */
+inline size_t
+FreeSlot(const std::vector<RunningWorker>& running)
+{
+    size_t slot = 0;
+    while (std::any_of(running.begin(), running.end(), [slot](const RunningWorker& worker) {
+        return worker.slot == slot;
+    }))
+    {
+        slot++;
+    }
+    return slot;
+}
+
+/**
+ * Close the descriptors a forked process inherited but must not use. A closed standard
+ * stream would hand its number to the next file the process opens, which output meant
+ * for the stream would then end up in, so those are reopened on /dev/null instead.
+ *
+ * \param inheritedFds the descriptors to close
+ */
+inline void
+CloseInheritedFds(const std::vector<int>& inheritedFds)
+{
+    for (int fd : inheritedFds)
+    {
+        if (fd > STDERR_FILENO)
+        {
+            close(fd);
+            continue;
+        }
+        int null = open("/dev/null", O_RDWR);
+        if (null >= 0 && null != fd)
+        {
+            dup2(null, fd);
+            close(null);
+        }
+    }
+}
+
+/**
+ * Fork a worker process that runs work and sends the returned string back through a pipe.
+ *
+ * \param work the task, run in the worker
+ * \param inheritedFds descriptors of the coordinator the worker must not keep open; the
+ *        standard streams among them are reopened on /dev/null instead of being closed
+ * \param slot the worker slot, which selects the CPU of the worker if pinning is enabled
+ * \return the running worker
+ */
+inline RunningWorker
+StartWorker(const std::function<std::string()>& work,
+            const std::vector<int>& inheritedFds,
+            size_t slot = 0)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        perror("pipe");
+        std::abort();
+    }
+
+    // Buffered output would otherwise be written twice, once by each process
+    std::cout.flush();
+    std::fflush(nullptr);
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        perror("fork");
+        std::abort();
+    }
+    if (pid == 0)
+    {
+        close(fds[0]);
+        CloseInheritedFds(inheritedFds);
+        PinWorker(slot);
+        std::string output = work();
+        bool written = WriteAll(fds[1], output.data(), output.size());
+        close(fds[1]);
+        std::cout.flush();
+        std::fflush(nullptr);
+#ifdef SWEEP_PROFILE_GENERATE
+        // _exit() skips the exit handlers that write the profile of a PGO training run
+        __gcov_dump();
+#endif
+        _exit(written ? 0 : 1);
+    }
+
+    close(fds[1]);
+    return {pid, fds[0], std::chrono::steady_clock::now(), {}, slot};
+}
+
+/**
+ * Read the output a worker has made available. Once it has closed its pipe, the worker
+ * is reaped and its outcome completed.
+ *
+ * \param worker the worker, whose descriptor was reported readable by poll()
+ * \return whether the worker has finished
+ */
+inline bool
+ReadWorker(RunningWorker& worker)
+{
+    char buffer[65536];
+    ssize_t n = read(worker.fd, buffer, sizeof(buffer));
+    if (n < 0 && errno == EINTR)
+    {
+        return false;
+    }
+    if (n > 0)
+    {
+        worker.outcome.output.append(buffer, n);
+        return false;
+    }
+
+    close(worker.fd);
+    int status = 0;
+    rusage usage{};
+    while (wait4(worker.pid, &status, 0, &usage) < 0 && errno == EINTR)
+    {
+    }
+
+    worker.outcome.succeeded = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    worker.outcome.wallSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - worker.start).count();
+    worker.outcome.peakRssKb = usage.ru_maxrss;
+    return true;
+}
+
+/**
+ * Wait until one of the descriptors is readable.
+ *
+ * \param pollFds the descriptors, with their revents updated on return
+ * \param timeoutMs the maximum time to wait, -1 to wait indefinitely
+ */
+inline void
+PollReadable(std::vector<pollfd>& pollFds, int timeoutMs = -1)
+{
+    while (poll(pollFds.data(), pollFds.size(), timeoutMs) < 0)
+    {
+        if (errno != EINTR)
+        {
+            perror("poll");
+            std::abort();
+        }
+    }
+}
+
+/**
+ * Starts the process of a task: start(task, inheritedFds, slot) returns the running
+ * worker, see StartWorker for the other two arguments.
+ */
+typedef std::function<RunningWorker(size_t, const std::vector<int>&, size_t)> WorkerStarter;
+
+/**
+ * Run taskCount tasks in processes started by start, at most jobs of them at a time, and
+ * collect what they write to their output pipe. Outcomes are returned in task order.
+ *
+ * Workers that send their results through shared memory instead need the coordinator to
+ * keep consuming them while it waits: drain is then called at least every millisecond,
+ * and once more after the last worker has exited.
+ */
+inline std::vector<TaskOutcome>
+RunWorkers(size_t taskCount,
+           const WorkerStarter& start,
+           unsigned jobs,
+           const std::function<void()>& drain = nullptr)
+{
+    std::vector<TaskOutcome> outcomes(taskCount);
+    std::vector<RunningWorker> running;
+    std::vector<size_t> runningTasks;
+    size_t next = 0;
+    jobs = std::max(jobs, 1U);
+
+    while (next < taskCount || !running.empty())
+    {
+        while (next < taskCount && running.size() < jobs)
+        {
+            std::vector<int> inheritedFds;
+            for (const RunningWorker& worker : running)
+            {
+                inheritedFds.push_back(worker.fd);
+            }
+            size_t task = next++;
+            running.push_back(start(task, inheritedFds, FreeSlot(running)));
+            runningTasks.push_back(task);
+        }
+
+        std::vector<pollfd> pollFds;
+        for (const RunningWorker& worker : running)
+        {
+            pollFds.push_back({worker.fd, POLLIN, 0});
+        }
+        PollReadable(pollFds, drain ? 1 : -1);
+        if (drain)
+        {
+            drain();
+        }
+
+        for (size_t i = pollFds.size(); i-- > 0;)
+        {
+            if (pollFds[i].revents != 0 && ReadWorker(running[i]))
+            {
+                outcomes[runningTasks[i]] = std::move(running[i].outcome);
+                running.erase(running.begin() + i);
+                runningTasks.erase(runningTasks.begin() + i);
+            }
+        }
+    }
+
+    if (drain)
+    {
+        drain();
+    }
+    return outcomes;
+}
+
+/**
+ * Run taskCount tasks in forked worker processes, at most jobs of them at a time.
+ *
+ * Every worker calls work(index) and streams the returned string back through a pipe.
+ * Workers are forked from the coordinator, so they start with ns-3 already initialised
+ * and each task gets an address space of its own: the peak memory reported for a task
+ * belongs to that task alone. Outcomes are returned in task order; drain is called as
+ * described for RunWorkers.
+ */
+inline std::vector<TaskOutcome>
+RunTasks(size_t taskCount,
+         const std::function<std::string(size_t)>& work,
+         unsigned jobs,
+         const std::function<void()>& drain = nullptr)
+{
+    return RunWorkers(
+        taskCount,
+        [&work](size_t task, const std::vector<int>& inheritedFds, size_t slot) {
+            return StartWorker([&work, task]() { return work(task); }, inheritedFds, slot);
+        },
+        jobs,
+        drain);
+}
+
+/**
+ * Serve sweep tasks read as lines from inFd until it is closed.
+ *
+ * Every request line is handed to a pre-warmed worker forked from this process, at most
+ * jobs at a time, so the cost of loading the libraries and registering the TypeIds is
+ * paid once by the server instead of once per task. As soon as a worker finishes, a line
+ * with the request, a tab and either the worker's output followed by its wall time and
+ * peak memory, or "error" if it failed, is written to outFd. Responses are therefore in
+ * completion order, not in request order.
+ *
+ * \param inFd where requests are read from
+ * \param outFd where responses are written to
+ * \param handle runs a request in the worker and returns its result
+ * \param jobs the maximum number of concurrent workers
+ */
+inline void
+ServeTasks(int inFd,
+           int outFd,
+           const std::function<std::string(const std::string&)>& handle,
+           unsigned jobs)
+{
+    std::deque<std::string> pending;
+    std::vector<RunningWorker> running;
+    std::vector<std::string> runningRequests;
+    std::string input;
+    bool inputOpen = true;
+    jobs = std::max(jobs, 1U);
+
+    while (inputOpen || !pending.empty() || !running.empty())
+    {
+        while (!pending.empty() && running.size() < jobs)
+        {
+            std::vector<int> inheritedFds = {inFd, outFd};
+            for (const RunningWorker& worker : running)
+            {
+                inheritedFds.push_back(worker.fd);
+            }
+            std::string request = pending.front();
+            pending.pop_front();
+            running.push_back(StartWorker([&handle, request]() { return handle(request); },
+                                          inheritedFds,
+                                          FreeSlot(running)));
+            runningRequests.push_back(request);
+        }
+
+        std::vector<pollfd> pollFds;
+        for (const RunningWorker& worker : running)
+        {
+            pollFds.push_back({worker.fd, POLLIN, 0});
+        }
+        if (inputOpen)
+        {
+            pollFds.push_back({inFd, POLLIN, 0});
+        }
+        PollReadable(pollFds);
+
+        if (inputOpen && pollFds.back().revents != 0)
+        {
+            char buffer[4096];
+            ssize_t n = read(inFd, buffer, sizeof(buffer));
+            if (n > 0)
+            {
+                input.append(buffer, n);
+                size_t end;
+                while ((end = input.find('\n')) != std::string::npos)
+                {
+                    std::string request = input.substr(0, end);
+                    input.erase(0, end + 1);
+                    if (!request.empty())
+                    {
+                        pending.push_back(request);
+                    }
+                }
+            }
+            else if (n == 0 || errno != EINTR)
+            {
+                inputOpen = false;
+                if (!input.empty())
+                {
+                    pending.push_back(input);
+                }
+            }
+        }
+
+        for (size_t i = running.size(); i-- > 0;)
+        {
+            if (pollFds[i].revents != 0 && ReadWorker(running[i]))
+            {
+                const TaskOutcome& outcome = running[i].outcome;
+                std::string response = runningRequests[i] + "\t";
+                if (outcome.succeeded)
+                {
+                    response += outcome.output + " " + std::to_string(outcome.wallSeconds) + " " +
+                                std::to_string(outcome.peakRssKb);
+                }
+                else
+                {
+                    response += "error";
+                }
+                response += "\n";
+                WriteAll(outFd, response.data(), response.size());
+
+                running.erase(running.begin() + i);
+                runningRequests.erase(runningRequests.begin() + i);
+            }
+        }
+    }
+}
+
+/**
+ * Create a UNIX stream socket listening at path, replacing what exists there. Clients
+ * going away afterwards do not take the process down with them.
+ *
+ * \param path the path of the socket
+ * \return the listening descriptor
+ */
+inline int
+ListenUnixSocket(const std::string& path)
+{
+    signal(SIGPIPE, SIG_IGN);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (listener < 0 || path.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "Cannot create socket " << path << std::endl;
+        std::abort();
+    }
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    unlink(path.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, 16) != 0)
+    {
+        perror("bind");
+        std::abort();
+    }
+    return listener;
+}
+
+/**
+ * Serve sweep tasks on a UNIX stream socket, one client connection at a time, see
+ * ServeTasks. Runs until the process is terminated.
+ *
+ * \param path the path of the socket, replaced if it exists
+ * \param handle runs a request in the worker and returns its result
+ * \param jobs the maximum number of concurrent workers
+ */
+inline void
+ServeUnixSocket(const std::string& path,
+                const std::function<std::string(const std::string&)>& handle,
+                unsigned jobs)
+{
+    int listener = ListenUnixSocket(path);
+    while (true)
+    {
+        int connection = accept(listener, nullptr, nullptr);
+        if (connection < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("accept");
+            std::abort();
+        }
+        ServeTasks(connection, connection, handle, jobs);
+        close(connection);
+    }
+}
+
+/**
+ * Answer queries from any number of clients on a UNIX stream socket while running tasks
+ * in the background. Runs until the process is terminated.
+ *
+ * Every query line is answered right away by answer, in the server process itself, so a
+ * response costs no fork and no simulation. answer may ask for tasks to be run; each
+ * distinct task is queued once and runs in a worker forked from the server, at most jobs
+ * at a time, and its outcome is handed to finished in the server process, where it can
+ * improve the answers to later queries. At most maxQueued tasks are pending or running;
+ * if a query asks for more, " busy" is appended to its response and the tasks that did
+ * not fit are not run. Responses are written in query order per client.
+ *
+ * Clients are written to without blocking: responses wait in a buffer of the client until
+ * its socket takes them, so a client that does not read stalls no other. Queries of a
+ * client whose buffer holds more than MAX_CLIENT_OUTPUT bytes are not read until it
+ * drains.
+ *
+ * \param path the path of the socket, replaced if it exists
+ * \param answer returns the response to a query, without the newline, and appends the
+ *        tasks it wants run to its second argument
+ * \param run runs a task in the worker and returns its result
+ * \param finished called in the server with every task and its outcome
+ * \param jobs the maximum number of concurrent workers
+ * \param maxQueued the maximum number of tasks pending or running
+ */
+inline void
+ServeQueries(
+    const std::string& path,
+    const std::function<std::string(const std::string&, std::vector<std::string>&)>& answer,
+    const std::function<std::string(const std::string&)>& run,
+    const std::function<void(const std::string&, const TaskOutcome&)>& finished,
+    unsigned jobs,
+    size_t maxQueued)
+{
+    const size_t MAX_CLIENT_OUTPUT = 1 << 20;
+
+    /// A connected client, what it has sent of its current line and what it has not
+    /// taken of the responses yet
+    struct Client
+    {
+        int fd;
+        std::string input;
+        std::string output;
+    };
+
+    // Write what the socket of a client takes, and whether the client is still there
+    auto flush = [](Client& client) {
+        while (!client.output.empty())
+        {
+            ssize_t written = write(client.fd, client.output.data(), client.output.size());
+            if (written < 0)
+            {
+                return errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            client.output.erase(0, written);
+        }
+        return true;
+    };
+
+    int listener = ListenUnixSocket(path);
+    std::vector<Client> clients;
+    std::deque<std::string> pending;
+    std::set<std::string> queued; // Pending or running
+    std::vector<RunningWorker> running;
+    std::vector<std::string> runningTasks;
+    jobs = std::max(jobs, 1U);
+
+    while (true)
+    {
+        while (!pending.empty() && running.size() < jobs)
+        {
+            std::vector<int> inheritedFds = {listener};
+            for (const Client& client : clients)
+            {
+                inheritedFds.push_back(client.fd);
+            }
+            for (const RunningWorker& worker : running)
+            {
+                inheritedFds.push_back(worker.fd);
+            }
+            std::string task = pending.front();
+            pending.pop_front();
+            running.push_back(
+                StartWorker([&run, task]() { return run(task); }, inheritedFds, FreeSlot(running)));
+            runningTasks.push_back(task);
+        }
+
+        // Workers first, then clients, then the listener
+        std::vector<pollfd> pollFds;
+        for (const RunningWorker& worker : running)
+        {
+            pollFds.push_back({worker.fd, POLLIN, 0});
+        }
+        for (const Client& client : clients)
+        {
+            short events = client.output.size() < MAX_CLIENT_OUTPUT ? POLLIN : 0;
+            if (!client.output.empty())
+            {
+                events |= POLLOUT;
+            }
+            pollFds.push_back({client.fd, events, 0});
+        }
+        pollFds.push_back({listener, POLLIN, 0});
+        PollReadable(pollFds);
+
+        for (size_t i = clients.size(); i-- > 0;)
+        {
+            short revents = pollFds[running.size() + i].revents;
+            if (revents == 0)
+            {
+                continue;
+            }
+            Client& client = clients[i];
+            bool connected = true;
+            if (revents & POLLIN)
+            {
+                char buffer[4096];
+                ssize_t n = read(client.fd, buffer, sizeof(buffer));
+                if (n > 0)
+                {
+                    client.input.append(buffer, n);
+                }
+                else if (n == 0 || (errno != EINTR && errno != EAGAIN))
+                {
+                    connected = false;
+                }
+            }
+            else if (revents & (POLLERR | POLLHUP | POLLNVAL))
+            {
+                connected = false;
+            }
+
+            size_t end;
+            while (connected && (end = client.input.find('\n')) != std::string::npos)
+            {
+                std::string query = client.input.substr(0, end);
+                client.input.erase(0, end + 1);
+                if (query.empty())
+                {
+                    continue;
+                }
+                std::vector<std::string> tasks;
+                std::string response = answer(query, tasks);
+                bool busy = false;
+                for (const std::string& task : tasks)
+                {
+                    if (queued.count(task) == 0 && queued.size() >= maxQueued)
+                    {
+                        busy = true;
+                    }
+                    else if (queued.insert(task).second)
+                    {
+                        pending.push_back(task);
+                    }
+                }
+                client.output += response + (busy ? " busy\n" : "\n");
+            }
+
+            if (!connected || !flush(client))
+            {
+                close(client.fd);
+                clients.erase(clients.begin() + i);
+            }
+        }
+
+        if (pollFds.back().revents != 0)
+        {
+            int connection = accept(listener, nullptr, nullptr);
+            if (connection >= 0)
+            {
+                fcntl(connection, F_SETFL, fcntl(connection, F_GETFL) | O_NONBLOCK);
+                clients.push_back({connection, "", ""});
+            }
+        }
+
+        for (size_t i = running.size(); i-- > 0;)
+        {
+            if (pollFds[i].revents != 0 && ReadWorker(running[i]))
+            {
+                finished(runningTasks[i], running[i].outcome);
+                queued.erase(runningTasks[i]);
+                running.erase(running.begin() + i);
+                runningTasks.erase(runningTasks.begin() + i);
+            }
+        }
+    }
+}
+
+/**
+ * Start a program in a new process, without a pre-warmed worker in between, feeding it
+ * input on stdin. Its stdout is collected like the output of a worker, see ReadWorker.
+ *
+ * \param argv the program and its arguments
+ * \param input what to write to its stdin, at most a pipe buffer as the program does
+ *        not run yet
+ * \param inheritedFds descriptors of the caller the program must not keep open
+ * \param slot the worker slot, which selects the CPU of the program if pinning is enabled
+ * \return the running program
+ */
+inline RunningWorker
+StartProgram(const std::vector<std::string>& argv,
+             const std::string& input,
+             const std::vector<int>& inheritedFds,
+             size_t slot = 0)
+{
+    int inPipe[2];
+    int outPipe[2];
+    if (pipe(inPipe) != 0 || pipe(outPipe) != 0)
+    {
+        perror("pipe");
+        std::abort();
+    }
+
+    std::cout.flush();
+    std::fflush(nullptr);
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        perror("fork");
+        std::abort();
+    }
+    if (pid == 0)
+    {
+        CloseInheritedFds(inheritedFds);
+        dup2(inPipe[0], STDIN_FILENO);
+        dup2(outPipe[1], STDOUT_FILENO);
+        close(inPipe[0]);
+        close(inPipe[1]);
+        close(outPipe[0]);
+        close(outPipe[1]);
+        PinWorker(slot);
+        std::vector<char*> args;
+        for (const std::string& arg : argv)
+        {
+            args.push_back(const_cast<char*>(arg.c_str()));
+        }
+        args.push_back(nullptr);
+        execv(args[0], args.data());
+        _exit(127);
+    }
+
+    close(inPipe[0]);
+    close(outPipe[1]);
+    WriteAll(inPipe[1], input.data(), input.size());
+    close(inPipe[1]);
+    return {pid, outPipe[0], std::chrono::steady_clock::now(), {}, slot};
+}
+
+#endif /* SWEEP_EXECUTOR_H */
@@ -0,0 +1,277 @@
+#ifndef SWEEP_IMPORT_H
+#define SWEEP_IMPORT_H
+
+#include "result-store.h"
+#include "sweep-point.h"
+#include "sweep-shards.h"
+
+#include "ns3/core-module.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Convert a simulated point to the form the result store holds.
+ */
+inline StoredPoint
+ToStoredPoint(const SweepPoint& point, const PointResult& result, const std::string& configHash)
+{
+    StoredPoint stored;
+    stored.model = propagationModelToString(point.model);
+    stored.phy = phyTypeToString(point.phy);
+    stored.distance = point.distance;
+    stored.seed = point.seed;
+    stored.maxAmpduSize = point.aggregation.maxAmpduSize;
+    stored.maxAmsduSize = point.aggregation.maxAmsduSize;
+    stored.blockAckThreshold = point.aggregation.blockAckThreshold;
+    stored.blockAckInactivityTimeout = point.aggregation.blockAckInactivityTimeout;
+    stored.hops = point.hops;
+    stored.clients = point.clients;
+    stored.transport = transportTypeToString(point.transport.type);
+    if (point.transport.type == TCP_BULK)
+    {
+        stored.congestionControl = point.transport.congestionControl;
+        stored.segmentSize = point.transport.segmentSize;
+    }
+    stored.configHash = configHash;
+    stored.rss = result.rss;
+    stored.throughput = result.throughput;
+    stored.goodput = result.goodput;
+    stored.rxBytes = result.rxBytes;
+    stored.rxPackets = result.rxPackets;
+    stored.connectionLost = result.connectionLost;
+    const MacCounters& mac = result.mac;
+    stored.mac = StoredMac{mac.retransmissions,
+                           mac.retryLimitDrops,
+                           mac.queueDrops,
+                           mac.backoffs,
+                           mac.backoffSlots,
+                           mac.mcsChanges,
+                           mac.mcsHistogram};
+    stored.timing =
+        StoredTiming{result.events, result.runSeconds, result.wallSeconds, result.peakRssKb};
+    return stored;
+}
+
+/**
+ * Parse the part of a per-model output file name after the model, the inverse of the
+ * suffixes outputFileName appends.
+ *
+ * \param suffix e.g. "_Spectrum_ampdu65535_amsdu0_ba0_bato0_seed2"
+ * \param point receives the PHY type, aggregation settings, seed, hops, clients and
+ *        transport
+ * \return whether the suffix is valid
+ */
+inline bool
+ParseOutputFileSuffix(const std::string& suffix, SweepPoint& point)
+{
+    std::istringstream stream(suffix);
+    std::string token;
+    std::getline(stream, token, '_');
+    if (!token.empty())
+    {
+        return false;
+    }
+    while (std::getline(stream, token, '_'))
+    {
+        auto number = [&token](size_t prefixLength) {
+            return std::stoul(token.substr(prefixLength));
+        };
+        try
+        {
+            if (token == "Spectrum" || token == "Abstract")
+            {
+                point.phy = phyTypeFromString(token);
+            }
+            else if (token.rfind("ampdu", 0) == 0)
+            {
+                point.aggregation.maxAmpduSize = number(5);
+            }
+            else if (token.rfind("amsdu", 0) == 0)
+            {
+                point.aggregation.maxAmsduSize = number(5);
+            }
+            else if (token.rfind("bato", 0) == 0)
+            {
+                point.aggregation.blockAckInactivityTimeout = number(4);
+            }
+            else if (token.rfind("ba", 0) == 0)
+            {
+                point.aggregation.blockAckThreshold = number(2);
+            }
+            else if (token.rfind("seed", 0) == 0)
+            {
+                point.seed = number(4);
+            }
+            else if (token.rfind("hops", 0) == 0)
+            {
+                point.hops = number(4);
+            }
+            else if (token.rfind("clients", 0) == 0)
+            {
+                point.clients = number(7);
+            }
+            else if (token == "UdpSaturating" || token == "TcpBulk")
+            {
+                point.transport.type = transportTypeFromString(token);
+            }
+            else if (token.rfind("cc", 0) == 0)
+            {
+                point.transport.congestionControl = token.substr(2);
+            }
+            else if (token.rfind("mss", 0) == 0)
+            {
+                point.transport.segmentSize = number(3);
+            }
+            else
+            {
+                return false;
+            }
+        }
+        catch (const std::logic_error&)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Import existing result files into the result store, each as a run of its own in one
+ * transaction: shard and what-if results, per-model output_<Model>*.csv files and the
+ * output_runtime.csv of wifi-runtime-comparison. What a file does not record, such as the
+ * byte counts of the output files, is stored as NULL.
+ */
+inline void
+ImportResults(ResultStore& store, const std::vector<std::string>& fileNames)
+{
+    for (const std::string& fileName : fileNames)
+    {
+        std::ifstream file(fileName);
+        NS_ABORT_MSG_IF(!file, "Cannot read " << fileName);
+        std::string first;
+        std::getline(file, first);
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(file, line);)
+        {
+            if (!line.empty())
+            {
+                lines.push_back(line);
+            }
+        }
+        auto splitFields = [](const std::string& line) {
+            std::vector<std::string> fields;
+            std::istringstream stream(line);
+            std::string field;
+            while (std::getline(stream, field, ','))
+            {
+                fields.push_back(field);
+            }
+            return fields;
+        };
+
+        size_t imported = 0;
+        if (first.rfind("# ", 0) == 0)
+        {
+            std::vector<std::string> header;
+            std::vector<std::string> results;
+            NS_ABORT_MSG_IF(!ReadShardFile(fileName, header, results), "Cannot read " << fileName);
+            std::string configHash = ShardHeaderValue(header, "config");
+            store.BeginRun("import", fileName, configHash, "");
+            store.Begin();
+            for (const std::string& line : results)
+            {
+                size_t tab = line.find('\t');
+                if (tab == std::string::npos || line.compare(tab + 1, 5, "error") == 0)
+                {
+                    continue;
+                }
+                std::istringstream stream(line.substr(tab + 1));
+                PointResult result = DeserializeResult(stream);
+                stream >> result.wallSeconds >> result.peakRssKb;
+                StoredPoint stored =
+                    ToStoredPoint(ParseRequest(line.substr(0, tab)), result, configHash);
+                store.InsertPoint(stored);
+                imported++;
+            }
+        }
+        else if (first.rfind("runtime,", 0) == 0)
+        {
+            store.BeginRun("wifi-runtime-comparison", fileName, "", "");
+            store.Begin();
+            for (const std::string& line : lines)
+            {
+                std::vector<std::string> fields = splitFields(line);
+                NS_ABORT_MSG_IF(fields.size() < 3, "Invalid line in " << fileName << ": " << line);
+                store.InsertRuntime(std::stod(fields[0]),
+                                    std::stod(fields[1]),
+                                    std::stod(fields[2]));
+                imported++;
+            }
+        }
+        else if (first.rfind("distanceMeters,rssDBm,throughputKbps,", 0) == 0)
+        {
+            std::vector<std::string> header = splitFields(first);
+            SweepPoint point = ParseRequest("");
+            point.model = propagationModelFromString(header[3]);
+            std::string baseName = fileName.substr(fileName.find_last_of('/') + 1);
+            std::string prefix = "output_" + header[3];
+            bool named = baseName.rfind(prefix, 0) == 0 && baseName.size() >= prefix.size() + 4 &&
+                         ParseOutputFileSuffix(
+                             baseName.substr(prefix.size(), baseName.size() - prefix.size() - 4),
+                             point);
+            NS_ABORT_MSG_IF(!named, "Cannot tell the variant of " << fileName << " from its name");
+            store.BeginRun("import", fileName, "", "");
+            store.Begin();
+            for (const std::string& line : lines)
+            {
+                std::vector<std::string> fields = splitFields(line);
+                NS_ABORT_MSG_IF(fields.size() < 3, "Invalid line in " << fileName << ": " << line);
+                point.distance = std::stod(fields[0]);
+                StoredPoint stored = ToStoredPoint(point, PointResult(), "");
+                stored.rss = std::stod(fields[1]);
+                stored.throughput = std::stod(fields[2]);
+                stored.goodput.reset();
+                stored.rxBytes.reset();
+                stored.rxPackets.reset();
+                stored.connectionLost.reset();
+                stored.timing.reset();
+                if (fields.size() >= 20)
+                {
+                    StoredMac& mac = *stored.mac;
+                    uint64_t* counters[] = {&mac.retransmissions,
+                                            &mac.retryLimitDrops,
+                                            &mac.queueDrops,
+                                            &mac.backoffs,
+                                            &mac.backoffSlots,
+                                            &mac.mcsChanges};
+                    for (size_t i = 0; i < 6; i++)
+                    {
+                        *counters[i] = std::stoull(fields[6 + i]);
+                    }
+                    for (size_t mcs = 0; mcs < mac.mcsHistogram.size(); mcs++)
+                    {
+                        mac.mcsHistogram[mcs] = std::stoull(fields[12 + mcs]);
+                    }
+                }
+                else
+                {
+                    stored.mac.reset();
+                }
+                store.InsertPoint(stored);
+                imported++;
+            }
+        }
+        else
+        {
+            NS_ABORT_MSG("Unknown result file format: " << fileName);
+        }
+        NS_ABORT_MSG_IF(!store.Commit(), store.Error());
+        NS_LOG_UNCOND("Imported " << imported << " rows of " << fileName);
+    }
+}
+
+#endif /* SWEEP_IMPORT_H */
@@ -0,0 +1,820 @@
+#ifndef SWEEP_POINT_H
+#define SWEEP_POINT_H
+
+#include "loss-parameters.h"
+#include "node-placement.h"
+#include "sweep-shards.h"
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// The sweep headers split up wifi-propagation-comparison.cc and are written against ns3
+// like its main file
+using namespace ns3;
+
+enum PropagationModel
+{
+    FRIIS,
+    FIXED_RSS,
+    THREE_LOG_DISTANCE,
+    TWO_RAY_GROUND,
+    NAKAGAMI
+};
+
+inline const std::string
+propagationModelToString(PropagationModel model)
+{
+    switch (model)
+    {
+    case FRIIS:
+        return "Friis";
+    case FIXED_RSS:
+        return "FixedRSS";
+    case THREE_LOG_DISTANCE:
+        return "ThreeLogDistance";
+    case TWO_RAY_GROUND:
+        return "TwoRayGround";
+    case NAKAGAMI:
+        return "Nakagami";
+    }
+}
+
+inline PropagationModel
+propagationModelFromString(const std::string& name)
+{
+    for (PropagationModel model : {FRIIS, FIXED_RSS, THREE_LOG_DISTANCE, TWO_RAY_GROUND, NAKAGAMI})
+    {
+        if (propagationModelToString(model) == name)
+        {
+            return model;
+        }
+    }
+    NS_ABORT_MSG("Unknown propagation model " << name);
+}
+
+enum PhyType
+{
+    YANS,
+    SPECTRUM,
+    ABSTRACT
+};
+
+inline const std::string
+phyTypeToString(PhyType phy)
+{
+    switch (phy)
+    {
+    case YANS:
+        return "Yans";
+    case SPECTRUM:
+        return "Spectrum";
+    case ABSTRACT:
+        return "Abstract";
+    }
+}
+
+inline PhyType
+phyTypeFromString(const std::string& name)
+{
+    for (PhyType phy : {YANS, SPECTRUM, ABSTRACT})
+    {
+        if (phyTypeToString(phy) == name)
+        {
+            return phy;
+        }
+    }
+    NS_ABORT_MSG("Unknown PHY type " << name);
+}
+
+enum TransportType
+{
+    UDP_CBR,
+    UDP_SATURATING,
+    TCP_BULK
+};
+
+inline const std::string
+transportTypeToString(TransportType transport)
+{
+    switch (transport)
+    {
+    case UDP_CBR:
+        return "UdpCbr";
+    case UDP_SATURATING:
+        return "UdpSaturating";
+    case TCP_BULK:
+        return "TcpBulk";
+    }
+}
+
+inline TransportType
+transportTypeFromString(const std::string& name)
+{
+    for (TransportType transport : {UDP_CBR, UDP_SATURATING, TCP_BULK})
+    {
+        if (transportTypeToString(transport) == name)
+        {
+            return transport;
+        }
+    }
+    NS_ABORT_MSG("Unknown transport " << name);
+}
+
+/**
+ * Whether a name is that of an ns-3 TCP congestion control, e.g. TcpNewReno or TcpCubic.
+ */
+inline bool
+IsCongestionControl(const std::string& name)
+{
+    TypeId tid;
+    return TypeId::LookupByNameFailSafe("ns3::" + name, &tid) &&
+           tid.IsChildOf(TcpCongestionOps::GetTypeId());
+}
+
+/**
+ * Split a comma separated command line value into its items.
+ */
+inline std::vector<std::string>
+SplitList(const std::string& list)
+{
+    std::vector<std::string> items;
+    std::istringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        if (!item.empty())
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+/**
+ * Split a comma separated command line value into unsigned integers. Aborts, naming the
+ * option, if an item is negative, not a number or out of range.
+ */
+inline std::vector<uint32_t>
+ParseUnsignedList(const std::string& option, const std::string& list)
+{
+    std::vector<uint32_t> values;
+    for (const std::string& item : SplitList(list))
+    {
+        // std::stoull accepts blanks and a sign in front of the digits and wraps negatives
+        size_t end = 0;
+        unsigned long long value = 0;
+        if (std::isdigit(static_cast<unsigned char>(item[0])))
+        {
+            try
+            {
+                value = std::stoull(item, &end);
+            }
+            catch (const std::logic_error&)
+            {
+                end = 0;
+            }
+        }
+        NS_ABORT_MSG_IF(end != item.size() || value > UINT32_MAX,
+                        "Invalid value " << item << " of --" << option);
+        values.push_back(value);
+    }
+    return values;
+}
+
+/**
+ * Split a comma separated command line value into finite, non-negative numbers. Aborts,
+ * naming the option, if an item is not one.
+ */
+inline std::vector<double>
+ParseNonNegativeList(const std::string& option, const std::string& list)
+{
+    std::vector<double> values;
+    for (const std::string& item : SplitList(list))
+    {
+        size_t end = 0;
+        double value = 0;
+        if (std::isdigit(static_cast<unsigned char>(item[0])) || item[0] == '.')
+        {
+            try
+            {
+                value = std::stod(item, &end);
+            }
+            catch (const std::logic_error&)
+            {
+                end = 0;
+            }
+        }
+        NS_ABORT_MSG_IF(end != item.size() || !std::isfinite(value),
+                        "Invalid value " << item << " of --" << option);
+        values.push_back(value);
+    }
+    return values;
+}
+
+/**
+ * Parameters shared by every point of the sweep.
+ */
+struct ScenarioConfig
+{
+    double simulationTime = 50; // Maximum simulation time in seconds
+
+    double dataRate = 75e6;     // 75 Mbps target data rate
+    uint64_t packetSize = 1450; // bytes
+
+    double txPower = 10; // dBm
+    double txGain = 1;   // dB
+    double rxGain = 1;   // dB
+
+    double antennaZ = 1.5; // Antenna height in meters
+
+    uint32_t interferers = 0;          // Background interferers around the server
+    double interfererDistance = 50;    // meters from the server
+    double interfererDutyCycle = 0.05; // Fraction of time each interferer transmits
+    std::string interfererTxPower = "ns3::ConstantRandomVariable[Constant=10.0]"; // dBm
+
+    std::string interfererPlacement;    // Position file of further interferers
+    Ptr<const NodePlacement> placement; // Its contents, loaded before the workers fork
+
+    std::string antenna = "Isotropic"; // Isotropic, Parabolic or a pattern file
+    double antennaBeamwidth = 60;      // 3 dB beamwidth of the parabolic antenna in degrees
+    double antennaMisalignment = 0;    // Rotation of both antennas off the link in degrees
+
+    LossParameters loss;   // Parameters of the propagation loss models
+    bool fastMath = false; // Fast approximate loss models, see fast-propagation-loss-models.h
+};
+
+/**
+ * The parameters of a scenario configuration that identify it, as text.
+ */
+inline std::string
+ConfigDescription(const ScenarioConfig& config)
+{
+    std::ostringstream description;
+    description << std::setprecision(17) << config.simulationTime << " " << config.dataRate
+                << " " << config.packetSize << " " << config.txPower << " " << config.txGain
+                << " " << config.rxGain << " " << config.antennaZ << " " << config.interferers
+                << " " << config.interfererDistance << " " << config.interfererDutyCycle << " "
+                << config.interfererTxPower;
+    // Appended only when set, so that the hashes of earlier configurations stay valid
+    if (config.antenna != "Isotropic")
+    {
+        description << " " << config.antenna << " " << config.antennaBeamwidth << " "
+                    << config.antennaMisalignment;
+    }
+    if (config.loss.ToString() != LossParameters().ToString())
+    {
+        description << " " << config.loss.ToString();
+    }
+    if (config.fastMath)
+    {
+        description << " fastMath";
+    }
+    if (!config.interfererPlacement.empty())
+    {
+        description << " placement " << config.interfererPlacement;
+    }
+    return description.str();
+}
+
+/**
+ * Identify a scenario configuration, so that results simulated on other hosts can be
+ * checked to come from the same parameters.
+ */
+inline std::string
+ConfigHash(const ScenarioConfig& config)
+{
+    return Fnv1aHash(ConfigDescription(config));
+}
+
+/**
+ * Frame aggregation and block ack settings of the best effort access category.
+ * The defaults are those of ns-3 for 802.11n.
+ */
+struct AggregationConfig
+{
+    uint32_t maxAmpduSize = 65535;          // bytes, 0 disables A-MPDU
+    uint32_t maxAmsduSize = 0;              // bytes, 0 disables A-MSDU
+    uint32_t blockAckThreshold = 0;         // Queued packets that trigger a block ack agreement
+    uint32_t blockAckInactivityTimeout = 0; // In units of 1024 us, 0 disables the timeout
+
+    bool operator==(const AggregationConfig& other) const
+    {
+        return maxAmpduSize == other.maxAmpduSize && maxAmsduSize == other.maxAmsduSize &&
+               blockAckThreshold == other.blockAckThreshold &&
+               blockAckInactivityTimeout == other.blockAckInactivityTimeout;
+    }
+};
+
+/**
+ * Offered load of the saturating UDP transport in bit/s, above the highest rate of the
+ * single stream 40 MHz 802.11n PHY.
+ */
+const double SATURATING_DATA_RATE = 150e6;
+
+/**
+ * Transport of the traffic from the clients to the server. UDP at the configured data rate
+ * is the traffic of the paper; saturating UDP offers more than any link can carry, and TCP
+ * bulk transfers send as fast as their congestion control lets them.
+ */
+struct TransportConfig
+{
+    TransportType type = UDP_CBR;
+    std::string congestionControl = "TcpNewReno"; // ns-3 TCP congestion control, TCP only
+    uint32_t segmentSize = 1448;                  // bytes, TCP only
+
+    bool operator==(const TransportConfig& other) const
+    {
+        return type == other.type && congestionControl == other.congestionControl &&
+               segmentSize == other.segmentSize;
+    }
+};
+
+/**
+ * A combination of the swept PHY type, aggregation settings, relay chain length and
+ * transport. Every variant gets a distance sweep of its own for each propagation model.
+ */
+struct Variant
+{
+    PhyType phy;
+    AggregationConfig aggregation;
+    uint32_t hops = 1;         // Links from the client to the server, see SweepPoint
+    TransportConfig transport; // Traffic from the client to the server
+};
+
+/**
+ * Suffix of the output files of a variant. The Yans PHY with the default aggregation
+ * settings has none, so its results keep the file names the plots of the paper are built
+ * from.
+ */
+inline std::string
+variantSuffix(const Variant& variant)
+{
+    std::string suffix = variant.phy == YANS ? "" : "_" + phyTypeToString(variant.phy);
+    const AggregationConfig& aggregation = variant.aggregation;
+    if (!(aggregation == AggregationConfig()))
+    {
+        suffix += "_ampdu" + std::to_string(aggregation.maxAmpduSize) + "_amsdu" +
+                  std::to_string(aggregation.maxAmsduSize) + "_ba" +
+                  std::to_string(aggregation.blockAckThreshold) + "_bato" +
+                  std::to_string(aggregation.blockAckInactivityTimeout);
+    }
+    if (variant.hops != 1)
+    {
+        suffix += "_hops" + std::to_string(variant.hops);
+    }
+    const TransportConfig& transport = variant.transport;
+    if (transport.type != UDP_CBR)
+    {
+        suffix += "_" + transportTypeToString(transport.type);
+    }
+    if (transport.type == TCP_BULK)
+    {
+        suffix += "_cc" + transport.congestionControl + "_mss" +
+                  std::to_string(transport.segmentSize);
+    }
+    return suffix;
+}
+
+/**
+ * One simulation of the sweep: a propagation model and variant at a given distance.
+ *
+ * With more than one hop the client reaches the server over a chain of relays on a line,
+ * and the distance is the spacing of neighbouring nodes. With more than one client, the
+ * clients contend for the channel from a circle of that radius around the server.
+ */
+struct SweepPoint
+{
+    PropagationModel model;
+    PhyType phy;
+    AggregationConfig aggregation;
+    double distance;   // meters
+    uint32_t seed = 1; // ns-3 run number of the random number streams
+    uint32_t hops = 1;         // Links from the client to the server
+    uint32_t clients = 1;      // Clients sending to the server
+    TransportConfig transport; // Traffic from the clients to the server
+};
+
+/**
+ * Name of the per-model output file a sweep point belongs to. Seeds other than the
+ * default one and several clients get a suffix of their own.
+ */
+inline std::string
+outputFileName(const SweepPoint& point)
+{
+    std::string name = "output_" + propagationModelToString(point.model) +
+                       variantSuffix({point.phy, point.aggregation, point.hops, point.transport});
+    if (point.seed != 1)
+    {
+        name += "_seed" + std::to_string(point.seed);
+    }
+    if (point.clients != 1)
+    {
+        name += "_clients" + std::to_string(point.clients);
+    }
+    return name + ".csv";
+}
+
+/**
+ * Parse a sweep point from a server request: space separated key=value pairs with the
+ * keys model, phy, distance, maxAmpduSize, maxAmsduSize, blockAckThreshold,
+ * blockAckInactivityTimeout, seed, hops, clients, transport, congestionControl and
+ * segmentSize. Keys that are left out take their default value.
+ *
+ * \param request the request
+ * \param point receives the point
+ * \param error receives a description of what is wrong with the request
+ * \return whether the request is valid
+ */
+inline bool
+TryParseRequest(const std::string& request, SweepPoint& point, std::string& error)
+{
+    point = {FRIIS, YANS, AggregationConfig(), 1};
+    std::istringstream stream(request);
+    std::string token;
+    while (stream >> token)
+    {
+        size_t separator = token.find('=');
+        if (separator == std::string::npos)
+        {
+            error = "Malformed request token " + token;
+            return false;
+        }
+        std::string key = token.substr(0, separator);
+        std::string value = token.substr(separator + 1);
+
+        try
+        {
+            if (key == "model")
+            {
+                auto models = {FRIIS, FIXED_RSS, THREE_LOG_DISTANCE, TWO_RAY_GROUND, NAKAGAMI};
+                auto model = std::find_if(models.begin(), models.end(), [&value](auto candidate) {
+                    return propagationModelToString(candidate) == value;
+                });
+                if (model == models.end())
+                {
+                    error = "Unknown propagation model " + value;
+                    return false;
+                }
+                point.model = *model;
+            }
+            else if (key == "phy")
+            {
+                auto phys = {YANS, SPECTRUM, ABSTRACT};
+                auto phy = std::find_if(phys.begin(), phys.end(), [&value](auto candidate) {
+                    return phyTypeToString(candidate) == value;
+                });
+                if (phy == phys.end())
+                {
+                    error = "Unknown PHY type " + value;
+                    return false;
+                }
+                point.phy = *phy;
+            }
+            else if (key == "distance")
+            {
+                point.distance = std::stod(value);
+            }
+            else if (key == "maxAmpduSize")
+            {
+                point.aggregation.maxAmpduSize = std::stoul(value);
+            }
+            else if (key == "maxAmsduSize")
+            {
+                point.aggregation.maxAmsduSize = std::stoul(value);
+            }
+            else if (key == "blockAckThreshold")
+            {
+                point.aggregation.blockAckThreshold = std::stoul(value);
+            }
+            else if (key == "blockAckInactivityTimeout")
+            {
+                point.aggregation.blockAckInactivityTimeout = std::stoul(value);
+            }
+            else if (key == "seed")
+            {
+                point.seed = std::stoul(value);
+            }
+            else if (key == "hops")
+            {
+                // The nodes of the chain share a /24 subnet
+                point.hops = std::stoul(value);
+                if (point.hops < 1 || point.hops > 253)
+                {
+                    error = "Invalid number of hops " + value;
+                    return false;
+                }
+            }
+            else if (key == "clients")
+            {
+                point.clients = std::stoul(value);
+                if (point.clients < 1 || point.clients > 1024)
+                {
+                    error = "Invalid number of clients " + value;
+                    return false;
+                }
+            }
+            else if (key == "transport")
+            {
+                auto transports = {UDP_CBR, UDP_SATURATING, TCP_BULK};
+                auto transport = std::find_if(transports.begin(),
+                                              transports.end(),
+                                              [&value](auto candidate) {
+                                                  return transportTypeToString(candidate) == value;
+                                              });
+                if (transport == transports.end())
+                {
+                    error = "Unknown transport " + value;
+                    return false;
+                }
+                point.transport.type = *transport;
+            }
+            else if (key == "congestionControl")
+            {
+                if (!IsCongestionControl(value))
+                {
+                    error = "Unknown congestion control " + value;
+                    return false;
+                }
+                point.transport.congestionControl = value;
+            }
+            else if (key == "segmentSize")
+            {
+                // Segments with the IPv4 and TCP headers and the timestamp option have to
+                // fit the 2296 byte MTU of the Wi-Fi device
+                point.transport.segmentSize = std::stoul(value);
+                if (point.transport.segmentSize < 64 || point.transport.segmentSize > 2244)
+                {
+                    error = "Invalid segment size " + value;
+                    return false;
+                }
+            }
+            else
+            {
+                error = "Unknown request key " + key;
+                return false;
+            }
+        }
+        catch (const std::logic_error&)
+        {
+            error = "Malformed value of " + key + ": " + value;
+            return false;
+        }
+    }
+    if (point.hops > 1 && point.clients > 1)
+    {
+        error = "A relay chain has a single client";
+        return false;
+    }
+    const TransportConfig defaults;
+    if (point.transport.type != TCP_BULK &&
+        (point.transport.congestionControl != defaults.congestionControl ||
+         point.transport.segmentSize != defaults.segmentSize))
+    {
+        error = "Only TCP has a congestion control and segment size";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Parse a sweep point from a server request, see TryParseRequest, and abort if it is
+ * not valid.
+ */
+inline SweepPoint
+ParseRequest(const std::string& request)
+{
+    SweepPoint point;
+    std::string error;
+    NS_ABORT_MSG_IF(!TryParseRequest(request, point, error), error);
+    return point;
+}
+
+/**
+ * Format a sweep point as a request, the inverse of ParseRequest.
+ */
+inline std::string
+FormatRequest(const SweepPoint& point)
+{
+    std::ostringstream stream;
+    stream << "model=" << propagationModelToString(point.model)
+           << " phy=" << phyTypeToString(point.phy) << " distance=" << point.distance
+           << " maxAmpduSize=" << point.aggregation.maxAmpduSize
+           << " maxAmsduSize=" << point.aggregation.maxAmsduSize
+           << " blockAckThreshold=" << point.aggregation.blockAckThreshold
+           << " blockAckInactivityTimeout=" << point.aggregation.blockAckInactivityTimeout
+           << " seed=" << point.seed;
+    // Only relay chains, contending clients and other transports have these, so that the
+    // requests of single UDP links stay the same
+    if (point.hops != 1)
+    {
+        stream << " hops=" << point.hops;
+    }
+    if (point.clients != 1)
+    {
+        stream << " clients=" << point.clients;
+    }
+    if (point.transport.type != UDP_CBR)
+    {
+        stream << " transport=" << transportTypeToString(point.transport.type);
+    }
+    if (point.transport.type == TCP_BULK)
+    {
+        stream << " congestionControl=" << point.transport.congestionControl
+               << " segmentSize=" << point.transport.segmentSize;
+    }
+    return stream.str();
+}
+
+/**
+ * MAC retry and contention counters of one sweep point, collected from trace sources.
+ */
+struct MacCounters
+{
+    uint64_t retransmissions = 0;           // Data MPDUs sent with the Retry bit set
+    uint64_t retryLimitDrops = 0;           // MPDUs dropped after the maximum number of retries
+    uint64_t queueDrops = 0;                // MPDUs dropped by the MAC queue (overflow, lifetime)
+    uint64_t backoffs = 0;                  // Backoff procedures started
+    uint64_t backoffSlots = 0;              // Slots drawn for those backoffs
+    uint64_t mcsChanges = 0;                // MCS changes between consecutive data MPDUs
+    std::array<uint64_t, 8> mcsHistogram{}; // Data MPDUs sent per HT MCS
+};
+
+/**
+ * Measurements taken for one sweep point, sent from the worker back to the coordinator.
+ */
+struct PointResult
+{
+    double rss = 0;              // dBm
+    double throughput = 0;       // Kbps
+    uint64_t rxBytes = 0;        // Bytes delivered to the server
+    uint64_t rxPackets = 0;      // Packets delivered to the server
+    uint64_t flows = 0;          // Flows seen by the flow monitor
+    bool connectionLost = false; // A flow did not receive a single byte
+    uint64_t events = 0;         // Simulator events executed
+    double runSeconds = 0;       // Wall time spent in Simulator::Run()
+    MacCounters mac;
+
+    // Frames the server PHY lost, mostly to collisions when clients contend
+    uint64_t rxErrors = 0; // Received with errors
+    uint64_t rxDrops = 0;  // Dropped before the end of their reception
+    double goodput = 0;    // Kbps of application payload the server received
+
+    // Filled in by the coordinator from the worker process
+    double wallSeconds = 0; // Wall time of the whole point
+    long peakRssKb = 0;     // Peak resident set size
+};
+
+static_assert(std::is_trivially_copyable<PointResult>::value,
+              "PointResult is sent through the result ring as a fixed-layout record");
+
+/**
+ * A frame received by the server, sent through the result ring in chunks when RSS time
+ * series are recorded.
+ */
+struct RssSample
+{
+    double time; // seconds
+    double rss;  // dBm
+};
+
+/**
+ * Types of the records workers push into the result ring.
+ */
+enum RingRecordType : uint32_t
+{
+    POINT_RESULT_RECORD, // A PointResult
+    RSS_SAMPLES_RECORD,  // An array of RssSample
+    FLOW_STATS_RECORD    // An array of StoredFlow
+};
+
+inline std::string
+SerializeResult(const PointResult& result)
+{
+    std::ostringstream stream;
+    stream << std::setprecision(17) << result.rss << " " << result.throughput << " "
+           << result.rxBytes << " " << result.rxPackets << " " << result.flows << " "
+           << result.connectionLost << " " << result.events << " " << result.runSeconds;
+    const MacCounters& mac = result.mac;
+    stream << " " << mac.retransmissions << " " << mac.retryLimitDrops << " " << mac.queueDrops
+           << " " << mac.backoffs << " " << mac.backoffSlots << " " << mac.mcsChanges;
+    for (uint64_t count : mac.mcsHistogram)
+    {
+        stream << " " << count;
+    }
+    stream << " " << result.goodput << " " << result.rxErrors << " " << result.rxDrops;
+    return stream.str();
+}
+
+inline PointResult
+DeserializeResult(std::istream& stream)
+{
+    PointResult result;
+    stream >> result.rss >> result.throughput >> result.rxBytes >> result.rxPackets >>
+        result.flows >> result.connectionLost >> result.events >> result.runSeconds;
+    MacCounters& mac = result.mac;
+    stream >> mac.retransmissions >> mac.retryLimitDrops >> mac.queueDrops >> mac.backoffs >>
+        mac.backoffSlots >> mac.mcsChanges;
+    for (uint64_t& count : mac.mcsHistogram)
+    {
+        stream >> count;
+    }
+    stream >> result.goodput >> result.rxErrors >> result.rxDrops;
+    return result;
+}
+
+inline PointResult
+DeserializeResult(const std::string& line)
+{
+    std::istringstream stream(line);
+    return DeserializeResult(stream);
+}
+
+/**
+ * Whether two results of the same point agree in everything a simulation determines, that
+ * is in anything but timing: runSeconds and the wall time and memory of the worker are
+ * measured on the host.
+ */
+inline bool
+SameMeasurements(const PointResult& a, const PointResult& b)
+{
+    return a.rss == b.rss && a.throughput == b.throughput && a.rxBytes == b.rxBytes &&
+           a.rxPackets == b.rxPackets && a.flows == b.flows && a.events == b.events &&
+           a.goodput == b.goodput && a.rxErrors == b.rxErrors && a.rxDrops == b.rxDrops;
+}
+
+/**
+ * Whether a point is the last one of its distance sweep: the connection was lost, or the
+ * models whose RSS does not keep falling with distance reached 500 m.
+ */
+inline bool
+EndsSweep(const SweepPoint& point, const PointResult& result)
+{
+    return result.connectionLost ||
+           (point.distance >= 500 && (point.model == NAKAGAMI || point.model == FIXED_RSS));
+}
+
+/**
+ * Write the header of a per-model output file.
+ */
+inline void
+WriteOutputHeader(std::ostream& outputFile, PropagationModel model)
+{
+    outputFile << "distanceMeters,rssDBm,throughputKbps,";
+    outputFile << propagationModelToString(model) << ",eventsPerByte,wallSecondsPerByte,"
+               << "retransmissions,retryLimitDrops,queueDrops,backoffs,backoffSlots,"
+               << "mcsChanges";
+    for (size_t mcs = 0; mcs < MacCounters().mcsHistogram.size(); mcs++)
+    {
+        outputFile << ",mcs" << mcs;
+    }
+    outputFile << ",eventsPerFrame\n";
+}
+
+/**
+ * Write the row of a point to a per-model output file.
+ */
+inline void
+WriteOutputRow(std::ostream& outputFile, double distance, const PointResult& result)
+{
+    outputFile << distance << "," << result.rss << "," << result.throughput << ",,";
+    if (result.rxBytes > 0)
+    {
+        outputFile << double(result.events) / result.rxBytes << ","
+                   << result.wallSeconds / result.rxBytes;
+    }
+    else
+    {
+        outputFile << ",";
+    }
+
+    const MacCounters& mac = result.mac;
+    outputFile << "," << mac.retransmissions << "," << mac.retryLimitDrops << ","
+               << mac.queueDrops << "," << mac.backoffs << "," << mac.backoffSlots << ","
+               << mac.mcsChanges;
+    for (uint64_t count : mac.mcsHistogram)
+    {
+        outputFile << "," << count;
+    }
+
+    outputFile << ",";
+    if (result.rxPackets > 0)
+    {
+        outputFile << double(result.events) / result.rxPackets;
+    }
+    outputFile << std::endl;
+}
+
+#endif /* SWEEP_POINT_H */
@@ -0,0 +1,1196 @@
+#ifndef SWEEP_SCENARIO_H
+#define SWEEP_SCENARIO_H
+
+#include "abstract-wifi-phy.h"
+#include "antenna-gain-loss-model.h"
+#include "background-interference.h"
+#include "event-log.h"
+#include "fast-propagation-loss-models.h"
+#include "flight-recorder.h"
+#include "node-placement.h"
+#include "result-ring.h"
+#include "result-store.h"
+#include "sweep-executor.h"
+#include "sweep-point.h"
+#include "time-series-store.h"
+
+#include "ns3/applications-module.h"
+#include "ns3/config.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/core-module.h"
+#include "ns3/double.h"
+#include "ns3/flow-monitor-helper.h"
+#include "ns3/flow-monitor-module.h"
+#include "ns3/flow-monitor.h"
+#include "ns3/ht-phy.h"
+#include "ns3/internet-module.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/log.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/mobility-model.h"
+#include "ns3/network-module.h"
+#include "ns3/ofdm-phy.h"
+#include "ns3/packet-sink-helper.h"
+#include "ns3/parabolic-antenna-model.h"
+#include "ns3/spectrum-channel.h"
+#include "ns3/spectrum-helper.h"
+#include "ns3/spectrum-wifi-helper.h"
+#include "ns3/string.h"
+#include "ns3/udp-client-server-helper.h"
+#include "ns3/wifi-mac-header.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/wifi-mpdu.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/yans-wifi-channel.h"
+#include "ns3/yans-wifi-helper.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * The log component of the sweep program, which its main file defines. The functions of
+ * the scenario that log by level bind it to a local g_log, the name the NS_LOG macros use.
+ */
+inline LogComponent&
+SweepLogComponent()
+{
+    static LogComponent& component = GetLogComponent("AdhocWifiPropagationComparison");
+    return component;
+}
+
+/**
+ * Add the loss model under study to a Yans or Spectrum channel helper. With fast math,
+ * Friis, TwoRayGround and ThreeLogDistance are replaced by their fast approximations.
+ */
+template <typename ChannelHelper>
+inline void
+AddPropagationLoss(ChannelHelper& channel, PropagationModel model, const ScenarioConfig& config)
+{
+    const LossParameters& loss = config.loss;
+    std::string prefix = config.fastMath ? "ns3::Fast" : "ns3::";
+    switch (model)
+    {
+    case FRIIS:
+        channel.AddPropagationLoss(prefix + "FriisPropagationLossModel",
+                                   "Frequency",
+                                   DoubleValue(loss.friisFrequency),
+                                   "SystemLoss",
+                                   DoubleValue(loss.friisSystemLoss));
+        break;
+    case FIXED_RSS:
+        channel.AddPropagationLoss("ns3::FixedRssLossModel", "Rss", DoubleValue(loss.fixedRss));
+        break;
+    case THREE_LOG_DISTANCE:
+        channel.AddPropagationLoss(prefix + "ThreeLogDistancePropagationLossModel",
+                                   "Distance0",
+                                   DoubleValue(loss.threeLogDistance0),
+                                   "Distance1",
+                                   DoubleValue(loss.threeLogDistance1),
+                                   "Distance2",
+                                   DoubleValue(loss.threeLogDistance2),
+                                   "Exponent0",
+                                   DoubleValue(loss.threeLogExponent0),
+                                   "Exponent1",
+                                   DoubleValue(loss.threeLogExponent1),
+                                   "Exponent2",
+                                   DoubleValue(loss.threeLogExponent2),
+                                   "ReferenceLoss",
+                                   DoubleValue(loss.threeLogReferenceLoss));
+        break;
+    case TWO_RAY_GROUND:
+        channel.AddPropagationLoss(prefix + "TwoRayGroundPropagationLossModel",
+                                   "Frequency",
+                                   DoubleValue(loss.twoRayFrequency),
+                                   "MinDistance",
+                                   DoubleValue(loss.twoRayMinDistance),
+                                   "SystemLoss",
+                                   DoubleValue(loss.twoRaySystemLoss),
+                                   "HeightAboveZ",
+                                   DoubleValue(config.antennaZ));
+        break;
+    case NAKAGAMI:
+        channel.AddPropagationLoss("ns3::NakagamiPropagationLossModel",
+                                   "Distance1",
+                                   DoubleValue(loss.nakagamiDistance1),
+                                   "Distance2",
+                                   DoubleValue(loss.nakagamiDistance2),
+                                   "m0",
+                                   DoubleValue(loss.nakagamiM0),
+                                   "m1",
+                                   DoubleValue(loss.nakagamiM1),
+                                   "m2",
+                                   DoubleValue(loss.nakagamiM2));
+        break;
+    }
+}
+
+/**
+ * Error rate model of the full PHYs, also given to the interference helper that background
+ * interference installs on the Yans PHY.
+ */
+const std::string ERROR_RATE_MODEL = "ns3::TableBasedErrorRateModel";
+
+inline void
+ConfigurePhy(WifiPhyHelper& wifiPhy, const ScenarioConfig& config)
+{
+    wifiPhy.SetErrorRateModel(ERROR_RATE_MODEL);
+    wifiPhy.Set("TxPowerStart", DoubleValue(config.txPower));
+    wifiPhy.Set("TxPowerEnd", DoubleValue(config.txPower));
+    wifiPhy.Set("RxGain", DoubleValue(config.rxGain));
+    wifiPhy.Set("TxGain", DoubleValue(config.txGain));
+    wifiPhy.Set("ChannelSettings", StringValue("{0, 40, BAND_5GHZ, 0}"));
+}
+
+/**
+ * Install the 802.11n devices on all nodes using the PHY and channel type of the point,
+ * one node after the other, so that device i belongs to node i.
+ *
+ * The Spectrum variant uses a MultiModelSpectrumChannel with the same loss and delay
+ * models as the Yans channel, so the two only differ in how the PHY models reception.
+ * The Abstract variant replaces the reception path of the Yans PHY by a per-frame
+ * effective SINR lookup, see AbstractWifiPhy.
+ */
+inline NetDeviceContainer
+InstallDevices(const SweepPoint& point, const ScenarioConfig& config, NodeContainer& nodes)
+{
+    WifiHelper wifi;
+    wifi.SetStandard(WIFI_STANDARD_80211n);
+
+    const AggregationConfig& aggregation = point.aggregation;
+    Config::SetDefault("ns3::QosTxop::BlockAckThreshold",
+                       UintegerValue(aggregation.blockAckThreshold));
+    Config::SetDefault("ns3::QosTxop::BlockAckInactivityTimeout",
+                       UintegerValue(aggregation.blockAckInactivityTimeout));
+
+    WifiMacHelper wifiMac;
+    wifiMac.SetType("ns3::AdhocWifiMac",
+                    "BE_MaxAmpduSize",
+                    UintegerValue(aggregation.maxAmpduSize),
+                    "BE_MaxAmsduSize",
+                    UintegerValue(aggregation.maxAmsduSize));
+
+    auto install = [&](const WifiPhyHelper& wifiPhy) {
+        NetDeviceContainer devices;
+        for (uint32_t i = 0; i < nodes.GetN(); i++)
+        {
+            devices.Add(wifi.Install(wifiPhy, wifiMac, nodes.Get(i)));
+        }
+        return devices;
+    };
+
+    switch (point.phy)
+    {
+    case YANS: {
+        YansWifiPhyHelper wifiPhy;
+        ConfigurePhy(wifiPhy, config);
+
+        YansWifiChannelHelper wifiChannel;
+        wifiChannel.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
+        AddPropagationLoss(wifiChannel, point.model, config);
+        wifiPhy.SetChannel(wifiChannel.Create());
+
+        return install(wifiPhy);
+    }
+    case SPECTRUM: {
+        SpectrumWifiPhyHelper wifiPhy;
+        ConfigurePhy(wifiPhy, config);
+
+        SpectrumChannelHelper wifiChannel;
+        wifiChannel.SetChannel("ns3::MultiModelSpectrumChannel");
+        wifiChannel.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
+        AddPropagationLoss(wifiChannel, point.model, config);
+        wifiPhy.SetChannel(wifiChannel.Create());
+
+        return install(wifiPhy);
+    }
+    case ABSTRACT: {
+        AbstractWifiPhyHelper wifiPhy;
+        ConfigurePhy(wifiPhy, config);
+
+        YansWifiChannelHelper wifiChannel;
+        wifiChannel.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
+        AddPropagationLoss(wifiChannel, point.model, config);
+        wifiPhy.SetChannel(wifiChannel.Create());
+
+        return install(wifiPhy);
+    }
+    }
+    NS_ABORT_MSG("Unhandled PHY type");
+}
+
+/**
+ * Surround the server with the configured number of background interferers, evenly spaced
+ * on a circle, and those of the placement file, and inject their aggregate power into the
+ * interference tracker of its PHY.
+ *
+ * The interference goes through the loss model of the channel. With the full Yans PHY,
+ * the interference helper of the PHY is replaced by one the process can feed foreign
+ * signals into, with the same error rate model as the one ConfigurePhy installs.
+ */
+inline Ptr<BackgroundInterference>
+InstallBackgroundInterference(const ScenarioConfig& config, Ptr<NetDevice> device)
+{
+    Ptr<WifiPhy> phy = DynamicCast<WifiNetDevice>(device)->GetPhy();
+    Ptr<YansWifiChannel> channel = DynamicCast<YansWifiChannel>(phy->GetChannel());
+    NS_ABORT_MSG_IF(!channel, "Background interference needs the Yans or Abstract PHY");
+
+    PointerValue loss;
+    channel->GetAttribute("PropagationLossModel", loss);
+
+    Ptr<BackgroundInterference> interference = CreateObject<BackgroundInterference>();
+    interference->SetAttribute("TxPower", StringValue(config.interfererTxPower));
+    interference->SetLossModel(loss.Get<PropagationLossModel>());
+
+    Ptr<MobilityModel> mobility = device->GetNode()->GetObject<MobilityModel>();
+    Vector center = mobility->GetPosition();
+    for (uint32_t i = 0; i < config.interferers; i++)
+    {
+        double angle = 2 * M_PI * i / config.interferers;
+        interference->AddInterferer(Vector(center.x + config.interfererDistance * std::cos(angle),
+                                           center.y + config.interfererDistance * std::sin(angle),
+                                           center.z),
+                                    config.interfererDutyCycle);
+    }
+    if (config.placement)
+    {
+        // Placed relative to the server on the ground, at the antenna height of the server
+        // unless the file has one, with the duty cycle and transmit power of their rows
+        const NodePlacement& placement = *config.placement;
+        int dutyCycle = placement.Column("dutyCycle");
+        int txPower = placement.Column("txPower");
+        for (uint64_t row = 0; row < placement.GetRows(); row++)
+        {
+            Vector position = placement.GetPosition(row, center.z);
+            interference->AddInterferer(
+                Vector(center.x + position.x, center.y + position.y, position.z),
+                dutyCycle < 0 ? config.interfererDutyCycle : placement.GetValue(row, dutyCycle),
+                txPower < 0 ? NAN : placement.GetValue(row, txPower));
+        }
+    }
+
+    if (Ptr<AbstractWifiPhy> abstractPhy = DynamicCast<AbstractWifiPhy>(phy))
+    {
+        interference->AddReceiver(mobility,
+                                  MakeCallback(&AbstractWifiPhy::AddInterference, abstractPhy));
+    }
+    else
+    {
+        Ptr<InterferenceHelper> interferenceHelper = CreateObject<InterferenceHelper>();
+        phy->SetInterferenceHelper(interferenceHelper);
+        // WifiPhy keeps no reference to the error rate model, only the replaced helper does
+        phy->SetErrorRateModel(ObjectFactory(ERROR_RATE_MODEL).Create<ErrorRateModel>());
+        interference->AddReceiver(mobility,
+                                  MakeBoundCallback(&InjectForeignSignal, interferenceHelper, phy));
+    }
+
+    interference->Start(Seconds(0));
+    return interference;
+}
+
+/**
+ * Get the loss model chain of the channel a Wi-Fi device is attached to.
+ */
+inline Ptr<PropagationLossModel>
+GetLossModel(Ptr<NetDevice> device)
+{
+    Ptr<Channel> channel = DynamicCast<WifiNetDevice>(device)->GetPhy()->GetChannel();
+    if (Ptr<SpectrumChannel> spectrumChannel = DynamicCast<SpectrumChannel>(channel))
+    {
+        return spectrumChannel->GetPropagationLossModel();
+    }
+    PointerValue loss;
+    channel->GetAttribute("PropagationLossModel", loss);
+    return loss.Get<PropagationLossModel>();
+}
+
+/**
+ * Build the gain table of the configured directional antenna.
+ */
+inline Ptr<AntennaGainTable>
+CreateAntennaGainTable(const ScenarioConfig& config)
+{
+    if (config.antenna == "Parabolic")
+    {
+        Ptr<ParabolicAntennaModel> antenna = CreateObject<ParabolicAntennaModel>();
+        antenna->SetAttribute("Beamwidth", DoubleValue(config.antennaBeamwidth));
+        return Create<AntennaGainTable>(antenna);
+    }
+    return Create<AntennaGainTable>(config.antenna);
+}
+
+/**
+ * Give both nodes the configured directional antenna, pointing at each other unless
+ * misaligned, by appending their gains to the loss chain of the channel.
+ */
+inline void
+InstallAntennas(const ScenarioConfig& config, Ptr<NetDevice> server, Ptr<NetDevice> client)
+{
+    if (config.antenna == "Isotropic")
+    {
+        return;
+    }
+
+    Ptr<AntennaGainTable> table = CreateAntennaGainTable(config);
+    double misalignment = config.antennaMisalignment * M_PI / 180;
+    Ptr<AntennaGainLossModel> gains = CreateObject<AntennaGainLossModel>();
+    gains->AddAntenna(server->GetNode()->GetObject<MobilityModel>(), table, misalignment);
+    gains->AddAntenna(client->GetNode()->GetObject<MobilityModel>(),
+                      table,
+                      M_PI + misalignment);
+
+    Ptr<PropagationLossModel> last = GetLossModel(server);
+    while (last->GetNext())
+    {
+        last = last->GetNext();
+    }
+    last->SetNext(gains);
+}
+
+/**
+ * Route the packets of a relay chain, node 0 (the server) to the last node (the client)
+ * on a line, with static host routes from a next-hop table instead of a routing protocol,
+ * so that the simulation spends no events on routing. The table is computed up front from
+ * the topology: a node reaches every node further along the line through its neighbour in
+ * that direction. Neighbours need no route, they are on the link.
+ */
+inline void
+InstallChainRoutes(const Ipv4InterfaceContainer& interfaces)
+{
+    uint32_t nodes = interfaces.GetN();
+    std::vector<std::vector<uint32_t>> nextHop(nodes, std::vector<uint32_t>(nodes));
+    for (uint32_t node = 0; node < nodes; node++)
+    {
+        for (uint32_t destination = 0; destination < nodes; destination++)
+        {
+            nextHop[node][destination] = destination > node   ? node + 1
+                                         : destination < node ? node - 1
+                                                              : node;
+        }
+    }
+
+    Ipv4StaticRoutingHelper routingHelper;
+    for (uint32_t node = 0; node < nodes; node++)
+    {
+        auto [ipv4, interface] = interfaces.Get(node);
+        Ptr<Ipv4StaticRouting> routing = routingHelper.GetStaticRouting(ipv4);
+        for (uint32_t destination = 0; destination < nodes; destination++)
+        {
+            if (nextHop[node][destination] != destination)
+            {
+                routing->AddHostRouteTo(interfaces.GetAddress(destination),
+                                        interfaces.GetAddress(nextHop[node][destination]),
+                                        interface);
+            }
+        }
+    }
+}
+
+/**
+ * What the options of the program and the point a worker simulates leave to the trace
+ * callbacks of the scenario. A program has one, sweepState.
+ */
+struct SweepState
+{
+    // Where workers write the event log, the flow monitor statistics as XML and the
+    // windowed goodput and RSS of every point they simulate, if anywhere
+    std::string eventLogDirectory;
+    std::string flowXmlDirectory;
+    std::string timeSeriesStore;
+    double timeSeriesInterval = 0.01; //!< Window of the time series in seconds
+
+    // Where workers dump their flight recorder when it triggers, created on the first dump
+    std::string flightRecorderDirectory = "flight-recorder";
+    FlightRecorderTriggers flightRecorderTriggers;
+
+    double averageRSS = 0; //!< Moving average of the RSS at the server
+
+    // Where a worker sends its RSS time series and flow statistics, if it records them
+    ResultRing* rssRing = nullptr;
+    ResultRing* flowRing = nullptr;
+    uint32_t ringTask = 0;
+    std::vector<RssSample> rssSamples;
+
+    std::unique_ptr<EventLogWriter> eventLog;
+
+    // The time series of the point and what the server received in the current window
+    std::unique_ptr<TimeSeriesWriter> timeSeries;
+    uint64_t windowRxBytes = 0;
+    double windowRssSum = 0;
+    uint32_t windowRssFrames = 0;
+
+    std::unique_ptr<FlightRecorder> flightRecorder;
+    std::string flightRecorderPrefix;
+    std::string flightRecorderDescription;
+    bool flightRecorderDumped = false;
+    Time lastAppRx;            //!< Last packet of the server application
+    double flightRssMean = 0;  //!< Moving average of the RSS for the outlier trigger
+    uint64_t flightRssFrames = 0; //!< Frames in flightRssMean
+
+    MacCounters macCounters;
+    int lastMcs = -1; //!< MCS of the previous data frame, -1 before the first one
+    uint64_t serverRxErrors = 0;
+    uint64_t serverRxDrops = 0;
+};
+
+inline SweepState sweepState;
+
+/**
+ * Push the RSS samples recorded so far into the result ring as one chunk.
+ */
+inline void
+FlushRssSamples()
+{
+    if (!sweepState.rssSamples.empty())
+    {
+        sweepState.rssRing->Push(RSS_SAMPLES_RECORD,
+                                 sweepState.ringTask,
+                                 sweepState.rssSamples.data(),
+                                 sweepState.rssSamples.size() * sizeof(RssSample));
+        sweepState.rssSamples.clear();
+    }
+}
+
+/**
+ * Name of the files of a single sweep point: its output file name without the extension,
+ * followed by its distance.
+ */
+inline std::string
+PointFileStem(const SweepPoint& point)
+{
+    std::string name = outputFileName(point);
+    std::ostringstream stem;
+    stem << name.substr(0, name.size() - 4) << "_d" << point.distance;
+    return stem.str();
+}
+
+/**
+ * Path of the event log of a sweep point in eventLogDirectory.
+ */
+inline std::string
+EventLogFileName(const SweepPoint& point)
+{
+    return sweepState.eventLogDirectory + "/" + PointFileStem(point) + ".evlog";
+}
+
+/**
+ * \return the HT MCS of a transmission, or EVENT_LOG_NO_MCS
+ */
+inline uint32_t
+EventLogMcs(const WifiTxVector& txVector)
+{
+    return txVector.GetModulationClass() == WIFI_MOD_CLASS_HT ? txVector.GetMode().GetMcsValue()
+                                                              : EVENT_LOG_NO_MCS;
+}
+
+/**
+ * Dump the flight recorder of the running point, unless it has been dumped already: the
+ * frames leading up to the first anomaly are the interesting ones.
+ */
+inline void
+DumpFlightRecorder(const std::string& reason)
+{
+    if (sweepState.flightRecorder && !sweepState.flightRecorderDumped)
+    {
+        sweepState.flightRecorderDumped = true;
+        mkdir(sweepState.flightRecorderDirectory.c_str(), 0755);
+        NS_LOG_UNCOND("Flight recorder triggered by " << reason << ", dumping to "
+                                                      << sweepState.flightRecorderPrefix);
+        sweepState.flightRecorder->Dump(sweepState.flightRecorderPrefix,
+                                        reason,
+                                        sweepState.flightRecorderDescription);
+    }
+}
+
+/**
+ * Dump the flight recorder when the worker dies of a signal, then die of it as well.
+ * Dumping allocates and is not async-signal-safe, so this is best effort, but the usual
+ * failure is an abort from an assertion in the simulation thread, where it works.
+ */
+inline void
+FlightRecorderSignalHandler(int signal)
+{
+    DumpFlightRecorder(std::string("signal ") + strsignal(signal));
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
+
+/**
+ * Trigger the flight recorder if the server application has not received a packet for
+ * the stall time, and check again later otherwise. Only a flow that received packets
+ * can stall: a point that never connects, e.g. past the range of the link, is left to
+ * the lost trigger.
+ */
+inline void
+CheckStall(Time end)
+{
+    Time stall = Seconds(sweepState.flightRecorderTriggers.stall);
+    const Time& lastAppRx = sweepState.lastAppRx;
+    if (!lastAppRx.IsStrictlyNegative() && Simulator::Now() - lastAppRx >= stall)
+    {
+        std::ostringstream reason;
+        reason << "stall since " << lastAppRx.GetSeconds() << " s";
+        DumpFlightRecorder(reason.str());
+    }
+    else if (Simulator::Now() + stall / 2 < end)
+    {
+        Simulator::Schedule(stall / 2, &CheckStall, end);
+    }
+}
+
+inline void
+FlightRecorderTx(uint32_t node,
+                 Ptr<const Packet> packet,
+                 uint16_t channelFreqMhz,
+                 WifiTxVector txVector,
+                 MpduInfo aMpdu,
+                 uint16_t staId)
+{
+    sweepState.flightRecorder->RecordTx(node, packet, channelFreqMhz, txVector);
+}
+
+inline void
+FlightRecorderRx(uint32_t node,
+                 Ptr<const Packet> packet,
+                 uint16_t channelFreqMhz,
+                 WifiTxVector txVector,
+                 MpduInfo aMpdu,
+                 SignalNoiseDbm signalNoise,
+                 uint16_t staId)
+{
+    sweepState.flightRecorder->RecordRx(node, packet, channelFreqMhz, txVector, signalNoise);
+}
+
+inline void
+FlightRecorderDrop(uint32_t node, WifiMacDropReason reason, Ptr<const WifiMpdu> mpdu)
+{
+    sweepState.flightRecorder->RecordDrop(node, reason);
+}
+
+/**
+ * Trigger the flight recorder if a frame the server receives deviates from the mean RSS
+ * of the recent frames by more than the threshold. The mean is an exponential moving
+ * average over about 16 frames and is only trusted after as many frames.
+ */
+inline void
+CheckRssOutlier(double signal)
+{
+    if (sweepState.flightRssFrames >= 16 &&
+        std::fabs(signal - sweepState.flightRssMean) > sweepState.flightRecorderTriggers.rssOutlier)
+    {
+        std::ostringstream reason;
+        reason << "rss outlier " << signal << " dBm against a mean of " << sweepState.flightRssMean
+               << " dBm";
+        DumpFlightRecorder(reason.str());
+    }
+    double& mean = sweepState.flightRssMean;
+    mean = sweepState.flightRssFrames ? mean + (signal - mean) / 16 : signal;
+    sweepState.flightRssFrames++;
+}
+
+inline void
+PhyTrace(Ptr<const Packet> packet,
+         uint16_t channelFreqMhz,
+         WifiTxVector txVector,
+         MpduInfo aMpdu,
+         SignalNoiseDbm signalNoise,
+         uint16_t staId)
+
+{
+    [[maybe_unused]] LogComponent& g_log = SweepLogComponent();
+    NS_LOG_DEBUG("Received packet with signal: " << signalNoise.signal
+                                                 << ", noise: " << signalNoise.noise);
+    sweepState.averageRSS = (signalNoise.signal + sweepState.averageRSS) / 2.;
+    sweepState.windowRssSum += signalNoise.signal;
+    sweepState.windowRssFrames++;
+
+    if (sweepState.rssRing)
+    {
+        sweepState.rssSamples.push_back({Simulator::Now().GetSeconds(), signalNoise.signal});
+        if ((sweepState.rssSamples.size() + 1) * sizeof(RssSample) >
+            sweepState.rssRing->PayloadSize())
+        {
+            FlushRssSamples();
+        }
+    }
+    if (sweepState.eventLog)
+    {
+        sweepState.eventLog->PhyRx(Simulator::Now().GetNanoSeconds(),
+                                   signalNoise.signal,
+                                   signalNoise.noise,
+                                   EventLogMcs(txVector),
+                                   packet->GetSize());
+    }
+    if (sweepState.flightRecorderTriggers.rssOutlier > 0 && sweepState.flightRecorder)
+    {
+        CheckRssOutlier(signalNoise.signal);
+    }
+}
+
+inline void
+MacTxTrace(Ptr<const Packet> packet,
+           uint16_t channelFreqMhz,
+           WifiTxVector txVector,
+           MpduInfo aMpdu,
+           uint16_t staId)
+{
+    WifiMacHeader header;
+    packet->PeekHeader(header);
+    if (!header.IsData())
+    {
+        return;
+    }
+
+    if (header.IsRetry())
+    {
+        sweepState.macCounters.retransmissions++;
+    }
+    if (sweepState.eventLog)
+    {
+        sweepState.eventLog->MacTx(Simulator::Now().GetNanoSeconds(),
+                                   header.IsRetry(),
+                                   EventLogMcs(txVector),
+                                   packet->GetSize());
+    }
+
+    if (txVector.GetModulationClass() == WIFI_MOD_CLASS_HT)
+    {
+        int mcs = txVector.GetMode().GetMcsValue();
+        if (mcs < static_cast<int>(sweepState.macCounters.mcsHistogram.size()))
+        {
+            sweepState.macCounters.mcsHistogram[mcs]++;
+        }
+        if (sweepState.lastMcs >= 0 && mcs != sweepState.lastMcs)
+        {
+            sweepState.macCounters.mcsChanges++;
+        }
+        sweepState.lastMcs = mcs;
+    }
+}
+
+inline void
+MacDropTrace(WifiMacDropReason reason, Ptr<const WifiMpdu> mpdu)
+{
+    EventLogDropReason logReason = DROP_OTHER;
+    switch (reason)
+    {
+    case WIFI_MAC_DROP_REACHED_RETRY_LIMIT:
+        sweepState.macCounters.retryLimitDrops++;
+        logReason = DROP_RETRY_LIMIT;
+        break;
+    case WIFI_MAC_DROP_FAILED_ENQUEUE:
+    case WIFI_MAC_DROP_EXPIRED_LIFETIME:
+        sweepState.macCounters.queueDrops++;
+        logReason = DROP_QUEUE;
+        break;
+    default:
+        break;
+    }
+    if (sweepState.eventLog)
+    {
+        sweepState.eventLog->MacDrop(Simulator::Now().GetNanoSeconds(), logReason);
+    }
+}
+
+inline void
+AppRxTrace(Ptr<const Packet> packet)
+{
+    if (sweepState.eventLog)
+    {
+        sweepState.eventLog->AppRx(Simulator::Now().GetNanoSeconds(), packet->GetSize());
+    }
+    sweepState.windowRxBytes += packet->GetSize();
+    sweepState.lastAppRx = Simulator::Now();
+}
+
+inline void
+SinkRxTrace(Ptr<const Packet> packet, const Address& from)
+{
+    AppRxTrace(packet);
+}
+
+/**
+ * Append the goodput and mean RSS of the server over the window that just ended to the
+ * time series store, NaN if it received no frame, and start the next window.
+ */
+inline void
+SampleTimeSeries(Time end)
+{
+    int64_t now = Simulator::Now().GetNanoSeconds();
+    SweepState& state = sweepState;
+    // Application payload, not the flow monitor bytes the throughput column counts
+    state.timeSeries->Append("goodputKbps",
+                             now,
+                             state.windowRxBytes * 8.0 / state.timeSeriesInterval / 1024); // Kbps
+    state.timeSeries->Append("rssDbm",
+                             now,
+                             state.windowRssFrames ? state.windowRssSum / state.windowRssFrames
+                                                   : NAN);
+    state.windowRxBytes = 0;
+    state.windowRssSum = 0;
+    state.windowRssFrames = 0;
+    if (Simulator::Now() + Seconds(state.timeSeriesInterval) <= end)
+    {
+        Simulator::Schedule(Seconds(state.timeSeriesInterval), &SampleTimeSeries, end);
+    }
+}
+
+inline void
+BackoffTrace(uint32_t slots, uint8_t linkId)
+{
+    sweepState.macCounters.backoffs++;
+    sweepState.macCounters.backoffSlots += slots;
+}
+
+inline void
+ServerRxErrorTrace(Ptr<const Packet> packet, double snr)
+{
+    sweepState.serverRxErrors++;
+}
+
+inline void
+ServerRxDropTrace(Ptr<const Packet> packet, WifiPhyRxfailureReason reason)
+{
+    sweepState.serverRxDrops++;
+}
+
+/**
+ * Simulate a single sweep point. Runs inside a worker process.
+ */
+inline PointResult
+RunPoint(const SweepPoint& point, const ScenarioConfig& config)
+{
+    [[maybe_unused]] LogComponent& g_log = SweepLogComponent();
+    NS_LOG_UNCOND("Running simulation for distance=" << point.distance << "m with "
+                                                     << phyTypeToString(point.phy) << " PHY");
+
+    // delay between packets
+    const double dataRate =
+        point.transport.type == UDP_SATURATING ? SATURATING_DATA_RATE : config.dataRate;
+    const double interval = 1 / (dataRate / (config.packetSize * 8));
+    const uint64_t packetLimit = config.simulationTime / interval;
+
+    sweepState.averageRSS = 0;
+    sweepState.macCounters = MacCounters();
+    sweepState.lastMcs = -1;
+    sweepState.serverRxErrors = 0;
+    sweepState.serverRxDrops = 0;
+
+    RngSeedManager::SetRun(point.seed);
+
+    if (!sweepState.eventLogDirectory.empty())
+    {
+        std::string fileName = EventLogFileName(point);
+        sweepState.eventLog = std::make_unique<EventLogWriter>(
+            fileName,
+            EventLogHeader{FormatRequest(point),
+                           ConfigHash(config),
+                           transportTypeToString(point.transport.type),
+                           config.simulationTime});
+        NS_ABORT_MSG_IF(!sweepState.eventLog->Ok(), "Cannot create " << fileName);
+    }
+    if (!sweepState.timeSeriesStore.empty())
+    {
+        // All workers append to the same store, each point being a run of its own
+        sweepState.timeSeries =
+            std::make_unique<TimeSeriesWriter>(sweepState.timeSeriesStore, FormatRequest(point));
+        NS_ABORT_MSG_IF(!sweepState.timeSeries->Ok(), "Cannot open " << sweepState.timeSeriesStore);
+        sweepState.windowRxBytes = 0;
+        sweepState.windowRssSum = 0;
+        sweepState.windowRssFrames = 0;
+        Simulator::Schedule(Seconds(sweepState.timeSeriesInterval),
+                            &SampleTimeSeries,
+                            Seconds(config.simulationTime));
+    }
+
+    Time interPacketInterval = Seconds(interval);
+    const Time clientStart = Seconds(2.0);
+
+    // The server is node 0 and the clients the last nodes. The relays of a chain are
+    // between them on a line, all a distance apart; contending clients are evenly spaced
+    // on a circle of that radius around the server
+    NodeContainer nodes;
+    nodes.Create(point.hops + point.clients);
+
+    // Before the internet stack creates the TCP protocol of the nodes, and for every point,
+    // as the workers run one point after the other
+    if (point.transport.type == TCP_BULK)
+    {
+        Config::SetDefault(
+            "ns3::TcpL4Protocol::SocketType",
+            TypeIdValue(TypeId::LookupByName("ns3::" + point.transport.congestionControl)));
+        Config::SetDefault("ns3::TcpSocket::SegmentSize",
+                           UintegerValue(point.transport.segmentSize));
+    }
+
+    InternetStackHelper stack;
+    stack.Install(nodes);
+
+    MobilityHelper mobility;
+    Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator>();
+    positionAlloc->Add(Vector(0.0, 0.0, config.antennaZ));
+    for (uint32_t i = 1; i < nodes.GetN(); i++)
+    {
+        if (point.clients > 1)
+        {
+            double angle = 2 * M_PI * (i - 1) / point.clients;
+            positionAlloc->Add(Vector(point.distance * std::cos(angle),
+                                      point.distance * std::sin(angle),
+                                      config.antennaZ));
+        }
+        else
+        {
+            positionAlloc->Add(Vector(i * point.distance, 0.0, config.antennaZ));
+        }
+    }
+    mobility.SetPositionAllocator(positionAlloc);
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.Install(nodes);
+
+    NetDeviceContainer devices = InstallDevices(point, config, nodes);
+    InstallAntennas(config, devices.Get(0), devices.Get(point.hops));
+
+    Ptr<BackgroundInterference> backgroundInterference;
+    if (config.interferers > 0 || config.placement)
+    {
+        backgroundInterference = InstallBackgroundInterference(config, devices.Get(0));
+    }
+
+    Ipv4AddressHelper address;
+    if (nodes.GetN() < 255)
+    {
+        address.SetBase("10.1.1.0", "255.255.255.0");
+    }
+    else
+    {
+        address.SetBase("10.1.0.0", "255.255.0.0");
+    }
+
+    Ipv4InterfaceContainer interfaces = address.Assign(devices);
+    if (point.hops > 1)
+    {
+        InstallChainRoutes(interfaces);
+    }
+
+    NodeContainer clients;
+    for (uint32_t i = point.hops; i < nodes.GetN(); i++)
+    {
+        clients.Add(nodes.Get(i));
+    }
+
+    // UDP clients send to a UdpServer at a fixed rate, TCP clients send to a PacketSink as
+    // fast as their congestion control allows
+    ApplicationContainer serverApp;
+    ApplicationContainer clientApp;
+    uint16_t port = 9;
+    Address serverAddr = Address(interfaces.GetAddress(0));
+    if (point.transport.type == TCP_BULK)
+    {
+        NS_LOG_INFO("Create PacketSink application on node 0.");
+        PacketSinkHelper sink("ns3::TcpSocketFactory",
+                              InetSocketAddress(Ipv4Address::GetAny(), port));
+        serverApp = sink.Install(nodes.Get(0));
+        if (sweepState.eventLog || sweepState.timeSeries ||
+            sweepState.flightRecorderTriggers.stall > 0)
+        {
+            serverApp.Get(0)->TraceConnectWithoutContext("Rx", MakeCallback(&SinkRxTrace));
+        }
+
+        BulkSendHelper client("ns3::TcpSocketFactory",
+                              InetSocketAddress(interfaces.GetAddress(0), port));
+        client.SetAttribute("MaxBytes", UintegerValue(0));
+        client.SetAttribute("SendSize", UintegerValue(point.transport.segmentSize));
+        clientApp = client.Install(clients);
+    }
+    else
+    {
+        NS_LOG_INFO("Create UdpServer application on node 0.");
+        UdpServerHelper server(port);
+        serverApp = server.Install(nodes.Get(0));
+        if (sweepState.eventLog || sweepState.timeSeries ||
+            sweepState.flightRecorderTriggers.stall > 0)
+        {
+            serverApp.Get(0)->TraceConnectWithoutContext("Rx", MakeCallback(&AppRxTrace));
+        }
+
+        UdpClientHelper client(serverAddr, port);
+        client.SetAttribute("MaxPackets", UintegerValue(packetLimit));
+        client.SetAttribute("Interval", TimeValue(interPacketInterval));
+        client.SetAttribute("PacketSize", UintegerValue(config.packetSize));
+        clientApp = client.Install(clients);
+    }
+    serverApp.Start(Seconds(1.0));
+    serverApp.Stop(Seconds(config.simulationTime));
+    clientApp.Start(clientStart);
+    clientApp.Stop(Seconds(config.simulationTime));
+
+    FlowMonitorHelper flowMonitorHelper;
+    Ptr<FlowMonitor> flowMonitor = flowMonitorHelper.InstallAll();
+
+    Config::ConnectWithoutContext(
+        "/NodeList/0/DeviceList/1/$ns3::WifiNetDevice/Phy/MonitorSnifferRx",
+        MakeCallback(&PhyTrace));
+    Config::ConnectWithoutContext(
+        "/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/MonitorSnifferTx",
+        MakeCallback(&MacTxTrace));
+    Config::ConnectWithoutContext("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Mac/DroppedMpdu",
+                                  MakeCallback(&MacDropTrace));
+    Config::ConnectWithoutContext(
+        "/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Mac/BE_Txop/BackoffTrace",
+        MakeCallback(&BackoffTrace));
+    Config::ConnectWithoutContext("/NodeList/0/DeviceList/1/$ns3::WifiNetDevice/Phy/State/RxError",
+                                  MakeCallback(&ServerRxErrorTrace));
+    Config::ConnectWithoutContext("/NodeList/0/DeviceList/1/$ns3::WifiNetDevice/Phy/PhyRxDrop",
+                                  MakeCallback(&ServerRxDropTrace));
+
+    std::vector<std::pair<int, void (*)(int)>> previousHandlers;
+    // Always on: recording costs a few stores per frame, and nothing is written unless
+    // a trigger fires
+    sweepState.flightRecorder =
+        std::make_unique<FlightRecorder>(NodeList::GetNNodes(),
+                                         sweepState.flightRecorderTriggers.frames);
+    sweepState.flightRecorderPrefix =
+        sweepState.flightRecorderDirectory + "/" + PointFileStem(point);
+    sweepState.flightRecorderDescription =
+        "request " + FormatRequest(point) + "\nconfig " + ConfigHash(config) + "\n";
+    sweepState.flightRecorderDumped = false;
+    sweepState.flightRssFrames = 0;
+    sweepState.lastAppRx = Seconds(-1); // No packet yet
+    for (uint32_t node = 0; node < NodeList::GetNNodes(); node++)
+    {
+        for (uint32_t i = 0; i < NodeList::GetNode(node)->GetNDevices(); i++)
+        {
+            Ptr<WifiNetDevice> device =
+                DynamicCast<WifiNetDevice>(NodeList::GetNode(node)->GetDevice(i));
+            if (!device)
+            {
+                continue;
+            }
+            device->GetPhy()->TraceConnectWithoutContext(
+                "MonitorSnifferTx",
+                MakeBoundCallback(&FlightRecorderTx, node));
+            device->GetPhy()->TraceConnectWithoutContext(
+                "MonitorSnifferRx",
+                MakeBoundCallback(&FlightRecorderRx, node));
+            device->GetMac()->TraceConnectWithoutContext(
+                "DroppedMpdu",
+                MakeBoundCallback(&FlightRecorderDrop, node));
+        }
+    }
+    if (sweepState.flightRecorderTriggers.stall > 0)
+    {
+        Simulator::Schedule(clientStart + Seconds(sweepState.flightRecorderTriggers.stall),
+                            &CheckStall,
+                            Seconds(config.simulationTime));
+    }
+    for (int signal : {SIGABRT, SIGSEGV, SIGBUS, SIGFPE})
+    {
+        previousHandlers.emplace_back(signal, std::signal(signal, &FlightRecorderSignalHandler));
+    }
+
+    PointResult result;
+
+    Simulator::Stop(Seconds(config.simulationTime));
+    auto runStart = std::chrono::steady_clock::now();
+    Simulator::Run();
+    result.runSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    result.events = Simulator::GetEventCount();
+    if (sweepState.rssRing)
+    {
+        FlushRssSamples();
+    }
+    if (sweepState.eventLog)
+    {
+        sweepState.eventLog->Flush();
+        NS_ABORT_MSG_IF(!sweepState.eventLog->Ok(), "Cannot write " << EventLogFileName(point));
+        sweepState.eventLog.reset();
+    }
+    if (sweepState.timeSeries)
+    {
+        sweepState.timeSeries->Flush();
+        NS_ABORT_MSG_IF(!sweepState.timeSeries->Ok(),
+                        "Cannot write " << sweepState.timeSeriesStore);
+        sweepState.timeSeries.reset();
+    }
+
+    flowMonitor->CheckForLostPackets();
+    if (!sweepState.flowXmlDirectory.empty())
+    {
+        flowMonitor->SerializeToXmlFile(sweepState.flowXmlDirectory + "/" + PointFileStem(point) +
+                                            ".flow.xml",
+                                        true,
+                                        true);
+    }
+
+    FlowMonitor::FlowStatsContainer stats = flowMonitor->GetFlowStats();
+
+    result.rss = sweepState.averageRSS;
+    result.mac = sweepState.macCounters;
+    result.rxErrors = sweepState.serverRxErrors;
+    result.rxDrops = sweepState.serverRxDrops;
+    Ptr<Ipv4FlowClassifier> classifier =
+        DynamicCast<Ipv4FlowClassifier>(flowMonitorHelper.GetClassifier());
+    for (auto it = stats.begin(); it != stats.end(); ++it)
+    {
+        // Only the flows to the server, not the acknowledgements of TCP flowing back
+        if (classifier->FindFlow(it->first).destinationAddress != interfaces.GetAddress(0))
+        {
+            continue;
+        }
+        result.throughput += it->second.rxBytes * 8.0 / (config.simulationTime) / 1024; // Kbps
+        result.rxBytes += it->second.rxBytes;
+        result.rxPackets += it->second.rxPackets;
+        result.flows++;
+
+        if (it->second.rxBytes == 0)
+        {
+            result.connectionLost = true;
+        }
+    }
+    uint64_t goodputBytes =
+        point.transport.type == TCP_BULK
+            ? DynamicCast<PacketSink>(serverApp.Get(0))->GetTotalRx()
+            : DynamicCast<UdpServer>(serverApp.Get(0))->GetReceived() * config.packetSize;
+    result.goodput = goodputBytes * 8.0 / config.simulationTime / 1024; // Kbps
+    if (sweepState.flowRing)
+    {
+        std::vector<StoredFlow> flows;
+        for (const auto& [flowId, flow] : stats)
+        {
+            flows.push_back({flowId,
+                             flow.txBytes,
+                             flow.rxBytes,
+                             flow.txPackets,
+                             flow.rxPackets,
+                             flow.lostPackets,
+                             flow.delaySum.GetSeconds(),
+                             flow.jitterSum.GetSeconds()});
+        }
+        size_t chunk = sweepState.flowRing->PayloadSize() / sizeof(StoredFlow);
+        for (size_t i = 0; i < flows.size(); i += chunk)
+        {
+            sweepState.flowRing->Push(FLOW_STATS_RECORD,
+                                      sweepState.ringTask,
+                                      flows.data() + i,
+                                      std::min(chunk, flows.size() - i) * sizeof(StoredFlow));
+        }
+    }
+
+    if (sweepState.flightRecorderTriggers.lost && result.rxPackets == 0)
+    {
+        DumpFlightRecorder("lost");
+    }
+    for (auto [signal, handler] : previousHandlers)
+    {
+        std::signal(signal, handler);
+    }
+    sweepState.flightRecorder.reset();
+
+    Simulator::Destroy();
+
+    return result;
+}
+
+/**
+ * Simulate points in forked workers, at most jobs at a time, which push their results as
+ * fixed-layout records into the shared memory ring instead of sending text through their
+ * pipes. The coordinator drains the ring while the workers run.
+ *
+ * \param ring the result ring, created before any worker was forked
+ * \param points the points
+ * \param config the scenario parameters
+ * \param jobs the maximum number of concurrent workers
+ * \param handleSamples if set, workers record the RSS time series of the server, and it
+ *        is called with every chunk straight from the ring
+ * \param handleFlows if set, workers send the flow monitor statistics of every point, and
+ *        it is called with them straight from the ring
+ * \return the result of every point, with wall time and peak memory, or nothing if its
+ *         worker failed
+ */
+inline std::vector<std::optional<PointResult>>
+RunPoints(ResultRing& ring,
+          const std::vector<SweepPoint>& points,
+          const ScenarioConfig& config,
+          unsigned jobs,
+          const std::function<void(const SweepPoint&, const RssSample*, size_t)>& handleSamples =
+              nullptr,
+          const std::function<void(size_t, const StoredFlow*, size_t)>& handleFlows = nullptr)
+{
+    std::vector<std::optional<PointResult>> results(points.size());
+    std::vector<TaskOutcome> outcomes = RunTasks(
+        points.size(),
+        [&](size_t i) {
+            sweepState.ringTask = i;
+            if (handleSamples)
+            {
+                sweepState.rssRing = &ring;
+            }
+            if (handleFlows)
+            {
+                sweepState.flowRing = &ring;
+            }
+            PointResult result = RunPoint(points[i], config);
+            ring.Push(POINT_RESULT_RECORD, i, &result, sizeof(result));
+            return std::string();
+        },
+        jobs,
+        [&]() {
+            ring.Drain([&](uint32_t type, uint32_t task, const void* data, size_t size) {
+                if (type == POINT_RESULT_RECORD)
+                {
+                    results[task].emplace();
+                    std::memcpy(&*results[task], data, size);
+                }
+                else if (type == RSS_SAMPLES_RECORD && handleSamples)
+                {
+                    handleSamples(points[task],
+                                  static_cast<const RssSample*>(data),
+                                  size / sizeof(RssSample));
+                }
+                else if (type == FLOW_STATS_RECORD && handleFlows)
+                {
+                    handleFlows(task,
+                                static_cast<const StoredFlow*>(data),
+                                size / sizeof(StoredFlow));
+                }
+            });
+        });
+
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        if (!outcomes[i].succeeded)
+        {
+            results[i].reset();
+        }
+        else if (results[i])
+        {
+            results[i]->wallSeconds = outcomes[i].wallSeconds;
+            results[i]->peakRssKb = outcomes[i].peakRssKb;
+        }
+    }
+    return results;
+}
+
+#endif /* SWEEP_SCENARIO_H */
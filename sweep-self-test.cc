@@ -0,0 +1,681 @@
+#include "dcf-saturation-model.h"
+#include "event-log.h"
+#include "result-store.h"
+#include "sweep-shard-manifests.h"
+#include "sweep-shards.h"
+#include "sweep-validation.h"
+#include "time-series-store.h"
+
+#include "ns3/command-line.h"
+#include "ns3/core-module.h"
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+// The scenario logs through the component of the sweep program, see SweepLogComponent
+NS_LOG_COMPONENT_DEFINE("AdhocWifiPropagationComparison");
+
+static unsigned checks = 0;   //!< Checks run so far
+static unsigned failures = 0; //!< Checks that failed so far
+
+/**
+ * Count a check and report it if it failed.
+ *
+ * \param condition whether the check passed
+ * \param what what was checked
+ */
+static void
+Check(bool condition, const std::string& what)
+{
+    checks++;
+    if (!condition)
+    {
+        NS_LOG_UNCOND("FAILED: " << what);
+        failures++;
+    }
+}
+
+/**
+ * Whether a function aborts. It runs in a child process with its output discarded, as the
+ * sweep reports errors through NS_ABORT_MSG.
+ */
+static bool
+Aborts(const std::function<void()>& function)
+{
+    pid_t pid = fork();
+    NS_ABORT_MSG_IF(pid < 0, "Cannot fork: " << std::strerror(errno));
+    if (pid == 0)
+    {
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        function();
+        _exit(0);
+    }
+    int status;
+    NS_ABORT_MSG_IF(waitpid(pid, &status, 0) < 0, "Cannot wait: " << std::strerror(errno));
+    return !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+}
+
+/**
+ * Read the lines of a file, or none if it cannot be read.
+ */
+static std::vector<std::string>
+ReadLines(const std::string& path)
+{
+    std::vector<std::string> lines;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line))
+    {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+static void
+CheckListOptions()
+{
+    Check(ParseUnsignedList("hops", "1,,2,4294967295") ==
+              std::vector<uint32_t>({1, 2, 4294967295}),
+          "ParseUnsignedList skips empty items");
+    Check(ParseNonNegativeList("contentionDistances", "0,.5,12.5e1") ==
+              std::vector<double>({0, 0.5, 125}),
+          "ParseNonNegativeList parses decimals and exponents");
+    for (const char* item : {"-1", "+1", " 1", "1x", "x", "4294967296", "0x10"})
+    {
+        Check(Aborts([item]() { ParseUnsignedList("seeds", item); }),
+              std::string("ParseUnsignedList rejects ") + item);
+    }
+    for (const char* item : {"-1", "-0", "nan", "inf", "1e400", "1m", ".", "1,,a"})
+    {
+        Check(Aborts([item]() { ParseNonNegativeList("equivalenceDistances", item); }),
+              std::string("ParseNonNegativeList rejects ") + item);
+    }
+}
+
+static void
+CheckAssignShards()
+{
+    // Longest processing time first: 5, 4 and 3 open the shards, the next 3 joins the
+    // cheapest shard, the 2s then go to the shards of 4 and 5, and 1 to the first of the
+    // two shards that tie at 6
+    std::vector<uint32_t> assignment = AssignShards({5, 4, 3, 3, 2, 2, 1}, 3);
+    Check(assignment == std::vector<uint32_t>({0, 1, 2, 2, 1, 0, 1}),
+          "AssignShards balances by decreasing cost");
+
+    Check(AssignShards({1, 1, 1, 1, 1}, 2) == std::vector<uint32_t>({0, 1, 0, 1, 0}),
+          "AssignShards breaks ties by task and shard index");
+    Check(AssignShards({3, 1, 2}, 0) == std::vector<uint32_t>({0, 0, 0}),
+          "AssignShards puts everything in one shard if asked for none");
+    Check(AssignShards({}, 4).empty(), "AssignShards of no tasks");
+
+    std::vector<double> costs;
+    for (unsigned task = 0; task < 100; task++)
+    {
+        costs.push_back(1 + (task * 37) % 11);
+    }
+    const uint32_t shards = 7;
+    assignment = AssignShards(costs, shards);
+    std::vector<double> load(shards, 0);
+    bool valid = assignment.size() == costs.size();
+    for (size_t task = 0; valid && task < costs.size(); task++)
+    {
+        valid = assignment[task] < shards;
+        load[assignment[task] % shards] += costs[task];
+    }
+    Check(valid, "AssignShards returns a valid shard for every task");
+    // Every task went to the cheapest shard, so the shards differ by at most one task
+    double maxCost = *std::max_element(costs.begin(), costs.end());
+    Check(*std::max_element(load.begin(), load.end()) -
+                  *std::min_element(load.begin(), load.end()) <=
+              maxCost,
+          "AssignShards keeps the shards within one task of each other");
+}
+
+static void
+CheckMergeShards()
+{
+    char directory[] = "/tmp/sweep-self-test-XXXXXX";
+    NS_ABORT_MSG_IF(!mkdtemp(directory), "Cannot create a directory: " << std::strerror(errno));
+    char* previous = getcwd(nullptr, 0);
+    NS_ABORT_MSG_IF(chdir(directory) != 0, "Cannot enter " << directory);
+    const std::string prefix = "shard";
+
+    std::vector<SweepPoint> points;
+    for (unsigned distance = 1; distance <= 4; distance++)
+    {
+        points.push_back(ParseRequest("model=Friis distance=" + std::to_string(distance)));
+    }
+    auto result = [](double distance, bool connectionLost) {
+        PointResult result;
+        result.rss = -40 - distance;
+        result.throughput = 1000 / distance;
+        result.rxBytes = 1000;
+        result.rxPackets = 10;
+        result.flows = 1;
+        result.connectionLost = connectionLost;
+        result.events = 100;
+        return result;
+    };
+    PointResult contended = result(5, false);
+    contended.goodput = 812.25;
+    contended.rxErrors = 7;
+    contended.rxDrops = 3;
+    PointResult parsed = DeserializeResult(SerializeResult(contended));
+    Check(SameMeasurements(parsed, contended) && parsed.goodput == 812.25 &&
+              parsed.rxErrors == 7 && parsed.rxDrops == 3,
+          "DeserializeResult reads the goodput and PHY losses SerializeResult writes");
+    parsed.goodput = 0;
+    Check(!SameMeasurements(parsed, contended), "SameMeasurements compares the goodput");
+
+    auto line = [](const SweepPoint& point, const PointResult& result, double wallSeconds) {
+        return FormatRequest(point) + "\t" + SerializeResult(result) + " " +
+               std::to_string(wallSeconds) + " 1024\n";
+    };
+    // The connection is lost at 3 m, so the sweep never needs the point at 4 m
+    auto writeShards = [&](const std::string& config, bool complete) {
+        std::ofstream(shardFileName(prefix, 0, "manifest"))
+            << "# config " << config << "\n# shard 0 of 2\n"
+            << FormatRequest(points[0]) << "\n"
+            << FormatRequest(points[2]) << "\n";
+        std::ofstream(shardFileName(prefix, 1, "manifest"))
+            << "# config 0123456789abcdef\n# shard 1 of 2\n"
+            << FormatRequest(points[1]) << "\n"
+            << FormatRequest(points[3]) << "\n";
+        std::ofstream(shardFileName(prefix, 0, "results"))
+            << "# config 0123456789abcdef\n"
+            << line(points[2], result(3, true), 3)
+            << (complete ? line(points[0], result(1, false), 1) : "")
+            << line(points[1], result(2, false), 9)
+            << line(ParseRequest("model=Friis distance=9"), result(9, false), 1);
+        std::ofstream(shardFileName(prefix, 1, "results"))
+            << "# config 0123456789abcdef\n"
+            << FormatRequest(points[1]) << "\terror\n"
+            << line(points[1], result(2, false), 2);
+    };
+
+    writeShards("0123456789abcdef", true);
+    MergeShards(2, prefix);
+    std::vector<std::string> lines = ReadLines(outputFileName(points[0]));
+    Check(lines.size() == 4, "MergeShards writes a row per point up to the cutoff");
+    for (size_t row = 1; row < lines.size(); row++)
+    {
+        Check(lines[row].compare(0, 2, std::to_string(row) + ",") == 0,
+              "MergeShards writes the rows in order of distance");
+    }
+    if (lines.size() == 4)
+    {
+        PointResult first = result(2, false);
+        first.wallSeconds = 9;
+        first.peakRssKb = 1024;
+        std::ostringstream expected;
+        WriteOutputRow(expected, 2, first);
+        Check(lines[2] + "\n" == expected.str(),
+              "MergeShards keeps the first of duplicate results");
+    }
+
+    Check(Aborts([&]() {
+              writeShards("0123456789abcdef", false);
+              MergeShards(2, prefix);
+          }),
+          "MergeShards fails if a point is missing");
+    Check(Aborts([&]() {
+              writeShards("fedcba9876543210", true);
+              MergeShards(2, prefix);
+          }),
+          "MergeShards fails if the shards come from different configurations");
+
+    // Columns out of order, and rows with a bad distance, model, wall time or none
+    std::ofstream("costs.csv") << "wallSeconds,phy,distanceMeters,model,hops\n"
+                               << "4,Yans,1,Friis,1\n"
+                               << "5,Yans,x,Friis,1\n"
+                               << "5,Yans,2,Nowhere,1\n"
+                               << "abc,Yans,2,Friis,1\n"
+                               << "-1,Yans,2,Friis,1\n"
+                               << "5,Yans,2\n";
+    WriteShardManifests({FRIIS}, {Variant{YANS}}, {1}, 2, 1, "cost", "costs.csv", {});
+    lines = ReadLines(shardFileName("cost", 0, "manifest"));
+    Check(lines.size() == 5 && lines[2] == "# cost 8",
+          "WriteShardManifests reads the cost file by column name and skips bad rows");
+    Check(Aborts([]() {
+              std::ofstream("costs.csv") << "model,distanceMeters,phy\nFriis,1,Yans\n";
+              WriteShardManifests({FRIIS}, {Variant{YANS}}, {1}, 2, 1, "cost", "costs.csv", {});
+          }),
+          "WriteShardManifests fails without a wallSeconds column");
+    std::remove("costs.csv");
+    std::remove(shardFileName("cost", 0, "manifest").c_str());
+
+    for (uint32_t shard = 0; shard < 2; shard++)
+    {
+        std::remove(shardFileName(prefix, shard, "manifest").c_str());
+        std::remove(shardFileName(prefix, shard, "results").c_str());
+    }
+    std::remove(outputFileName(points[0]).c_str());
+    NS_ABORT_MSG_IF(chdir(previous) != 0, "Cannot return to " << previous);
+    std::free(previous);
+    rmdir(directory);
+}
+
+static void
+CheckEventLog()
+{
+    char path[] = "/tmp/sweep-self-test-XXXXXX";
+    int fd = mkstemp(path);
+    NS_ABORT_MSG_IF(fd < 0, "Cannot create a file: " << std::strerror(errno));
+    close(fd);
+
+    EventLogHeader written{"model=Friis distance=10", "0123456789abcdef", "TcpBulk", 12.5};
+    {
+        EventLogWriter writer(path, written);
+        writer.PhyRx(1000, -61.2345, -93.9, 7, 1500);
+        writer.MacTx(1000, true, EVENT_LOG_NO_MCS, 1536);
+        // Signal and noise are deltas to the previous frame, also when they grow
+        writer.PhyRx(250000, -40.5, -94.001, 3, 80);
+        writer.MacDrop(300000, DROP_QUEUE);
+        writer.AppRx(5000000000ULL, 1472);
+        Check(writer.Ok(), "EventLogWriter writes the log");
+    }
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)),
+                              std::istreambuf_iterator<char>());
+    std::remove(path);
+
+    EventLogHeader header;
+    std::vector<LoggedEvent> events;
+    auto collect = [&events](const LoggedEvent& event) { events.push_back(event); };
+    Check(DecodeEventLog(data.data(), data.size(), header, collect),
+          "DecodeEventLog reads what EventLogWriter wrote");
+    Check(header.request == written.request && header.config == written.config &&
+              header.transport == written.transport &&
+              header.simulationTime == written.simulationTime,
+          "DecodeEventLog reads the header");
+    Check(events.size() == 5, "DecodeEventLog reads every event");
+    if (events.size() == 5)
+    {
+        const LoggedEvent& rx = events[0];
+        Check(rx.type == PHY_RX_EVENT && rx.timeNs == 1000 && rx.signalDbm == -61.235 &&
+                  rx.noiseDbm == -93.9 && rx.mcs == 7 && rx.size == 1500,
+              "DecodeEventLog reads a received frame to 0.001 dB");
+        const LoggedEvent& tx = events[1];
+        Check(tx.type == MAC_TX_EVENT && tx.timeNs == 1000 && tx.retry &&
+                  tx.mcs == EVENT_LOG_NO_MCS && tx.size == 1536,
+              "DecodeEventLog reads a sent MPDU");
+        Check(events[2].signalDbm == -40.5 && events[2].noiseDbm == -94.001 &&
+                  events[2].mcs == 3 && events[2].size == 80,
+              "DecodeEventLog accumulates the signal and noise deltas");
+        Check(events[3].type == MAC_DROP_EVENT && events[3].timeNs == 300000 &&
+                  events[3].dropReason == DROP_QUEUE,
+              "DecodeEventLog reads a dropped MPDU");
+        Check(events[4].type == APP_RX_EVENT && events[4].timeNs == 5000000000ULL &&
+                  events[4].size == 1472,
+              "DecodeEventLog reads a received packet");
+    }
+
+    events.clear();
+    Check(!DecodeEventLog(data.data(), data.size() - 1, header, collect) && events.size() == 4,
+          "DecodeEventLog decodes a truncated log up to its last complete event");
+    std::vector<uint8_t> corrupt = data;
+    corrupt[4] = EventLogWriter::VERSION + 1;
+    Check(!DecodeEventLog(corrupt.data(), corrupt.size(), header, collect),
+          "DecodeEventLog rejects a newer version");
+    corrupt = data;
+    corrupt.push_back(APP_RX_EVENT + 1);
+    corrupt.push_back(0);
+    Check(!DecodeEventLog(corrupt.data(), corrupt.size(), header, collect),
+          "DecodeEventLog rejects an unknown event type");
+}
+
+static void
+CheckDcfSaturation()
+{
+    DcfParameters parameters;
+    Check(std::fabs(DcfTransmitProbability(0, parameters) - 2.0 / (parameters.cwMin + 2)) <
+              1e-15,
+          "DcfTransmitProbability without failures is one per mean backoff");
+
+    // A lone station never collides, so only the backoff separates its transmissions
+    DcfStation station{0, 200e-6, 12000};
+    DcfSolution solution = SolveDcfSaturation({station}, parameters);
+    double tau = 2.0 / (parameters.cwMin + 2);
+    Check(solution.converged && solution.failureProbability[0] < 1e-15 &&
+              solution.collisionProbability < 1e-15 &&
+              std::fabs(solution.transmitProbability[0] - tau) < 1e-12,
+          "SolveDcfSaturation of a lone station");
+    Check(std::fabs(solution.totalThroughput -
+                    tau * station.deliveredBits /
+                        ((1 - tau) * parameters.slotSeconds + tau * station.busySeconds)) <
+              1e-6,
+          "SolveDcfSaturation throughput of a lone station");
+
+    // With attempts that practically never run out, the model is Bianchi's, whose tau has
+    // a closed form in p for a window W doubling m times
+    parameters.cwMin = 31;
+    parameters.cwMax = 1023;
+    parameters.attempts = 1000;
+    const double window = parameters.cwMin + 1;
+    const int doublings = 5;
+    const size_t count = 10;
+    solution = SolveDcfSaturation(std::vector<DcfStation>(count, station), parameters);
+    double p = solution.failureProbability[0];
+    tau = solution.transmitProbability[0];
+    double bianchi = 2 * (1 - 2 * p) /
+                     ((1 - 2 * p) * (window + 1) + p * window * (1 - std::pow(2 * p, doublings)));
+    Check(solution.converged, "SolveDcfSaturation converges for identical stations");
+    Check(std::fabs(tau - bianchi) < 1e-9, "SolveDcfSaturation matches Bianchi's closed form");
+    Check(std::fabs(p - (1 - std::pow(1 - tau, count - 1))) < 1e-9,
+          "SolveDcfSaturation solves the collision probability of identical stations");
+    bool same = true;
+    for (size_t i = 1; i < count; i++)
+    {
+        same = same && solution.throughput[i] == solution.throughput[0];
+    }
+    Check(same, "SolveDcfSaturation shares the channel fairly among identical stations");
+    double success = count * tau * std::pow(1 - tau, count - 1);
+    Check(std::fabs(solution.idleProbability + success + solution.collisionProbability - 1) <
+              1e-12,
+          "SolveDcfSaturation slots are idle, a success or a collision");
+
+    // A station with a lossy link backs off more, which leaves more of the channel to the
+    // other
+    parameters = DcfParameters();
+    DcfStation lossy{0.5, 200e-6, 12000};
+    solution = SolveDcfSaturation({station, lossy}, parameters);
+    Check(solution.converged, "SolveDcfSaturation converges for different stations");
+    Check(solution.transmitProbability[1] < solution.transmitProbability[0] &&
+              solution.failureProbability[1] > solution.failureProbability[0] &&
+              solution.throughput[1] < solution.throughput[0],
+          "SolveDcfSaturation penalizes the lossy station");
+    Check(std::fabs(solution.dropProbability[1] -
+                    std::pow(solution.failureProbability[1], parameters.attempts)) < 1e-15,
+          "SolveDcfSaturation drops a frame once its attempts fail");
+}
+
+/**
+ * Whether a series survives TimeSeriesEncoder and DecodeTimeSeries bit for bit.
+ */
+static bool
+RoundTripsTimeSeries(const std::vector<std::pair<int64_t, double>>& samples)
+{
+    TimeSeriesEncoder encoder;
+    for (const auto& [timeNs, value] : samples)
+    {
+        encoder.Append(timeNs, value);
+    }
+    std::vector<std::pair<int64_t, double>> decoded;
+    bool complete = DecodeTimeSeries(encoder.GetWords().data(),
+                                     encoder.GetWords().size(),
+                                     encoder.GetCount(),
+                                     [&decoded](int64_t timeNs, double value) {
+                                         decoded.emplace_back(timeNs, value);
+                                     });
+    if (!complete || decoded.size() != samples.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        if (decoded[i].first != samples[i].first ||
+            std::memcmp(&decoded[i].second, &samples[i].second, sizeof(double)) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void
+CheckTimeSeries()
+{
+    // A regular, constant series costs two bits per sample once the interval is known
+    std::vector<std::pair<int64_t, double>> samples;
+    for (int64_t i = 0; i < 1000; i++)
+    {
+        samples.emplace_back(5000000000LL + i * 100000000, -62.5);
+    }
+    Check(RoundTripsTimeSeries(samples), "DecodeTimeSeries of a regular constant series");
+    TimeSeriesEncoder encoder;
+    for (const auto& [timeNs, value] : samples)
+    {
+        encoder.Append(timeNs, value);
+    }
+    // The first sample takes 128 bits, the second one a full delta and an unchanged value
+    const size_t bits = 128 + 4 + 64 + 1 + 2 * 998;
+    Check(encoder.GetWords().size() == (bits + 63) / 64 && encoder.GetCount() == 1000 &&
+              encoder.GetFirstTime() == samples.front().first &&
+              encoder.GetLastTime() == samples.back().first,
+          "TimeSeriesEncoder packs a regular constant series");
+
+    // Jitter of every size the delta of deltas has a code for, and values that change in
+    // few, many or all bits, so that both kinds of XOR windows are used
+    std::mt19937_64 random(1);
+    for (int64_t jitter : std::vector<int64_t>{1, 60, 250, 2000, 100000, int64_t(1) << 40})
+    {
+        samples.clear();
+        int64_t time = 0;
+        double value = 1;
+        for (int i = 0; i < 500; i++)
+        {
+            time += 1000000 + int64_t(random() % (2 * jitter + 1)) - jitter;
+            value = i % 7 == 0 ? std::ldexp(double(random()), -40) : value + 0.25;
+            samples.emplace_back(time, value);
+        }
+        Check(RoundTripsTimeSeries(samples),
+              "DecodeTimeSeries with a jitter of " + std::to_string(jitter) + " ns");
+    }
+
+    samples = {{0, 0.0},
+               {-10, -0.0},
+               {-5, std::numeric_limits<double>::infinity()},
+               {INT64_MAX / 4, std::numeric_limits<double>::quiet_NaN()},
+               {INT64_MIN / 4, std::numeric_limits<double>::denorm_min()},
+               {7, -std::numeric_limits<double>::max()}};
+    Check(RoundTripsTimeSeries(samples),
+          "DecodeTimeSeries of times out of order and special values");
+    Check(RoundTripsTimeSeries({{42, 3.5}}), "DecodeTimeSeries of a single sample");
+    Check(DecodeTimeSeries(nullptr, 0, 0, [](int64_t, double) {}),
+          "DecodeTimeSeries of an empty chunk");
+
+    encoder = TimeSeriesEncoder();
+    for (int i = 0; i < 1000; i++)
+    {
+        encoder.Append(i * int64_t(1000) + int64_t(random() % 1000), double(random()));
+    }
+    uint32_t decoded = 0;
+    Check(!DecodeTimeSeries(encoder.GetWords().data(),
+                            encoder.GetWords().size() - 1,
+                            encoder.GetCount(),
+                            [&decoded](int64_t, double) { decoded++; }) &&
+              decoded < encoder.GetCount(),
+          "DecodeTimeSeries reports a truncated chunk");
+}
+
+#ifdef HAVE_SQLITE3
+/**
+ * Run a query on a database and return the first column of its first row as text, "NULL"
+ * if it is null.
+ */
+static std::string
+QueryValue(const std::string& path, const std::string& sql)
+{
+    sqlite3* db = nullptr;
+    sqlite3_stmt* statement = nullptr;
+    std::string value = "no row";
+    if (sqlite3_open(path.c_str(), &db) == SQLITE_OK &&
+        sqlite3_prepare_v2(db, sql.c_str(), -1, &statement, nullptr) == SQLITE_OK &&
+        sqlite3_step(statement) == SQLITE_ROW)
+    {
+        const unsigned char* text = sqlite3_column_text(statement, 0);
+        value = text ? reinterpret_cast<const char*>(text) : "NULL";
+    }
+    sqlite3_finalize(statement);
+    sqlite3_close(db);
+    return value;
+}
+#endif
+
+static void
+CheckResultStore()
+{
+    char path[] = "/tmp/sweep-self-test-XXXXXX";
+    int fd = mkstemp(path);
+    NS_ABORT_MSG_IF(fd < 0, "Cannot create a file: " << std::strerror(errno));
+    close(fd);
+    const std::string database = path;
+
+#ifdef HAVE_SQLITE3
+    StoredPoint point;
+    point.model = "Friis";
+    point.phy = "Yans";
+    point.distance = 12.5;
+    point.seed = 3;
+    point.maxAmpduSize = 65535;
+    point.hops = 2;
+    point.transport = "TcpBulk";
+    point.congestionControl = "TcpCubic";
+    point.segmentSize = 1448;
+    point.configHash = "0123456789abcdef";
+    point.rss = -61.5;
+    point.throughput = 900.25;
+    point.goodput = 812.25;
+    point.rxBytes = 123456;
+    point.connectionLost = false;
+    point.mac = StoredMac{1, 2, 3, 4, 5, 6, {0, 0, 0, 0, 0, 0, 0, 77}};
+    point.timing = StoredTiming{1000, 0.5, 0.75, 2048};
+    point.flows = {{1, 10, 9, 2, 1, 1, 0.5, 0.25}, {2, 20, 20, 4, 4, 0, 1, 0}};
+    StoredPoint imported;
+    imported.model = "Nakagami";
+    imported.phy = "Spectrum";
+    imported.distance = 40;
+    imported.seed = 1;
+    imported.rss = -80;
+    imported.throughput = 0;
+    {
+        ResultStore store(database);
+        Check(store.BeginRun("sweep-self-test", "--resultStore", "0123456789abcdef", "test") &&
+                  store.Begin() && store.InsertPoint(point) && store.InsertPoint(imported) &&
+                  store.Commit(),
+              "ResultStore stores a run: " + store.Error());
+    }
+    auto query = [&database](const std::string& sql) { return QueryValue(database, sql); };
+    Check(query("SELECT count(*) FROM points") == "2" &&
+              query("SELECT count(*) FROM runs WHERE configHash = '0123456789abcdef'") == "1" &&
+              query("SELECT description FROM configs") == "test",
+          "ResultStore stores the run, its configuration and its points");
+    Check(query("SELECT distance || ' ' || seed || ' ' || hops || ' ' || transport || ' ' || "
+                "congestionControl || ' ' || segmentSize || ' ' || goodput || ' ' || mcs7 "
+                "FROM points WHERE model = 'Friis'") == "12.5 3 2 TcpBulk TcpCubic 1448 812.25 77",
+          "ResultStore stores the fields of a point");
+    Check(query("SELECT count(*) FROM flows JOIN points ON flows.point = points.id "
+                "WHERE model = 'Friis'") == "2" &&
+              query("SELECT wallSeconds FROM timing") == "0.75",
+          "ResultStore stores the flows and timing of a point");
+    Check(query("SELECT coalesce(rxBytes, maxAmpduSize, goodput, retransmissions, 'NULL') "
+                "FROM points WHERE model = 'Nakagami'") == "NULL" &&
+              query("SELECT count(*) FROM timing JOIN points ON timing.point = points.id "
+                    "WHERE model = 'Nakagami'") == "0",
+          "ResultStore stores what a point lacks as NULL");
+    Check(query("PRAGMA user_version") == std::to_string(ResultStore::SCHEMA_VERSION),
+          "ResultStore records its schema version");
+    {
+        ResultStore store(database);
+        Check(store.Ok() && query("SELECT count(*) FROM points") == "2",
+              "ResultStore reopens a database");
+    }
+
+    query("PRAGMA user_version = 2");
+    Check(!ResultStore(database).Ok() && query("PRAGMA user_version") == "2",
+          "ResultStore refuses a database of another schema version");
+#else
+    ResultStore store(database);
+    Check(!store.Ok() && !store.BeginRun("sweep-self-test", "", "", "") &&
+              !store.InsertPoint(StoredPoint()),
+          "ResultStore fails without SQLite");
+#endif
+
+    for (const char* suffix : {"", "-wal", "-shm"})
+    {
+        std::remove((database + suffix).c_str());
+    }
+}
+
+static void
+CheckEquivalence()
+{
+    Check(KolmogorovSmirnovTest({1, 2, 3}, {3, 2, 1}).statistic == 0 &&
+              KolmogorovSmirnovTest({1, 2, 3}, {3, 2, 1}).pValue == 1,
+          "KolmogorovSmirnovTest of equal samples");
+    Check(KolmogorovSmirnovTest({1, 2, 3, 4}, {5, 6, 7, 8}).statistic == 1,
+          "KolmogorovSmirnovTest of disjoint samples");
+    Check(WelchTest({2, 2}, {2, 2}).pValue == 1 && WelchTest({2, 2}, {3, 3}).pValue == 0,
+          "WelchTest of samples that do not vary");
+    TwoSampleTest welch = WelchTest({1, 2, 3, 4}, {2, 3, 4, 5});
+    Check(welch.statistic == 1 && welch.pValue > 0.3 && welch.pValue < 0.4,
+          "WelchTest of shifted samples");
+
+    char directory[] = "/tmp/sweep-self-test-XXXXXX";
+    NS_ABORT_MSG_IF(!mkdtemp(directory), "Cannot create a directory: " << std::strerror(errno));
+    char* previous = getcwd(nullptr, 0);
+    NS_ABORT_MSG_IF(chdir(directory) != 0, "Cannot enter " << directory);
+
+    // A few short points of a deterministic and a fading model, so that both the exact
+    // and the statistical tests run
+    ResultRing ring(512, 16384);
+    ScenarioConfig config;
+    config.simulationTime = 5;
+    bool passed = RunEquivalenceTests(ring,
+                                      config,
+                                      "fastMath",
+                                      {FRIIS, NAKAGAMI},
+                                      {10, 50},
+                                      3,
+                                      2,
+                                      0.01,
+                                      1e-6);
+    Check(passed, "RunEquivalenceTests finds fast math equivalent to the exact loss models");
+    std::vector<std::string> lines = ReadLines("output_equivalence.csv");
+    Check(lines.size() >= 1 + 2 * 2 * 4, "RunEquivalenceTests writes every test");
+
+    std::remove("output_equivalence.csv");
+    std::remove("output_equivalence_summary.csv");
+    NS_ABORT_MSG_IF(chdir(previous) != 0, "Cannot return to " << previous);
+    std::free(previous);
+    rmdir(directory);
+}
+
+int
+main(int argc, char* argv[])
+{
+    CommandLine cmd(__FILE__);
+    cmd.Parse(argc, argv);
+
+    CheckListOptions();
+    CheckAssignShards();
+    CheckMergeShards();
+    CheckEventLog();
+    CheckDcfSaturation();
+    CheckTimeSeries();
+    CheckResultStore();
+    CheckEquivalence();
+
+    NS_LOG_UNCOND(checks - failures << " of " << checks << " checks passed");
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
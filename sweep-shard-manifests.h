@@ -0,0 +1,371 @@
+#ifndef SWEEP_SHARD_MANIFESTS_H
+#define SWEEP_SHARD_MANIFESTS_H
+
+#include "sweep-point.h"
+#include "sweep-shards.h"
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Rough cost of a point relative to the Yans PHY, used to balance shards when no measured
+ * wall times are given.
+ */
+inline double
+PhyCost(PhyType phy)
+{
+    switch (phy)
+    {
+    case YANS:
+        return 1;
+    case SPECTRUM:
+        return 2;
+    case ABSTRACT:
+        return 0.5;
+    }
+    NS_ABORT_MSG("Unhandled PHY type");
+}
+
+inline std::string
+shardFileName(const std::string& prefix, uint32_t shard, const std::string& extension)
+{
+    return prefix + "_" + std::to_string(shard) + "." + extension;
+}
+
+/**
+ * Split the sweep into shard manifests that hosts can run independently.
+ *
+ * Every (model, variant, seed) gets all distances from 1 m to maxDistance, as the cutoff
+ * of a distance sweep is only known once it has been simulated. The predicted cost of a
+ * point is its wall time in costFile, an output_phy_comparison.csv of an earlier sweep
+ * with the same scenario; without one it is the relative cost of the PHY type. Points the
+ * file lacks, past the cutoff of the earlier sweep or new, get the relative cost of their
+ * PHY type scaled to the measured wall times, as whether they are skipped is only known
+ * once the shard runs. The columns of costFile are found by their names in its header,
+ * and rows without a valid point or wall time are skipped. A manifest lists the
+ * configuration hash, its shard index and predicted cost, and one request per point.
+ */
+inline void
+WriteShardManifests(const std::vector<PropagationModel>& models,
+                    const std::vector<Variant>& variants,
+                    const std::vector<uint32_t>& seeds,
+                    double maxDistance,
+                    uint32_t shards,
+                    const std::string& prefix,
+                    const std::string& costFile,
+                    const ScenarioConfig& config)
+{
+    std::map<std::string, double> measuredCosts;
+    // Measured wall time per unit of relative PHY cost, for the points without one
+    double measuredSum = 0;
+    double phyCostSum = 0;
+    if (!costFile.empty())
+    {
+        std::ifstream file(costFile);
+        NS_ABORT_MSG_IF(!file, "Cannot read " << costFile);
+        auto splitFields = [](const std::string& line) {
+            std::vector<std::string> fields;
+            std::istringstream stream(line);
+            std::string field;
+            while (std::getline(stream, field, ','))
+            {
+                fields.push_back(field);
+            }
+            return fields;
+        };
+        std::string line;
+        std::getline(file, line);
+        std::vector<std::string> header = splitFields(line);
+        auto column = [&header](const std::string& name) -> size_t {
+            return std::find(header.begin(), header.end(), name) - header.begin();
+        };
+        for (const char* name : {"model", "distanceMeters", "phy", "wallSeconds"})
+        {
+            NS_ABORT_MSG_IF(column(name) == header.size(),
+                            costFile << " has no " << name << " column");
+        }
+        const size_t wallSecondsColumn = column("wallSeconds");
+        // The columns that identify a point, by request key. Files of earlier sweeps lack
+        // the later ones, which then take their default value.
+        std::vector<std::pair<std::string, size_t>> keyColumns;
+        for (const char* name : {"model",
+                                 "distanceMeters",
+                                 "phy",
+                                 "maxAmpduSize",
+                                 "maxAmsduSize",
+                                 "blockAckThreshold",
+                                 "blockAckInactivityTimeout",
+                                 "hops",
+                                 "transport",
+                                 "congestionControl",
+                                 "segmentSize"})
+        {
+            std::string key = name == std::string("distanceMeters") ? "distance" : name;
+            keyColumns.emplace_back(key, column(name));
+        }
+
+        size_t skipped = 0;
+        while (std::getline(file, line))
+        {
+            if (line.empty())
+            {
+                continue;
+            }
+            std::vector<std::string> fields = splitFields(line);
+            std::string request;
+            bool identified = true;
+            for (size_t i = 0; i < keyColumns.size(); i++)
+            {
+                const auto& [key, index] = keyColumns[i];
+                if (index < fields.size() && !fields[index].empty())
+                {
+                    request += key + "=" + fields[index] + " ";
+                }
+                else
+                {
+                    // The model, distance and PHY type have no default
+                    identified = identified && i >= 3;
+                }
+            }
+            SweepPoint point;
+            std::string error;
+            double wallSeconds = -1;
+            if (wallSecondsColumn < fields.size())
+            {
+                try
+                {
+                    size_t end = 0;
+                    wallSeconds = std::stod(fields[wallSecondsColumn], &end);
+                    wallSeconds = end == fields[wallSecondsColumn].size() ? wallSeconds : -1;
+                }
+                catch (const std::logic_error&)
+                {
+                    // Left negative, so the row is skipped
+                }
+            }
+            if (!identified || !std::isfinite(wallSeconds) || wallSeconds < 0 ||
+                !TryParseRequest(request, point, error))
+            {
+                skipped++;
+                continue;
+            }
+            measuredCosts[FormatRequest(point)] = wallSeconds;
+            measuredSum += wallSeconds;
+            phyCostSum += PhyCost(point.phy);
+        }
+        if (skipped > 0)
+        {
+            NS_LOG_UNCOND("Skipped " << skipped << " rows of " << costFile
+                                     << " without a valid point and wall time");
+        }
+    }
+    const double costScale = phyCostSum > 0 ? measuredSum / phyCostSum : 1;
+
+    std::vector<SweepPoint> points;
+    std::vector<double> costs;
+    for (PropagationModel model : models)
+    {
+        for (const Variant& variant : variants)
+        {
+            for (uint32_t seed : seeds)
+            {
+                for (double distance = 1; distance <= maxDistance; distance++)
+                {
+                    SweepPoint point{model,
+                                     variant.phy,
+                                     variant.aggregation,
+                                     distance,
+                                     1,
+                                     variant.hops,
+                                     1,
+                                     variant.transport};
+                    auto measured = measuredCosts.find(FormatRequest(point));
+                    costs.push_back(measured != measuredCosts.end()
+                                        ? measured->second
+                                        : costScale * PhyCost(variant.phy));
+                    point.seed = seed;
+                    points.push_back(point);
+                }
+            }
+        }
+    }
+
+    std::vector<uint32_t> assignment = AssignShards(costs, shards);
+    for (uint32_t shard = 0; shard < shards; shard++)
+    {
+        double shardCost = 0;
+        size_t shardPoints = 0;
+        std::ostringstream requests;
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            if (assignment[i] == shard)
+            {
+                requests << FormatRequest(points[i]) << "\n";
+                shardCost += costs[i];
+                shardPoints++;
+            }
+        }
+
+        std::ofstream manifest(shardFileName(prefix, shard, "manifest"));
+        manifest << "# config " << ConfigHash(config) << "\n"
+                 << "# shard " << shard << " of " << shards << "\n"
+                 << "# cost " << shardCost << "\n"
+                 << requests.str();
+        NS_LOG_UNCOND("Shard " << shard << ": " << shardPoints
+                               << " points, predicted cost " << shardCost);
+    }
+}
+
+/**
+ * Merge the results of all shards into the per-model output files of the sweep.
+ *
+ * A point reported by more than one shard is a duplicate; the first result is kept, and
+ * the merge fails if the results differ in anything but timing. Results of points no
+ * manifest lists are ignored. A point is missing if its series has no result for it and
+ * it is not past the cutoff of the series. Missing points are listed and fail the merge
+ * before any output file is written, so that the shards can be rerun.
+ */
+inline void
+MergeShards(uint32_t shards, const std::string& prefix)
+{
+    std::string configHash;
+    auto checkConfig = [&configHash](const std::vector<std::string>& header,
+                                     const std::string& fileName) {
+        std::string hash = ShardHeaderValue(header, "config");
+        if (configHash.empty())
+        {
+            configHash = hash;
+        }
+        NS_ABORT_MSG_IF(hash != configHash,
+                        fileName << " comes from a different scenario configuration");
+    };
+
+    // Expected points by output file, in order of distance
+    std::map<std::string, std::vector<SweepPoint>> series;
+    std::set<std::string> expected;
+    for (uint32_t shard = 0; shard < shards; shard++)
+    {
+        std::string manifestName = shardFileName(prefix, shard, "manifest");
+        std::vector<std::string> header;
+        std::vector<std::string> requests;
+        NS_ABORT_MSG_IF(!ReadShardFile(manifestName, header, requests),
+                        "Cannot read shard manifest " << manifestName);
+        checkConfig(header, manifestName);
+        for (const std::string& request : requests)
+        {
+            SweepPoint point = ParseRequest(request);
+            series[outputFileName(point)].push_back(point);
+            expected.insert(FormatRequest(point));
+        }
+    }
+
+    std::map<std::string, PointResult> results;
+    size_t duplicates = 0;
+    size_t unexpected = 0;
+    for (uint32_t shard = 0; shard < shards; shard++)
+    {
+        std::string resultsName = shardFileName(prefix, shard, "results");
+        std::vector<std::string> header;
+        std::vector<std::string> responses;
+        if (!ReadShardFile(resultsName, header, responses))
+        {
+            NS_LOG_UNCOND("No results for shard " << shard);
+            continue;
+        }
+        checkConfig(header, resultsName);
+
+        for (const std::string& response : responses)
+        {
+            size_t tab = response.find('\t');
+            NS_ABORT_MSG_IF(tab == std::string::npos,
+                            "Malformed line in " << resultsName << ": " << response);
+            std::string request = FormatRequest(ParseRequest(response.substr(0, tab)));
+            std::string output = response.substr(tab + 1);
+            if (output == "error")
+            {
+                continue;
+            }
+            if (expected.count(request) == 0)
+            {
+                NS_LOG_UNCOND("Ignoring result of a point no manifest lists: " << request);
+                unexpected++;
+                continue;
+            }
+
+            std::istringstream stream(output);
+            PointResult result = DeserializeResult(stream);
+            stream >> result.wallSeconds >> result.peakRssKb;
+
+            auto existing = results.find(request);
+            if (existing != results.end())
+            {
+                NS_LOG_UNCOND("Duplicate result in " << resultsName << ": " << request);
+                NS_ABORT_MSG_IF(!SameMeasurements(existing->second, result),
+                                "Duplicate results differ for " << request);
+                duplicates++;
+                continue;
+            }
+            results[request] = result;
+        }
+    }
+
+    std::vector<std::string> missing;
+    std::map<std::string, std::string> outputFiles;
+    for (auto& [fileName, points] : series)
+    {
+        std::stable_sort(points.begin(),
+                         points.end(),
+                         [](const SweepPoint& a, const SweepPoint& b) {
+                             return a.distance < b.distance;
+                         });
+
+        std::ostringstream outputFile;
+        WriteOutputHeader(outputFile, points.front().model);
+        for (const SweepPoint& point : points)
+        {
+            auto found = results.find(FormatRequest(point));
+            if (found == results.end())
+            {
+                missing.push_back(FormatRequest(point));
+                continue;
+            }
+            if (found->second.flows > 0)
+            {
+                WriteOutputRow(outputFile, point.distance, found->second);
+            }
+            if (EndsSweep(point, found->second))
+            {
+                break;
+            }
+        }
+        outputFiles[fileName] = outputFile.str();
+    }
+
+    NS_LOG_UNCOND("Merged " << results.size() << " points of " << shards << " shards: "
+                            << duplicates << " duplicates, " << unexpected << " unexpected, "
+                            << missing.size() << " missing");
+    for (const std::string& request : missing)
+    {
+        std::cerr << "Missing: " << request << std::endl;
+    }
+    NS_ABORT_MSG_IF(!missing.empty(), "Points are missing, rerun the shards that lack them");
+
+    for (const auto& [fileName, contents] : outputFiles)
+    {
+        std::ofstream outputFile(fileName);
+        outputFile << contents;
+    }
+}
+
+#endif /* SWEEP_SHARD_MANIFESTS_H */
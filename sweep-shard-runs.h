@@ -0,0 +1,102 @@
+#ifndef SWEEP_SHARD_RUNS_H
+#define SWEEP_SHARD_RUNS_H
+
+#include "sweep-scenario.h"
+#include "sweep-shard-manifests.h"
+#include "sweep-shards.h"
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * Run the points of a shard manifest and write their results, in the response format of
+ * the server mode, to the matching .results file.
+ *
+ * Points are run in batches of one per job in order of distance. Once a point ends the
+ * distance sweep of its series, the points of that series further away are skipped, as
+ * the merge step does not need them.
+ */
+inline void
+RunShard(ResultRing& ring,
+         uint32_t shard,
+         const std::string& prefix,
+         const ScenarioConfig& config,
+         unsigned jobs)
+{
+    std::string manifestName = shardFileName(prefix, shard, "manifest");
+    std::vector<std::string> header;
+    std::vector<std::string> requests;
+    NS_ABORT_MSG_IF(!ReadShardFile(manifestName, header, requests),
+                    "Cannot read shard manifest " << manifestName);
+    NS_ABORT_MSG_IF(ShardHeaderValue(header, "config") != ConfigHash(config),
+                    manifestName << " was written for a different scenario configuration");
+
+    std::vector<SweepPoint> points;
+    for (const std::string& request : requests)
+    {
+        points.push_back(ParseRequest(request));
+    }
+    std::stable_sort(points.begin(), points.end(), [](const SweepPoint& a, const SweepPoint& b) {
+        return a.distance < b.distance;
+    });
+
+    std::ofstream resultsFile(shardFileName(prefix, shard, "results"));
+    resultsFile << "# config " << ConfigHash(config) << "\n";
+
+    // Distance of the last point of every series, by output file
+    std::map<std::string, double> cutoffs;
+    size_t next = 0;
+    size_t skipped = 0;
+    while (next < points.size())
+    {
+        std::vector<SweepPoint> batch;
+        while (next < points.size() && batch.size() < jobs)
+        {
+            const SweepPoint& point = points[next++];
+            auto cutoff = cutoffs.find(outputFileName(point));
+            if (cutoff != cutoffs.end() && point.distance > cutoff->second)
+            {
+                skipped++;
+                continue;
+            }
+            batch.push_back(point);
+        }
+
+        std::vector<std::optional<PointResult>> results = RunPoints(ring, batch, config, jobs);
+
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            const std::optional<PointResult>& result = results[i];
+            resultsFile << FormatRequest(batch[i]) << "\t";
+            if (!result)
+            {
+                resultsFile << "error\n";
+                continue;
+            }
+            resultsFile << SerializeResult(*result) << " " << result->wallSeconds << " "
+                        << result->peakRssKb << "\n";
+
+            if (EndsSweep(batch[i], *result))
+            {
+                std::string series = outputFileName(batch[i]);
+                auto cutoff = cutoffs.find(series);
+                if (cutoff == cutoffs.end() || batch[i].distance < cutoff->second)
+                {
+                    cutoffs[series] = batch[i].distance;
+                }
+            }
+        }
+        resultsFile.flush();
+    }
+
+    NS_LOG_UNCOND("Shard " << shard << ": ran " << points.size() - skipped << " points, skipped "
+                           << skipped << " past the cutoff");
+}
+
+#endif /* SWEEP_SHARD_RUNS_H */
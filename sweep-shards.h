@@ -0,0 +1,118 @@
+#ifndef SWEEP_SHARDS_H
+#define SWEEP_SHARDS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+/**
+ * Assign tasks to shards so that the predicted cost of the shards is balanced.
+ *
+ * Tasks are taken in order of decreasing cost and each one goes to the shard with the
+ * lowest cost so far (longest processing time first). Ties are broken by task and shard
+ * index, so the assignment only depends on the costs and every host computes the same.
+ *
+ * \param costs the predicted cost of every task
+ * \param shards the number of shards
+ * \return the shard of every task
+ */
+inline std::vector<uint32_t>
+AssignShards(const std::vector<double>& costs, uint32_t shards)
+{
+    std::vector<size_t> order(costs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&costs](size_t a, size_t b) {
+        return costs[a] > costs[b];
+    });
+
+    std::vector<double> load(std::max(shards, 1U), 0);
+    std::vector<uint32_t> assignment(costs.size());
+    for (size_t task : order)
+    {
+        uint32_t shard = std::min_element(load.begin(), load.end()) - load.begin();
+        assignment[task] = shard;
+        load[shard] += costs[task];
+    }
+    return assignment;
+}
+
+/**
+ * 64 bit FNV-1a hash of a string as 16 hex digits. Unlike std::hash, it is the same on
+ * every host, so it can identify a configuration across machines.
+ */
+inline std::string
+Fnv1aHash(const std::string& text)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : text)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    return hex;
+}
+
+/**
+ * Read the lines of a shard file, separating the "# key value" header lines from the
+ * others. Empty lines are skipped.
+ *
+ * \param path the file
+ * \param header receives the header lines without the leading "# "
+ * \param lines receives the remaining lines
+ * \return whether the file could be opened
+ */
+inline bool
+ReadShardFile(const std::string& path,
+              std::vector<std::string>& header,
+              std::vector<std::string>& lines)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty())
+        {
+            continue;
+        }
+        if (line[0] == '#')
+        {
+            size_t start = line.find_first_not_of("# ");
+            header.push_back(start == std::string::npos ? "" : line.substr(start));
+        }
+        else
+        {
+            lines.push_back(line);
+        }
+    }
+    return true;
+}
+
+/**
+ * Look up the value of a "key value" header line.
+ *
+ * \return the value, or an empty string if the key is missing
+ */
+inline std::string
+ShardHeaderValue(const std::vector<std::string>& header, const std::string& key)
+{
+    for (const std::string& line : header)
+    {
+        if (line.compare(0, key.size() + 1, key + " ") == 0)
+        {
+            return line.substr(key.size() + 1);
+        }
+    }
+    return "";
+}
+
+#endif /* SWEEP_SHARDS_H */
@@ -0,0 +1,257 @@
+#ifndef SWEEP_VALIDATION_H
+#define SWEEP_VALIDATION_H
+
+#include "equivalence-tests.h"
+#include "sweep-scenario.h"
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Simulate the Friis, TwoRayGround and ThreeLogDistance curves of the Yans PHY with the
+ * reference and the fast loss models, on distances 1.5 times apart up to maxDistance,
+ * and write both to output_fastmath_validation.csv. Fails if the RSS of a point differs
+ * by more than FAST_MATH_MAX_ERROR_DB, or if only one of them received anything.
+ */
+inline void
+RunFastMathValidation(ResultRing& ring, ScenarioConfig config, unsigned jobs, double maxDistance)
+{
+    std::vector<SweepPoint> points;
+    for (PropagationModel model : {FRIIS, TWO_RAY_GROUND, THREE_LOG_DISTANCE})
+    {
+        for (double distance = 1; distance <= maxDistance; distance *= 1.5)
+        {
+            points.push_back({model, YANS, AggregationConfig(), distance});
+        }
+    }
+
+    config.fastMath = false;
+    std::vector<std::optional<PointResult>> reference = RunPoints(ring, points, config, jobs);
+    config.fastMath = true;
+    std::vector<std::optional<PointResult>> fast = RunPoints(ring, points, config, jobs);
+
+    std::ofstream validationFile("output_fastmath_validation.csv");
+    validationFile << std::setprecision(12)
+                   << "model,distanceMeters,referenceRssDBm,fastRssDBm,rssErrorDB,"
+                      "referenceThroughputKbps,fastThroughputKbps,withinBudget\n";
+    size_t failures = 0;
+    double maxErrorDb = 0;
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        NS_ABORT_MSG_IF(!reference[i] || !fast[i],
+                        "Simulation failed: " << FormatRequest(points[i]));
+        double errorDb = std::fabs(fast[i]->rss - reference[i]->rss);
+        bool withinBudget = (fast[i]->flows > 0) == (reference[i]->flows > 0) &&
+                            errorDb <= FAST_MATH_MAX_ERROR_DB;
+        failures += !withinBudget;
+        maxErrorDb = std::max(maxErrorDb, errorDb);
+        validationFile << propagationModelToString(points[i].model) << ","
+                       << points[i].distance << "," << reference[i]->rss << "," << fast[i]->rss
+                       << "," << errorDb << "," << reference[i]->throughput << ","
+                       << fast[i]->throughput << "," << withinBudget << "\n";
+    }
+
+    NS_LOG_UNCOND("Fast math validation: " << points.size() << " points, largest RSS error "
+                                           << maxErrorDb << " dB, budget "
+                                           << FAST_MATH_MAX_ERROR_DB << " dB");
+    NS_ABORT_MSG_IF(failures > 0,
+                    failures << " points exceed the fast math error budget, see "
+                             << "output_fastmath_validation.csv");
+}
+
+/**
+ * Check that a fast simulation path gives the same answers as the reference path.
+ *
+ * Every model is simulated at every distance with seeds 1 to seeds, once with the
+ * reference Yans PHY and exact loss models and once with the candidate: fastMath or
+ * abstractPhy. Each metric of each (model, distance) is then tested:
+ * - if the reference gives the same value for every seed, the metric is deterministic
+ *   and every candidate value must match it within a relative tolerance;
+ * - otherwise the values over the seeds are compared with the two-sample
+ *   Kolmogorov-Smirnov test and Welch's test of the means. alpha is the family-wise
+ *   error rate of all these tests, split between them by Bonferroni.
+ * The tests go to output_equivalence.csv, the verdict and the speedup in wall time and
+ * events to output_equivalence_summary.csv.
+ *
+ * \return whether all tests passed
+ */
+inline bool
+RunEquivalenceTests(ResultRing& ring,
+                    const ScenarioConfig& config,
+                    const std::string& candidate,
+                    const std::vector<PropagationModel>& models,
+                    const std::vector<double>& distances,
+                    uint32_t seeds,
+                    unsigned jobs,
+                    double alpha,
+                    double tolerance)
+{
+    ScenarioConfig candidateConfig = config;
+    PhyType candidatePhy = YANS;
+    if (candidate == "fastMath")
+    {
+        candidateConfig.fastMath = true;
+    }
+    else if (candidate == "abstractPhy")
+    {
+        candidatePhy = ABSTRACT;
+    }
+    else
+    {
+        NS_ABORT_MSG("Unknown equivalence candidate " << candidate);
+    }
+    NS_ABORT_MSG_IF(seeds == 0 || distances.empty(), "No points to test");
+
+    std::vector<SweepPoint> referencePoints;
+    std::vector<SweepPoint> candidatePoints;
+    for (PropagationModel model : models)
+    {
+        for (double distance : distances)
+        {
+            for (uint32_t seed = 1; seed <= seeds; seed++)
+            {
+                referencePoints.push_back({model, YANS, AggregationConfig(), distance, seed});
+                candidatePoints.push_back(
+                    {model, candidatePhy, AggregationConfig(), distance, seed});
+            }
+        }
+    }
+    std::vector<std::optional<PointResult>> reference =
+        RunPoints(ring, referencePoints, config, jobs);
+    std::vector<std::optional<PointResult>> fast =
+        RunPoints(ring, candidatePoints, candidateConfig, jobs);
+
+    double referenceWallSeconds = 0;
+    double candidateWallSeconds = 0;
+    uint64_t referenceEvents = 0;
+    uint64_t candidateEvents = 0;
+    for (size_t i = 0; i < referencePoints.size(); i++)
+    {
+        NS_ABORT_MSG_IF(!reference[i], "Simulation failed: " << FormatRequest(referencePoints[i]));
+        NS_ABORT_MSG_IF(!fast[i], "Simulation failed: " << FormatRequest(candidatePoints[i]));
+        referenceWallSeconds += reference[i]->wallSeconds;
+        candidateWallSeconds += fast[i]->wallSeconds;
+        referenceEvents += reference[i]->events;
+        candidateEvents += fast[i]->events;
+    }
+
+    const std::vector<std::pair<std::string, std::function<double(const PointResult&)>>>
+        metrics = {
+            {"rss", [](const PointResult& result) { return result.rss; }},
+            {"throughput", [](const PointResult& result) { return result.throughput; }},
+            {"rxPackets", [](const PointResult& result) { return double(result.rxPackets); }},
+            {"retransmissions",
+             [](const PointResult& result) { return double(result.mac.retransmissions); }},
+        };
+
+    /// One test of one metric at one point
+    struct Test
+    {
+        std::string point;
+        std::string metric;
+        std::string name;
+        TwoSampleTest result;
+        double referenceMean;
+        double candidateMean;
+        bool stochastic;
+    };
+
+    std::vector<Test> tests;
+    for (size_t group = 0; group < referencePoints.size(); group += seeds)
+    {
+        std::ostringstream point;
+        point << propagationModelToString(referencePoints[group].model) << ","
+              << referencePoints[group].distance;
+        for (const auto& [metric, get] : metrics)
+        {
+            std::vector<double> a;
+            std::vector<double> b;
+            for (uint32_t seed = 0; seed < seeds; seed++)
+            {
+                a.push_back(get(*reference[group + seed]));
+                b.push_back(get(*fast[group + seed]));
+            }
+            double meanA = std::accumulate(a.begin(), a.end(), 0.0) / seeds;
+            double meanB = std::accumulate(b.begin(), b.end(), 0.0) / seeds;
+
+            if (std::all_of(a.begin(), a.end(), [&a](double value) { return value == a[0]; }))
+            {
+                double deviation = 0;
+                for (double value : b)
+                {
+                    deviation = std::max(deviation,
+                                         std::fabs(value - a[0]) / std::max(1.0, std::fabs(a[0])));
+                }
+                tests.push_back(
+                    {point.str(), metric, "exact", {deviation, NAN}, meanA, meanB, false});
+            }
+            else
+            {
+                tests.push_back({point.str(),
+                                 metric,
+                                 "kolmogorovSmirnov",
+                                 KolmogorovSmirnovTest(a, b),
+                                 meanA,
+                                 meanB,
+                                 true});
+                tests.push_back(
+                    {point.str(), metric, "welch", WelchTest(a, b), meanA, meanB, true});
+            }
+        }
+    }
+
+    size_t stochasticTests = std::count_if(tests.begin(), tests.end(), [](const Test& test) {
+        return test.stochastic;
+    });
+    double testAlpha = alpha / std::max<size_t>(stochasticTests, 1);
+
+    std::ofstream testsFile("output_equivalence.csv");
+    testsFile << "model,distanceMeters,metric,test,statistic,pValue,referenceMean,"
+                 "candidateMean,passed\n";
+    size_t failures = 0;
+    for (const Test& test : tests)
+    {
+        bool passed = test.stochastic ? test.result.pValue >= testAlpha
+                                      : test.result.statistic <= tolerance;
+        failures += !passed;
+        testsFile << test.point << "," << test.metric << "," << test.name << ","
+                  << test.result.statistic << ",";
+        if (test.stochastic)
+        {
+            testsFile << test.result.pValue;
+        }
+        testsFile << "," << test.referenceMean << "," << test.candidateMean << "," << passed
+                  << "\n";
+        if (!passed)
+        {
+            NS_LOG_UNCOND("Failed: " << test.point << " " << test.metric << " " << test.name);
+        }
+    }
+
+    double speedup = candidateWallSeconds > 0 ? referenceWallSeconds / candidateWallSeconds : 0;
+    double eventReduction = candidateEvents > 0 ? double(referenceEvents) / candidateEvents : 0;
+    std::ofstream summaryFile("output_equivalence_summary.csv");
+    summaryFile << "candidate,points,tests,stochasticTests,failures,referenceWallSeconds,"
+                   "candidateWallSeconds,speedup,eventReduction,passed\n";
+    summaryFile << candidate << "," << referencePoints.size() << "," << tests.size() << ","
+                << stochasticTests << "," << failures << "," << referenceWallSeconds << ","
+                << candidateWallSeconds << "," << speedup << "," << eventReduction << ","
+                << (failures == 0) << "\n";
+
+    NS_LOG_UNCOND("Equivalence of " << candidate << ": " << tests.size() << " tests, "
+                                    << failures << " failed, speedup " << speedup);
+    return failures == 0;
+}
+
+#endif /* SWEEP_VALIDATION_H */
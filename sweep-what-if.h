@@ -0,0 +1,179 @@
+#ifndef SWEEP_WHAT_IF_H
+#define SWEEP_WHAT_IF_H
+
+#include "series-surrogate.h"
+#include "sweep-point.h"
+#include "sweep-shards.h"
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * The simulated points of one series of the what-if cache, in order of distance.
+ */
+struct WhatIfSeries
+{
+    std::vector<double> distances;  // meters
+    std::vector<double> rss;        // dBm
+    std::vector<double> throughput; // Kbps
+};
+
+/**
+ * Results the what-if service answers queries from, for one scenario configuration.
+ */
+struct WhatIfCache
+{
+    std::string configHash;
+    std::unordered_map<std::string, PointResult> points;  // Every point, by FormatRequest
+    std::unordered_map<std::string, WhatIfSeries> series; // Points with bytes, by output file
+    std::ofstream file;                                   // Where new results are appended
+};
+
+/**
+ * Add a simulated point to the what-if cache. Points that delivered nothing have no RSS or
+ * throughput to interpolate, their RSS being 0, so they are only answered exactly.
+ */
+inline void
+AddWhatIfResult(WhatIfCache& cache, const SweepPoint& point, const PointResult& result)
+{
+    if (!cache.points.emplace(FormatRequest(point), result).second || result.rxBytes == 0)
+    {
+        return;
+    }
+    WhatIfSeries& series = cache.series[outputFileName(point)];
+    size_t index = std::lower_bound(series.distances.begin(),
+                                    series.distances.end(),
+                                    point.distance) -
+                   series.distances.begin();
+    series.distances.insert(series.distances.begin() + index, point.distance);
+    series.rss.insert(series.rss.begin() + index, result.rss);
+    series.throughput.insert(series.throughput.begin() + index, result.throughput);
+}
+
+/**
+ * Load the results of a results file, as written by the shards and the what-if service
+ * itself, into the what-if cache. Files of another scenario configuration are refused.
+ *
+ * \return whether the file exists
+ */
+inline bool
+LoadWhatIfResults(WhatIfCache& cache, const std::string& fileName)
+{
+    std::vector<std::string> header;
+    std::vector<std::string> responses;
+    if (!ReadShardFile(fileName, header, responses))
+    {
+        return false;
+    }
+    NS_ABORT_MSG_IF(ShardHeaderValue(header, "config") != cache.configHash,
+                    fileName << " comes from a different scenario configuration");
+
+    size_t loaded = 0;
+    for (const std::string& response : responses)
+    {
+        size_t tab = response.find('\t');
+        SweepPoint point;
+        std::string error;
+        if (tab == std::string::npos || !TryParseRequest(response.substr(0, tab), point, error) ||
+            response.compare(tab + 1, std::string::npos, "error") == 0)
+        {
+            continue;
+        }
+        std::istringstream stream(response.substr(tab + 1));
+        PointResult result = DeserializeResult(stream);
+        stream >> result.wallSeconds >> result.peakRssKb;
+        AddWhatIfResult(cache, point, result);
+        loaded++;
+    }
+    NS_LOG_UNCOND("Loaded " << loaded << " results from " << fileName);
+    return true;
+}
+
+/**
+ * Answer a what-if query, a sweep point request, from the cache.
+ *
+ * The response is the query, a tab and one of
+ * - "exact" and the serialized result, if the point has been simulated;
+ * - "estimate" and the RSS, its error, the throughput and its error, interpolated from
+ *   the series of the point, see InterpolateSeries;
+ * - "unknown", if the point lies outside the simulated distances of its series;
+ * - "error" and what is wrong with the query, which includes distances that are not
+ *   finite or outside (0, maxDistance], so that no query makes the service simulate a
+ *   point the sweep could not have.
+ * If an estimate exceeds a tolerance, or there is none, the point is handed back for
+ * simulation and " refining" is appended.
+ *
+ * \param cache the cache
+ * \param query the query
+ * \param maxDistance the largest distance the service simulates
+ * \param rssTolerance the largest acceptable RSS error in dB
+ * \param throughputTolerance the largest acceptable throughput error in Kbps
+ * \param refinements receives the request of the point to simulate, if any
+ * \return the response
+ */
+inline std::string
+AnswerWhatIf(const WhatIfCache& cache,
+             const std::string& query,
+             double maxDistance,
+             double rssTolerance,
+             double throughputTolerance,
+             std::vector<std::string>& refinements)
+{
+    SweepPoint point;
+    std::string error;
+    if (!TryParseRequest(query, point, error))
+    {
+        return query + "\terror " + error;
+    }
+    if (!std::isfinite(point.distance) || point.distance <= 0 || point.distance > maxDistance)
+    {
+        std::ostringstream response;
+        response << query << "\terror Distance outside (0, " << maxDistance << "]";
+        return response.str();
+    }
+    std::string request = FormatRequest(point);
+
+    auto exact = cache.points.find(request);
+    if (exact != cache.points.end())
+    {
+        return query + "\texact " + SerializeResult(exact->second);
+    }
+
+    std::ostringstream response;
+    response << query << "\t";
+    auto series = cache.series.find(outputFileName(point));
+    SurrogateEstimate rss;
+    SurrogateEstimate throughput;
+    bool refine = true;
+    if (series != cache.series.end() &&
+        InterpolateSeries(series->second.distances, series->second.rss, point.distance, rss) &&
+        InterpolateSeries(series->second.distances,
+                          series->second.throughput,
+                          point.distance,
+                          throughput))
+    {
+        response << "estimate " << rss.value << " " << rss.error << " " << throughput.value << " "
+                 << throughput.error;
+        refine = rss.error > rssTolerance || throughput.error > throughputTolerance;
+    }
+    else
+    {
+        response << "unknown";
+    }
+
+    if (refine)
+    {
+        refinements.push_back(request);
+        response << " refining";
+    }
+    return response.str();
+}
+
+#endif /* SWEEP_WHAT_IF_H */
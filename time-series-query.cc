@@ -0,0 +1,136 @@
+#include "parallel-for.h"
+#include "time-series-store.h"
+
+#include "ns3/command-line.h"
+#include "ns3/core-module.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("TimeSeriesQuery");
+
+int
+main(int argc, char* argv[])
+{
+    std::string store = "time-series.tss";
+    std::string run;
+    std::string series;
+    std::string output = "output_time_series.csv";
+    double from = 0; // seconds
+    double to = -1;  // seconds, negative for the end of the runs
+    unsigned threads = std::max(std::thread::hardware_concurrency(), 1U);
+    bool benchmark = false;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("store", "Time series store, as written by the sweep with --timeSeries", store);
+    cmd.AddValue("run",
+                 "Request of the point to read, as the sweep formats it, all points if empty",
+                 run);
+    cmd.AddValue("series", "Series to read, goodputKbps or rssDbm, all if empty", series);
+    cmd.AddValue("from", "Start of the time range in seconds", from);
+    cmd.AddValue("to", "End of the time range in seconds, negative for the end of the runs", to);
+    cmd.AddValue("output", "Where to write one row per sample", output);
+    cmd.AddValue("threads", "Number of threads decoding chunks", threads);
+    cmd.AddValue("benchmark",
+                 "Instead of writing the samples, only decode them and report the rate",
+                 benchmark);
+    cmd.Parse(argc, argv);
+    threads = std::max(threads, 1U);
+    const int64_t fromNs = std::llround(from * 1e9);
+    const int64_t toNs = to < 0 ? INT64_MAX : std::llround(to * 1e9);
+
+    TimeSeriesReader reader(store);
+    NS_ABORT_MSG_IF(!reader.Error().empty(), reader.Error());
+    std::vector<size_t> found = reader.Find(run, series, fromNs, toNs);
+    const std::vector<TimeSeriesChunk>& chunks = reader.GetChunks();
+
+    // Chunks hold the same number of samples except for the last of every series, so the
+    // threads split them up front; the rows of a thread are joined in chunk order
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> rows(threads);
+    std::vector<uint64_t> samples(threads, 0);
+    std::vector<uint64_t> bytes(threads, 0);
+    std::vector<double> sums(threads, 0);
+    std::atomic<bool> ok{true};
+    ParallelFor(found.size(), threads, [&](size_t begin, size_t end, unsigned thread) {
+        std::ostringstream text;
+        text << std::setprecision(10);
+        for (size_t i = begin; i < end; i++)
+        {
+            const TimeSeriesChunk& chunk = chunks[found[i]];
+            bool complete;
+            if (benchmark)
+            {
+                // The sum keeps the decoding from being optimized away
+                double sum = 0;
+                complete = DecodeTimeSeries(chunk.words,
+                                            chunk.wordCount,
+                                            chunk.count,
+                                            [&sum](int64_t, double value) { sum += value; });
+                sums[thread] += sum;
+                samples[thread] += chunk.count;
+            }
+            else
+            {
+                complete = DecodeTimeSeries(chunk.words,
+                                            chunk.wordCount,
+                                            chunk.count,
+                                            [&](int64_t timeNs, double value) {
+                                                if (timeNs >= fromNs && timeNs < toNs)
+                                                {
+                                                    text << chunk.run << "," << chunk.series
+                                                         << "," << timeNs * 1e-9 << ","
+                                                         << value << "\n";
+                                                    samples[thread]++;
+                                                }
+                                            });
+            }
+            bytes[thread] += chunk.wordCount * sizeof(uint64_t);
+            if (!complete)
+            {
+                ok = false;
+            }
+        }
+        rows[thread] = text.str();
+    });
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    NS_ABORT_MSG_IF(!ok, "Malformed chunk in " << store);
+
+    uint64_t totalSamples = 0;
+    uint64_t totalBytes = 0;
+    for (unsigned thread = 0; thread < threads; thread++)
+    {
+        totalSamples += samples[thread];
+        totalBytes += bytes[thread];
+    }
+
+    if (!benchmark)
+    {
+        std::ofstream file(output);
+        file << "run,series,timeSeconds,value\n";
+        for (const std::string& text : rows)
+        {
+            file << text;
+        }
+        NS_ABORT_MSG_IF(!file, "Cannot write " << output);
+    }
+
+    NS_LOG_UNCOND("Decoded " << totalSamples << " samples of " << found.size() << " of "
+                             << chunks.size() << " chunks (" << totalBytes / 1e6 << " MB, "
+                             << (totalSamples ? double(totalBytes) / totalSamples : 0)
+                             << " bytes per sample) in " << seconds << " s, "
+                             << totalSamples / 1e6 / seconds << " million samples/s");
+    return 0;
+}
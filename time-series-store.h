@@ -0,0 +1,676 @@
+#ifndef TIME_SERIES_STORE_H
+#define TIME_SERIES_STORE_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Header of a chunk of a time series store, followed by the run and series names, each
+ * padded to 8 bytes, and the compressed samples as 64-bit words.
+ */
+struct TimeSeriesChunkHeader
+{
+    char magic[4];         //!< "TSCH"
+    uint16_t runLength;    //!< Bytes of the run name
+    uint16_t seriesLength; //!< Bytes of the series name
+    uint32_t count;        //!< Samples in the chunk
+    uint32_t words;        //!< 64-bit words of compressed samples
+    int64_t firstTime;     //!< Time of the first sample in nanoseconds
+    int64_t lastTime;      //!< Time of the last sample in nanoseconds
+};
+
+/**
+ * Entry of the index of a time series store, one per chunk.
+ */
+struct TimeSeriesIndexEntry
+{
+    uint64_t offset;     //!< Offset of the chunk in the store
+    uint64_t runHash;    //!< TimeSeriesHash of the run name
+    uint64_t seriesHash; //!< TimeSeriesHash of the series name
+    int64_t firstTime;   //!< Time of the first sample in nanoseconds
+    int64_t lastTime;    //!< Time of the last sample in nanoseconds
+    uint32_t count;      //!< Samples in the chunk
+    uint32_t size;       //!< Bytes of the chunk
+};
+
+static_assert(sizeof(TimeSeriesChunkHeader) == 32 && sizeof(TimeSeriesIndexEntry) == 48,
+              "Chunk headers and index entries are written as they are");
+
+/**
+ * 64 bit FNV-1a hash of a run or series name.
+ */
+inline uint64_t
+TimeSeriesHash(const std::string& text)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : text)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * Compresses the samples of one series as in Facebook's Gorilla: the timestamps as the
+ * difference of consecutive deltas in a few bits, zero for a regular sampling interval,
+ * and the values XORed with the previous one, of which only the bits that differ are kept.
+ * A sample of a regularly sampled, slowly changing series takes a few bits instead of 16
+ * bytes.
+ *
+ * Bits are written from the most significant one down into 64-bit words, in the byte order
+ * of the host.
+ */
+class TimeSeriesEncoder
+{
+  public:
+    /**
+     * Append a sample. Times are expected in ascending order but need not be.
+     *
+     * \param timeNs the time in nanoseconds
+     * \param value the value
+     */
+    void Append(int64_t timeNs, double value)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        if (m_count == 0)
+        {
+            m_firstTime = timeNs;
+            Put(timeNs, 64);
+            Put(bits, 64);
+        }
+        else
+        {
+            int64_t delta = timeNs - m_lastTime;
+            PutDeltaOfDelta(delta - m_lastDelta);
+            PutXor(bits ^ m_lastBits);
+            m_lastDelta = delta;
+        }
+        m_lastTime = timeNs;
+        m_lastBits = bits;
+        m_count++;
+    }
+
+    uint32_t GetCount() const
+    {
+        return m_count;
+    }
+
+    int64_t GetFirstTime() const
+    {
+        return m_firstTime;
+    }
+
+    int64_t GetLastTime() const
+    {
+        return m_lastTime;
+    }
+
+    /**
+     * \return the compressed samples
+     */
+    const std::vector<uint64_t>& GetWords() const
+    {
+        return m_words;
+    }
+
+  private:
+    /**
+     * Append the lowest bits of a value.
+     *
+     * \param value the value
+     * \param bits how many of its bits, 1 to 64
+     */
+    void Put(uint64_t value, unsigned bits)
+    {
+        if (bits < 64)
+        {
+            value &= (uint64_t(1) << bits) - 1;
+        }
+        unsigned used = m_bits % 64;
+        if (used == 0)
+        {
+            m_words.push_back(0);
+        }
+        unsigned free = 64 - used;
+        if (bits <= free)
+        {
+            m_words.back() |= value << (free - bits);
+        }
+        else
+        {
+            m_words.back() |= value >> (bits - free);
+            m_words.push_back(value << (64 - (bits - free)));
+        }
+        m_bits += bits;
+    }
+
+    void PutDeltaOfDelta(int64_t deltaOfDelta)
+    {
+        // Control bits 0, 10, 110, 1110 and 1111 select 0, 7, 9, 12 and 64 value bits,
+        // stored with an offset that makes them unsigned
+        if (deltaOfDelta == 0)
+        {
+            Put(0, 1);
+        }
+        else if (deltaOfDelta >= -63 && deltaOfDelta <= 64)
+        {
+            Put(0b10, 2);
+            Put(deltaOfDelta + 63, 7);
+        }
+        else if (deltaOfDelta >= -255 && deltaOfDelta <= 256)
+        {
+            Put(0b110, 3);
+            Put(deltaOfDelta + 255, 9);
+        }
+        else if (deltaOfDelta >= -2047 && deltaOfDelta <= 2048)
+        {
+            Put(0b1110, 4);
+            Put(deltaOfDelta + 2047, 12);
+        }
+        else
+        {
+            Put(0b1111, 4);
+            Put(deltaOfDelta, 64);
+        }
+    }
+
+    void PutXor(uint64_t xorBits)
+    {
+        if (xorBits == 0)
+        {
+            Put(0, 1);
+            return;
+        }
+        unsigned leading = std::min(__builtin_clzll(xorBits), 31);
+        unsigned trailing = __builtin_ctzll(xorBits);
+        if (m_leading <= 64 && leading >= m_leading && trailing >= m_trailing)
+        {
+            // The differing bits fit the window of the previous value
+            Put(0b10, 2);
+            Put(xorBits >> m_trailing, 64 - m_leading - m_trailing);
+        }
+        else
+        {
+            // A new window: 5 bits of leading zeros and 6 of its length, 0 standing for 64
+            unsigned length = 64 - leading - trailing;
+            Put(0b11, 2);
+            Put(leading, 5);
+            Put(length, 6);
+            Put(xorBits >> trailing, length);
+            m_leading = leading;
+            m_trailing = trailing;
+        }
+    }
+
+    std::vector<uint64_t> m_words; //!< Compressed samples
+    uint64_t m_bits = 0;           //!< Bits written
+    uint32_t m_count = 0;          //!< Samples written
+    int64_t m_firstTime = 0;       //!< Time of the first sample
+    int64_t m_lastTime = 0;        //!< Time of the previous sample
+    int64_t m_lastDelta = 0;       //!< Difference of the two previous times
+    uint64_t m_lastBits = 0;       //!< Bits of the previous value
+    unsigned m_leading = 65;       //!< Leading zeros of the window, 65 before the first one
+    unsigned m_trailing = 0;       //!< Trailing zeros of the window
+};
+
+/**
+ * Decode the samples of a chunk, see TimeSeriesEncoder for the format.
+ *
+ * \param words the compressed samples
+ * \param wordCount their number of words
+ * \param count the number of samples
+ * \param handle called with the time in nanoseconds and value of every sample, in order
+ * \return whether the chunk holds that many samples
+ */
+template <typename Handler>
+inline bool
+DecodeTimeSeries(const uint64_t* words, size_t wordCount, uint32_t count, Handler&& handle)
+{
+    const uint64_t totalBits = uint64_t(wordCount) * 64;
+    uint64_t position = 0;
+    // The next 64 bits from the position on, zero beyond the end
+    auto peek = [words, wordCount, &position]() {
+        size_t word = position / 64;
+        unsigned offset = position % 64;
+        uint64_t bits = word < wordCount ? words[word] << offset : 0;
+        if (offset > 0 && word + 1 < wordCount)
+        {
+            bits |= words[word + 1] >> (64 - offset);
+        }
+        return bits;
+    };
+    auto take = [&peek, &position](unsigned bits) {
+        uint64_t value = bits == 0 ? 0 : peek() >> (64 - bits);
+        position += bits;
+        return value;
+    };
+
+    if (count == 0)
+    {
+        return true;
+    }
+    if (totalBits < 128)
+    {
+        return false;
+    }
+    int64_t time = take(64);
+    uint64_t value = take(64);
+    int64_t delta = 0;
+    unsigned leading = 0;
+    unsigned length = 0;
+    double sample;
+    std::memcpy(&sample, &value, sizeof(sample));
+    handle(time, sample);
+
+    for (uint32_t i = 1; i < count; i++)
+    {
+        uint64_t bits = peek();
+        unsigned control = __builtin_clzll(~bits | 0xf);
+        switch (control)
+        {
+        case 0:
+            position += 1;
+            break;
+        case 1:
+            delta += int64_t((bits >> 55) & 0x7f) - 63;
+            position += 9;
+            break;
+        case 2:
+            delta += int64_t((bits >> 52) & 0x1ff) - 255;
+            position += 12;
+            break;
+        case 3:
+            delta += int64_t((bits >> 48) & 0xfff) - 2047;
+            position += 16;
+            break;
+        default:
+            position += 4;
+            delta += int64_t(take(64));
+            break;
+        }
+        time += delta;
+
+        bits = peek();
+        if (!(bits >> 63))
+        {
+            position += 1;
+        }
+        else if (!((bits >> 62) & 1))
+        {
+            position += 2;
+            value ^= take(length) << (64 - leading - length);
+        }
+        else
+        {
+            leading = (bits >> 57) & 0x1f;
+            length = (bits >> 51) & 0x3f;
+            if (length == 0)
+            {
+                length = 64;
+            }
+            position += 13;
+            value ^= take(length) << (64 - leading - length);
+        }
+        if (position > totalBits)
+        {
+            return false;
+        }
+        std::memcpy(&sample, &value, sizeof(sample));
+        handle(time, sample);
+    }
+    return true;
+}
+
+/**
+ * Appends the time series of runs to a store, one compressed chunk at a time.
+ *
+ * The store is a file of chunks, each holding up to CHUNK_SAMPLES samples of one series
+ * of one run, with an index of the chunks next to it in <path>.idx. Both are append-only
+ * and opened with O_APPEND, and every chunk and index entry goes to its file with a single
+ * write, which the kernel places at the end of the file atomically. Any number of
+ * processes, such as the workers of a sweep, can therefore write to the same store
+ * without locking; the chunks of concurrent writers interleave, but never their bytes.
+ * An index entry is written after its chunk, so every indexed chunk is complete.
+ */
+class TimeSeriesWriter
+{
+  public:
+    /**
+     * Open or create a store.
+     *
+     * \param path the store
+     * \param run the run all samples of this writer belong to
+     */
+    TimeSeriesWriter(const std::string& path, const std::string& run)
+        : m_fd(open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644)),
+          m_indexFd(open((path + ".idx").c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644)),
+          m_run(run)
+    {
+        m_failed = run.size() > UINT16_MAX;
+    }
+
+    ~TimeSeriesWriter()
+    {
+        Flush();
+        for (int fd : {m_fd, m_indexFd})
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+    }
+
+    TimeSeriesWriter(const TimeSeriesWriter&) = delete;
+    TimeSeriesWriter& operator=(const TimeSeriesWriter&) = delete;
+
+    /**
+     * \return whether the store could be opened and everything has been written so far
+     */
+    bool Ok() const
+    {
+        return m_fd >= 0 && m_indexFd >= 0 && !m_failed;
+    }
+
+    /**
+     * Append a sample to a series of the run.
+     *
+     * \param series the series, e.g. the name of a metric
+     * \param timeNs the time in nanoseconds
+     * \param value the value
+     */
+    void Append(const std::string& series, int64_t timeNs, double value)
+    {
+        TimeSeriesEncoder& encoder = m_series[series];
+        encoder.Append(timeNs, value);
+        if (encoder.GetCount() == CHUNK_SAMPLES)
+        {
+            WriteChunk(series, encoder);
+            encoder = TimeSeriesEncoder();
+        }
+    }
+
+    /**
+     * Write the samples appended so far as chunks, e.g. at the end of a run.
+     */
+    void Flush()
+    {
+        for (auto& [series, encoder] : m_series)
+        {
+            if (encoder.GetCount() > 0)
+            {
+                WriteChunk(series, encoder);
+            }
+        }
+        m_series.clear();
+    }
+
+    static constexpr uint32_t CHUNK_SAMPLES = 4096; //!< Samples per chunk at most
+
+  private:
+    void WriteChunk(const std::string& series, const TimeSeriesEncoder& encoder)
+    {
+        if (!Ok() || series.size() > UINT16_MAX)
+        {
+            m_failed = true;
+            return;
+        }
+        auto padded = [](size_t size) { return (size + 7) / 8 * 8; };
+        const std::vector<uint64_t>& words = encoder.GetWords();
+
+        TimeSeriesChunkHeader header{{'T', 'S', 'C', 'H'},
+                                     uint16_t(m_run.size()),
+                                     uint16_t(series.size()),
+                                     encoder.GetCount(),
+                                     uint32_t(words.size()),
+                                     encoder.GetFirstTime(),
+                                     encoder.GetLastTime()};
+        std::vector<uint8_t> chunk(sizeof(header) + padded(m_run.size()) +
+                                   padded(series.size()) + words.size() * sizeof(uint64_t));
+        uint8_t* position = chunk.data();
+        std::memcpy(position, &header, sizeof(header));
+        position += sizeof(header);
+        std::memcpy(position, m_run.data(), m_run.size());
+        position += padded(m_run.size());
+        std::memcpy(position, series.data(), series.size());
+        position += padded(series.size());
+        std::memcpy(position, words.data(), words.size() * sizeof(uint64_t));
+
+        // With O_APPEND, the offset of the file descriptor ends up behind the chunk even if
+        // other processes append at the same time
+        if (write(m_fd, chunk.data(), chunk.size()) != ssize_t(chunk.size()))
+        {
+            m_failed = true;
+            return;
+        }
+        off_t end = lseek(m_fd, 0, SEEK_CUR);
+        TimeSeriesIndexEntry entry{uint64_t(end) - chunk.size(),
+                                   TimeSeriesHash(m_run),
+                                   TimeSeriesHash(series),
+                                   header.firstTime,
+                                   header.lastTime,
+                                   header.count,
+                                   uint32_t(chunk.size())};
+        if (end < 0 || write(m_indexFd, &entry, sizeof(entry)) != ssize_t(sizeof(entry)))
+        {
+            m_failed = true;
+        }
+    }
+
+    int m_fd;                                          //!< The store
+    int m_indexFd;                                     //!< Its index
+    bool m_failed = false;                             //!< Whether a write failed
+    std::string m_run;                                 //!< Run of the samples
+    std::map<std::string, TimeSeriesEncoder> m_series; //!< Chunk being filled, per series
+};
+
+/**
+ * A chunk of a store, as the reader finds it.
+ */
+struct TimeSeriesChunk
+{
+    std::string run;       //!< The run
+    std::string series;    //!< The series
+    int64_t firstTime;     //!< Time of the first sample in nanoseconds
+    int64_t lastTime;      //!< Time of the last sample in nanoseconds
+    uint32_t count;        //!< Samples in the chunk
+    const uint64_t* words; //!< The compressed samples, within the mapping of the store
+    uint32_t wordCount;    //!< Their number of words
+};
+
+/**
+ * Reads a time series store, see TimeSeriesWriter, mapped into memory. The index locates
+ * the chunks; without an index the store is scanned chunk by chunk.
+ */
+class TimeSeriesReader
+{
+  public:
+    /**
+     * Map a store and list its chunks.
+     *
+     * \param path the store
+     */
+    explicit TimeSeriesReader(const std::string& path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            m_error = "Cannot open " + path;
+            return;
+        }
+        struct stat status;
+        if (fstat(fd, &status) != 0)
+        {
+            m_error = "Cannot stat " + path;
+            close(fd);
+            return;
+        }
+        m_size = status.st_size;
+        void* mapping = m_size ? mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+        close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            m_error = "Cannot map " + path;
+            m_size = 0;
+            return;
+        }
+        m_data = static_cast<const uint8_t*>(mapping);
+
+        std::vector<TimeSeriesIndexEntry> index;
+        int indexFd = open((path + ".idx").c_str(), O_RDONLY);
+        if (indexFd >= 0)
+        {
+            TimeSeriesIndexEntry entry;
+            while (read(indexFd, &entry, sizeof(entry)) == ssize_t(sizeof(entry)))
+            {
+                index.push_back(entry);
+            }
+            close(indexFd);
+            for (const TimeSeriesIndexEntry& entry : index)
+            {
+                if (!AddChunk(entry.offset, entry.size))
+                {
+                    m_error = "Index entry beyond the chunks of " + path;
+                    return;
+                }
+            }
+        }
+        else
+        {
+            for (uint64_t offset = 0; offset < m_size;)
+            {
+                uint64_t size = ChunkSize(offset);
+                if (size == 0 || !AddChunk(offset, size))
+                {
+                    m_error = "Malformed chunk in " + path;
+                    return;
+                }
+                offset += size;
+            }
+        }
+    }
+
+    ~TimeSeriesReader()
+    {
+        if (m_data)
+        {
+            munmap(const_cast<uint8_t*>(m_data), m_size);
+        }
+    }
+
+    TimeSeriesReader(const TimeSeriesReader&) = delete;
+    TimeSeriesReader& operator=(const TimeSeriesReader&) = delete;
+
+    /**
+     * \return why the store cannot be read, empty if it can
+     */
+    const std::string& Error() const
+    {
+        return m_error;
+    }
+
+    /**
+     * \return the chunks, in the order they were written
+     */
+    const std::vector<TimeSeriesChunk>& GetChunks() const
+    {
+        return m_chunks;
+    }
+
+    /**
+     * \return the size of the store in bytes
+     */
+    uint64_t GetSize() const
+    {
+        return m_size;
+    }
+
+    /**
+     * Find the chunks with samples of a run and series within a time range.
+     *
+     * \param run the run, empty for any
+     * \param series the series, empty for any
+     * \param fromNs the start of the range in nanoseconds
+     * \param toNs its end, exclusive
+     * \return the indexes of the chunks
+     */
+    std::vector<size_t> Find(const std::string& run,
+                             const std::string& series,
+                             int64_t fromNs,
+                             int64_t toNs) const
+    {
+        std::vector<size_t> found;
+        for (size_t i = 0; i < m_chunks.size(); i++)
+        {
+            const TimeSeriesChunk& chunk = m_chunks[i];
+            if ((run.empty() || chunk.run == run) && (series.empty() || chunk.series == series) &&
+                chunk.lastTime >= fromNs && chunk.firstTime < toNs)
+            {
+                found.push_back(i);
+            }
+        }
+        return found;
+    }
+
+  private:
+    /**
+     * \return the size of the chunk at an offset, 0 if there is none
+     */
+    uint64_t ChunkSize(uint64_t offset) const
+    {
+        TimeSeriesChunkHeader header;
+        if (m_size - offset < sizeof(header))
+        {
+            return 0;
+        }
+        std::memcpy(&header, m_data + offset, sizeof(header));
+        if (std::memcmp(header.magic, "TSCH", 4) != 0)
+        {
+            return 0;
+        }
+        auto padded = [](uint64_t size) { return (size + 7) / 8 * 8; };
+        return sizeof(header) + padded(header.runLength) + padded(header.seriesLength) +
+               uint64_t(header.words) * sizeof(uint64_t);
+    }
+
+    bool AddChunk(uint64_t offset, uint64_t size)
+    {
+        if (offset % 8 != 0 || offset > m_size || ChunkSize(offset) != size ||
+            size > m_size - offset)
+        {
+            return false;
+        }
+        TimeSeriesChunkHeader header;
+        std::memcpy(&header, m_data + offset, sizeof(header));
+        const char* names = reinterpret_cast<const char*>(m_data + offset + sizeof(header));
+        size_t seriesOffset = (header.runLength + 7) / 8 * 8;
+        size_t wordsOffset = sizeof(header) + seriesOffset + (header.seriesLength + 7) / 8 * 8;
+        m_chunks.push_back({std::string(names, header.runLength),
+                            std::string(names + seriesOffset, header.seriesLength),
+                            header.firstTime,
+                            header.lastTime,
+                            header.count,
+                            reinterpret_cast<const uint64_t*>(m_data + offset + wordsOffset),
+                            header.words});
+        return true;
+    }
+
+    const uint8_t* m_data = nullptr;       //!< The mapped store
+    uint64_t m_size = 0;                   //!< Its size
+    std::vector<TimeSeriesChunk> m_chunks; //!< Its chunks
+    std::string m_error;                   //!< Why it cannot be read
+};
+
+#endif /* TIME_SERIES_STORE_H */
@@ -1,75 +1,33 @@
-#include "ns3/applications-module.h"
-#include "ns3/config.h"
+#include "sweep-analytic.h"
+#include "sweep-benchmarks.h"
+#include "sweep-import.h"
+#include "sweep-point.h"
+#include "sweep-scenario.h"
+#include "sweep-shard-runs.h"
+#include "sweep-validation.h"
+#include "sweep-what-if.h"
+
 #include "ns3/core-module.h"
-#include "ns3/double.h"
-#include "ns3/flow-monitor-helper.h"
-#include "ns3/flow-monitor-module.h"
-#include "ns3/flow-monitor.h"
-#include "ns3/internet-module.h"
-#include "ns3/internet-stack-helper.h"
-#include "ns3/ipv4-address-helper.h"
-#include "ns3/log.h"
-#include "ns3/mobility-helper.h"
-#include "ns3/mobility-model.h"
-#include "ns3/network-module.h"
-#include "ns3/packet-sink-helper.h"
-#include "ns3/string.h"
-#include "ns3/udp-client-server-helper.h"
-#include "ns3/yans-wifi-channel.h"
-#include "ns3/yans-wifi-helper.h"
 
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cerrno>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
 #include <string>
 #include <vector>
 
 using namespace ns3;
 
+// The sweep headers log through it by level, see SweepLogComponent
 NS_LOG_COMPONENT_DEFINE("AdhocWifiPropagationComparison");
 
-enum PropagationModel
-{
-    FRIIS,
-    FIXED_RSS,
-    THREE_LOG_DISTANCE,
-    TWO_RAY_GROUND,
-    NAKAGAMI
-};
-
-inline const std::string
-propagationModelToString(PropagationModel model)
-{
-    switch (model)
-    {
-    case FRIIS:
-        return "Friis";
-    case FIXED_RSS:
-        return "FixedRSS";
-    case THREE_LOG_DISTANCE:
-        return "ThreeLogDistance";
-    case TWO_RAY_GROUND:
-        return "TwoRayGround";
-    case NAKAGAMI:
-        return "Nakagami";
-    }
-}
-
-double averageRSS = 0;
-
-static void
-PhyTrace(Ptr<const Packet> packet,
-         uint16_t channelFreqMhz,
-         WifiTxVector txVector,
-         MpduInfo aMpdu,
-         SignalNoiseDbm signalNoise,
-         uint16_t staId)
-
-{
-    NS_LOG_DEBUG("Received packet with signal: " << signalNoise.signal
-                                                 << ", noise: " << signalNoise.noise);
-    averageRSS = (signalNoise.signal + averageRSS) / 2.;
-}
-
 int
 main(int argc, char* argv[])
 {
@@ -82,187 +40,842 @@ main(int argc, char* argv[])
     Time::SetResolution(Time::NS);
 
     // Simulation parameters
-    const double simulationTime = 50; // Maximum simulation time in seconds
+    ScenarioConfig config;
+
+    std::string phyTypeList = "Yans";
+    AggregationConfig defaultAggregation;
+    std::string maxAmpduSizeList = std::to_string(defaultAggregation.maxAmpduSize);
+    std::string maxAmsduSizeList = std::to_string(defaultAggregation.maxAmsduSize);
+    std::string blockAckThresholdList = std::to_string(defaultAggregation.blockAckThreshold);
+    std::string blockAckTimeoutList =
+        std::to_string(defaultAggregation.blockAckInactivityTimeout);
+    std::string hopsList = "1";
+    std::string transportList = "UdpCbr";
+    std::string congestionControlList = "TcpNewReno";
+    std::string segmentSizeList = "1448";
+    unsigned jobs = 1;
+    std::string serve;
+    bool warmup = true;
+    uint32_t benchmarkServerTasks = 0;
+    uint32_t writeShards = 0;
+    int runShard = -1;
+    uint32_t mergeShards = 0;
+    std::string shardPrefix = "shard";
+    std::string shardCostFile;
+    std::string seedList = "1";
+    double maxDistance = 500;
+    bool rssTimeSeries = false;
+    std::string pinning = "none";
+    uint32_t benchmarkPinningTasks = 0;
+    std::string benchmarkContention;
+    std::string contentionDistances = "10";
+    double contentionDataRate = 150e6;
+    std::string analyticContention;
+    bool validateAnalytic = false;
+    uint32_t analyticSamples = 200;
+    uint32_t benchmarkAntennaCalls = 0;
+    uint32_t benchmarkPlacementNodes = 0;
+    double placementBounds = 1e5;
+    std::string lossParametersFile;
+    bool validateFastMath = false;
+    std::string equivalence;
+    std::string equivalenceDistances = "10,50,100,200";
+    uint32_t equivalenceSeeds = 10;
+    double equivalenceAlpha = 0.01;
+    double equivalenceTolerance = 1e-6;
+    uint32_t benchmarkFastMathCalls = 0;
+    std::string whatIf;
+    std::string whatIfCacheFile = "whatif.results";
+    std::string whatIfImport;
+    std::string eventLog;
+    std::string timeSeriesPath;
+    std::string flowXml;
+    std::string flightRecorderOption;
+    std::string resultStorePath;
+    std::string importResults;
+    std::string flightRecorderPath = "flight-recorder";
+    double whatIfRssTolerance = 1;
+    double whatIfThroughputTolerance = 1000;
+    uint32_t whatIfMaxQueued = 1000;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("phyTypes",
+                 "Comma separated PHY/channel types to sweep (Yans, Spectrum, Abstract); the "
+                 "first one is the reference for output_phy_comparison.csv",
+                 phyTypeList);
+    cmd.AddValue("maxAmpduSizes",
+                 "Comma separated BE_MaxAmpduSize values to sweep in bytes (0 disables A-MPDU)",
+                 maxAmpduSizeList);
+    cmd.AddValue("maxAmsduSizes",
+                 "Comma separated BE_MaxAmsduSize values to sweep in bytes (0 disables A-MSDU)",
+                 maxAmsduSizeList);
+    cmd.AddValue("blockAckThresholds",
+                 "Comma separated QosTxop BlockAckThreshold values to sweep",
+                 blockAckThresholdList);
+    cmd.AddValue("blockAckInactivityTimeouts",
+                 "Comma separated QosTxop BlockAckInactivityTimeout values to sweep (in units "
+                 "of 1024 us)",
+                 blockAckTimeoutList);
+    cmd.AddValue("hops",
+                 "Comma separated numbers of hops to sweep: the client reaches the server over "
+                 "a chain of relays, with the distance as the spacing of the nodes",
+                 hopsList);
+    cmd.AddValue("transports",
+                 "Comma separated transports to sweep: UdpCbr at the data rate, UdpSaturating "
+                 "or TcpBulk",
+                 transportList);
+    cmd.AddValue("congestionControls",
+                 "Comma separated ns-3 TCP congestion controls TcpBulk is swept with, e.g. "
+                 "TcpNewReno,TcpCubic",
+                 congestionControlList);
+    cmd.AddValue("segmentSizes",
+                 "Comma separated TCP segment sizes in bytes TcpBulk is swept with",
+                 segmentSizeList);
+    cmd.AddValue("jobs", "Number of sweep points simulated in parallel worker processes", jobs);
+    cmd.AddValue("simulationTime", "Maximum simulation time in seconds", config.simulationTime);
+    cmd.AddValue("serve",
+                 "Instead of sweeping, serve sweep point requests from stdin (-) or on the "
+                 "UNIX socket at this path with pre-warmed forked workers",
+                 serve);
+    cmd.AddValue("warmup", "Warm up the server process before forking workers", warmup);
+    cmd.AddValue("whatIf",
+                 "Instead of sweeping, answer what-if queries on the UNIX socket at this path "
+                 "from cached results and estimates, simulating points to refine them",
+                 whatIf);
+    cmd.AddValue("whatIfCache",
+                 "Results file the what-if service loads and appends its simulations to",
+                 whatIfCacheFile);
+    cmd.AddValue("whatIfImport",
+                 "Comma separated results files, such as shard results, the what-if service "
+                 "loads as well",
+                 whatIfImport);
+    cmd.AddValue("whatIfRssTolerance",
+                 "Largest estimated RSS error in dB the what-if service accepts without "
+                 "simulating the point",
+                 whatIfRssTolerance);
+    cmd.AddValue("whatIfThroughputTolerance",
+                 "Largest estimated throughput error in Kbps the what-if service accepts "
+                 "without simulating the point",
+                 whatIfThroughputTolerance);
+    cmd.AddValue("whatIfMaxQueued",
+                 "Most points the what-if service queues for simulation at a time; queries "
+                 "that would queue more are answered with \" busy\" appended",
+                 whatIfMaxQueued);
+    cmd.AddValue("benchmarkServer",
+                 "Instead of sweeping, compare the throughput of this many tasks in forked "
+                 "pre-warmed workers against one process per task",
+                 benchmarkServerTasks);
+    cmd.AddValue("writeShards",
+                 "Instead of sweeping, split the sweep into this many shard manifests balanced "
+                 "by predicted cost",
+                 writeShards);
+    cmd.AddValue("runShard",
+                 "Instead of sweeping, run the shard manifest with this index",
+                 runShard);
+    cmd.AddValue("mergeShards",
+                 "Instead of sweeping, merge the results of this many shards into the "
+                 "per-model output files",
+                 mergeShards);
+    cmd.AddValue("shardPrefix",
+                 "Prefix of the shard files, <prefix>_<index>.manifest and .results",
+                 shardPrefix);
+    cmd.AddValue("shardCostFile",
+                 "output_phy_comparison.csv of an earlier sweep whose wall times predict the "
+                 "cost of the shard points",
+                 shardCostFile);
+    cmd.AddValue("seeds", "Comma separated ns-3 run numbers the shard manifests cover", seedList);
+    cmd.AddValue("maxDistance",
+                 "Largest distance in meters the shard manifests and the fast math validation "
+                 "cover",
+                 maxDistance);
+    cmd.AddValue("pinning",
+                 "Pin worker processes to CPUs: none, compact (SMT siblings first), spread "
+                 "(across cores and NUMA nodes first) or physical (one worker per core, at "
+                 "most as many workers as cores); memory is bound to the node of the CPU",
+                 pinning);
+    cmd.AddValue("benchmarkPinning",
+                 "Instead of sweeping, run this many tasks under every pinning policy with up "
+                 "to --jobs workers",
+                 benchmarkPinningTasks);
+    cmd.AddValue("benchmarkContention",
+                 "Instead of sweeping, let these comma separated numbers of clients saturate the "
+                 "server, e.g. 1,2,4,8,16,32,64,128,256",
+                 benchmarkContention);
+    cmd.AddValue("contentionDistances",
+                 "Comma separated distances of the contending clients from the server in meters",
+                 contentionDistances);
+    cmd.AddValue("contentionDataRate",
+                 "Data rate every contending client offers in bit/s",
+                 contentionDataRate);
+    cmd.AddValue("analyticContention",
+                 "Instead of sweeping, evaluate the analytic saturation model for these comma "
+                 "separated numbers of clients at the contention distances",
+                 analyticContention);
+    cmd.AddValue("validateAnalytic",
+                 "Compare the analytic saturation model with the points of --benchmarkContention",
+                 validateAnalytic);
+    cmd.AddValue("analyticSamples",
+                 "Received power samples per link the analytic saturation model averages the "
+                 "frame error rate over",
+                 analyticSamples);
+    cmd.AddValue("lossParameters",
+                 "File with the loss model parameters, as written by propagation-calibration",
+                 lossParametersFile);
+    cmd.AddValue("fastMath",
+                 "Replace the Friis, TwoRayGround and ThreeLogDistance loss models by fast "
+                 "approximations within FAST_MATH_MAX_ERROR_DB",
+                 config.fastMath);
+    cmd.AddValue("validateFastMath",
+                 "Instead of sweeping, check that the fast loss models keep the RSS curves "
+                 "within their error budget up to --maxDistance",
+                 validateFastMath);
+    cmd.AddValue("equivalence",
+                 "Instead of sweeping, test whether a fast path, fastMath or abstractPhy, gives "
+                 "the same results as the reference path; the exit status is 1 if not",
+                 equivalence);
+    cmd.AddValue("equivalenceDistances",
+                 "Comma separated distances in meters the equivalence tests cover",
+                 equivalenceDistances);
+    cmd.AddValue("equivalenceSeeds",
+                 "Number of seeds every equivalence test point is simulated with",
+                 equivalenceSeeds);
+    cmd.AddValue("equivalenceAlpha",
+                 "Family-wise significance level of the statistical equivalence tests",
+                 equivalenceAlpha);
+    cmd.AddValue("equivalenceTolerance",
+                 "Relative tolerance of the equivalence tests of deterministic metrics",
+                 equivalenceTolerance);
+    cmd.AddValue("benchmarkFastMath",
+                 "Instead of sweeping, time this many calls of the fast math functions and loss "
+                 "models against the reference ones",
+                 benchmarkFastMathCalls);
+    cmd.AddValue("antenna",
+                 "Antenna of both nodes: Isotropic, Parabolic or a file with an azimuth, "
+                 "inclination, gain (degrees, dBi) pattern",
+                 config.antenna);
+    cmd.AddValue("antennaBeamwidth",
+                 "3 dB beamwidth of the parabolic antenna in degrees",
+                 config.antennaBeamwidth);
+    cmd.AddValue("antennaMisalignment",
+                 "Rotation of both antennas away from the link in degrees",
+                 config.antennaMisalignment);
+    cmd.AddValue("benchmarkAntenna",
+                 "Instead of sweeping, measure the per-frame cost of this many received power "
+                 "calculations with isotropic and directional antennas",
+                 benchmarkAntennaCalls);
+    cmd.AddValue("benchmarkPlacement",
+                 "Instead of sweeping, measure the setup time of placing this many nodes from a "
+                 "position file",
+                 benchmarkPlacementNodes);
+    cmd.AddValue("eventLog",
+                 "Directory to write a binary log of the PHY, MAC and application events of "
+                 "every simulated point to, for event-log-metrics",
+                 eventLog);
+    cmd.AddValue("flowXml",
+                 "Directory to write the flow monitor statistics of every simulated point to, "
+                 "as <output file>_d<distance>.flow.xml",
+                 flowXml);
+    cmd.AddValue("timeSeries",
+                 "Compressed time series store to append the windowed goodput and RSS of "
+                 "the server in every simulated point to, for time-series-query",
+                 timeSeriesPath);
+    cmd.AddValue("timeSeriesInterval",
+                 "Window of the --timeSeries samples in seconds",
+                 sweepState.timeSeriesInterval);
+    cmd.AddValue("resultStore",
+                 "SQLite database to store the runs, points, flow statistics and timing of the "
+                 "sweep in, next to the output files",
+                 resultStorePath);
+    cmd.AddValue("importResults",
+                 "Instead of sweeping, import these comma separated result files (.results, "
+                 "output_<Model>*.csv, output_runtime.csv) into the --resultStore database",
+                 importResults);
+    cmd.AddValue("flightRecorder",
+                 "The recent frames of every node are always kept in memory and dumped when "
+                 "the run fails or one of these comma separated triggers fires: "
+                 "stall:<seconds> without a received packet, rss:<dB> off the mean RSS, lost; "
+                 "frames:<count> sets the frames kept per node",
+                 flightRecorderOption);
+    cmd.AddValue("flightRecorderDirectory",
+                 "Directory to dump the flight recorder to",
+                 flightRecorderPath);
+    cmd.AddValue("rssTimeSeries",
+                 "Write the RSS of every frame the server receives to output_<Model>_rss.csv",
+                 rssTimeSeries);
+    cmd.AddValue("interferers",
+                 "Number of background interferers around the server, simulated as one "
+                 "aggregate interference process",
+                 config.interferers);
+    cmd.AddValue("interfererDistance",
+                 "Distance of the background interferers from the server in meters",
+                 config.interfererDistance);
+    cmd.AddValue("interfererDutyCycle",
+                 "Fraction of time each background interferer transmits",
+                 config.interfererDutyCycle);
+    cmd.AddValue("interfererTxPower",
+                 "Distribution of the interferer transmit power in dBm",
+                 config.interfererTxPower);
+    cmd.AddValue("interfererPlacement",
+                 "CSV or binary position file of further interferers, relative to the server, "
+                 "with optional antennaHeight, dutyCycle and txPower columns",
+                 config.interfererPlacement);
+    cmd.AddValue("placementBounds",
+                 "Largest coordinate in meters a node of the position file may have",
+                 placementBounds);
+    cmd.Parse(argc, argv);
+
+    if (!lossParametersFile.empty())
+    {
+        std::string error;
+        NS_ABORT_MSG_IF(!ReadLossParameters(lossParametersFile, config.loss, error), error);
+    }
 
-    const double dataRate = 75e6;                              // 75 Mbps target data rate
-    const uint64_t packetSize = 1450;                          // bytes
-    const double interval = 1 / (dataRate / (packetSize * 8)); // delay between packets
-    const uint64_t packetLimit = simulationTime / interval;
+    std::vector<PhyType> phyTypes;
+    for (const std::string& name : SplitList(phyTypeList))
+    {
+        phyTypes.push_back(phyTypeFromString(name));
+    }
+    NS_ABORT_MSG_IF(phyTypes.empty(), "At least one PHY type is required");
+    jobs = std::max(jobs, 1U);
+    if (pinning != "none")
+    {
+        WorkerCpus() = PlacementOrder(pinning, ReadCpuTopology());
+        NS_ABORT_MSG_IF(WorkerCpus().empty(), "Unknown pinning policy " << pinning);
+        // More workers would wrap around onto cores already in use
+        if (pinning == "physical" && jobs > WorkerCpus().size() && benchmarkPinningTasks == 0)
+        {
+            NS_LOG_UNCOND("Only " << WorkerCpus().size() << " physical cores, running as many "
+                                  << "workers instead of " << jobs);
+            jobs = WorkerCpus().size();
+        }
+    }
 
-    const double txPower = 10; // dBm
-    const double txGain = 1;   // dB
-    const double rxGain = 1;   // dB
+    if (!config.interfererPlacement.empty())
+    {
+        // Loaded once, so that the forked workers share the mapping or the parsed rows
+        config.placement = Create<NodePlacement>(config.interfererPlacement, jobs);
+        std::string error;
+        NS_ABORT_MSG_IF(!config.placement->Validate(
+                            Vector(-placementBounds, -placementBounds, -placementBounds),
+                            Vector(placementBounds, placementBounds, placementBounds),
+                            error),
+                        config.interfererPlacement << ": " << error);
+        int dutyCycle = config.placement->Column("dutyCycle");
+        for (uint64_t row = 0; dutyCycle >= 0 && row < config.placement->GetRows(); row++)
+        {
+            double value = config.placement->GetValue(row, dutyCycle);
+            NS_ABORT_MSG_IF(value < 0 || value > 1,
+                            config.interfererPlacement << ": node " << row
+                                                       << " has a duty cycle of " << value);
+        }
+    }
 
-    const double antennaZ = 1.5; // Antenna height in meters
+    auto handleRequest = [&config](const std::string& request) {
+        return SerializeResult(RunPoint(ParseRequest(request), config));
+    };
 
-    for (PropagationModel model : modelsToBeExamined)
+    if ((!serve.empty() || !whatIf.empty()) && warmup)
     {
-        std::ofstream outputFile;
-        std::string outputFileName = "output_" + propagationModelToString(model) + ".csv";
-        outputFile.open(outputFileName);
-        outputFile << "distanceMeters,rssDBm,throughputKbps,";
-        NS_LOG_UNCOND("Running with " << propagationModelToString(model));
-        outputFile << propagationModelToString(model) << "\n";
-        outputFile.close();
+        // Run a point that ends right away to initialise what ns-3 only sets up on first
+        // use, so that every forked worker starts from a warm process
+        ScenarioConfig warmupConfig = config;
+        warmupConfig.simulationTime = 0.001;
+        RunPoint(ParseRequest(""), warmupConfig);
+    }
 
-        bool connectionPossible = true;
+    if (!eventLog.empty())
+    {
+        NS_ABORT_MSG_IF(mkdir(eventLog.c_str(), 0755) != 0 && errno != EEXIST,
+                        "Cannot create " << eventLog);
+        sweepState.eventLogDirectory = eventLog;
+    }
+    if (!flowXml.empty())
+    {
+        NS_ABORT_MSG_IF(mkdir(flowXml.c_str(), 0755) != 0 && errno != EEXIST,
+                        "Cannot create " << flowXml);
+        sweepState.flowXmlDirectory = flowXml;
+    }
+    if (!timeSeriesPath.empty())
+    {
+        NS_ABORT_MSG_IF(sweepState.timeSeriesInterval <= 0,
+                        "--timeSeriesInterval must be positive");
+        sweepState.timeSeriesStore = timeSeriesPath;
+    }
 
-        for (double d = 1; connectionPossible; d += 1)
-        {
-            NS_LOG_UNCOND("Running simulation for distance=" << d << "m");
+    std::string flightRecorderError;
+    NS_ABORT_MSG_IF(!ParseFlightRecorderTriggers(flightRecorderOption,
+                                                 sweepState.flightRecorderTriggers,
+                                                 flightRecorderError),
+                    flightRecorderError);
+    sweepState.flightRecorderDirectory = flightRecorderPath;
 
-            averageRSS = 0;
+    if (!whatIf.empty())
+    {
+        WhatIfCache cache;
+        cache.configHash = ConfigHash(config);
+        for (const std::string& fileName : SplitList(whatIfImport))
+        {
+            NS_ABORT_MSG_IF(!LoadWhatIfResults(cache, fileName), "Cannot read " << fileName);
+        }
+        if (!LoadWhatIfResults(cache, whatIfCacheFile))
+        {
+            std::ofstream(whatIfCacheFile) << "# config " << cache.configHash << "\n";
+        }
+        cache.file.open(whatIfCacheFile, std::ios_base::app);
+
+        ServeQueries(
+            whatIf,
+            [&](const std::string& query, std::vector<std::string>& refinements) {
+                return AnswerWhatIf(cache,
+                                    query,
+                                    maxDistance,
+                                    whatIfRssTolerance,
+                                    whatIfThroughputTolerance,
+                                    refinements);
+            },
+            handleRequest,
+            [&cache](const std::string& request, const TaskOutcome& outcome) {
+                if (!outcome.succeeded)
+                {
+                    NS_LOG_UNCOND("Refining " << request << " failed");
+                    return;
+                }
+                std::istringstream stream(outcome.output);
+                PointResult result = DeserializeResult(stream);
+                result.wallSeconds = outcome.wallSeconds;
+                result.peakRssKb = outcome.peakRssKb;
+                AddWhatIfResult(cache, ParseRequest(request), result);
+                cache.file << request << "\t" << SerializeResult(result) << " "
+                           << result.wallSeconds << " " << result.peakRssKb << std::endl;
+            },
+            jobs,
+            whatIfMaxQueued);
+        return 0;
+    }
 
-            Time interPacketInterval = Seconds(interval);
+    if (!serve.empty())
+    {
+        if (serve == "-")
+        {
+            ServeTasks(STDIN_FILENO, STDOUT_FILENO, handleRequest, jobs);
+        }
+        else
+        {
+            ServeUnixSocket(serve, handleRequest, jobs);
+        }
+        return 0;
+    }
 
-            NodeContainer nodes;
-            nodes.Create(2);
+    if (benchmarkFastMathCalls > 0)
+    {
+        RunFastMathBenchmark(config, benchmarkFastMathCalls);
+        return 0;
+    }
 
-            InternetStackHelper stack;
-            stack.Install(nodes);
+    if (benchmarkAntennaCalls > 0)
+    {
+        RunAntennaBenchmark(config, benchmarkAntennaCalls);
+        return 0;
+    }
 
-            WifiHelper wifi;
-            wifi.SetStandard(WIFI_STANDARD_80211n);
+    if (benchmarkPlacementNodes > 0)
+    {
+        RunPlacementBenchmark(config, benchmarkPlacementNodes, jobs);
+        return 0;
+    }
 
-            YansWifiPhyHelper wifiPhy;
-            wifiPhy.Set("TxPowerStart", DoubleValue(txPower));
-            wifiPhy.Set("TxPowerEnd", DoubleValue(txPower));
-            wifiPhy.Set("RxGain", DoubleValue(rxGain));
-            wifiPhy.Set("TxGain", DoubleValue(txGain));
-            wifiPhy.Set("ChannelSettings", StringValue("{0, 40, BAND_5GHZ, 0}"));
+    if (benchmarkServerTasks > 0)
+    {
+        RunServerBenchmark(argc, argv, benchmarkServerTasks, jobs, handleRequest);
+        return 0;
+    }
 
-            YansWifiChannelHelper wifiChannel;
-            wifiChannel.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
+    std::unique_ptr<ResultStore> store;
+    if (!resultStorePath.empty())
+    {
+        store = std::make_unique<ResultStore>(resultStorePath);
+        NS_ABORT_MSG_IF(!store->Ok(), store->Error());
+    }
+    if (!importResults.empty())
+    {
+        NS_ABORT_MSG_IF(!store, "--importResults needs --resultStore");
+        ImportResults(*store, SplitList(importResults));
+        return 0;
+    }
 
-            switch (model)
+    // Variants are ordered aggregation-major, so the reference PHY type of a variant is
+    // the first one of its group of phyTypes.size() variants
+    std::vector<Variant> variants;
+    for (uint32_t maxAmpduSize : ParseUnsignedList("maxAmpduSizes", maxAmpduSizeList))
+    {
+        for (uint32_t maxAmsduSize : ParseUnsignedList("maxAmsduSizes", maxAmsduSizeList))
+        {
+            for (uint32_t blockAckThreshold :
+                 ParseUnsignedList("blockAckThresholds", blockAckThresholdList))
             {
-            case FRIIS:
-                wifiChannel.AddPropagationLoss("ns3::FriisPropagationLossModel",
-                                               "Frequency",
-                                               DoubleValue(5.18e9),
-                                               "SystemLoss",
-                                               DoubleValue(1.0));
-                break;
-            case FIXED_RSS:
-                wifiChannel.AddPropagationLoss("ns3::FixedRssLossModel", "Rss", DoubleValue(-75));
-                break;
-            case THREE_LOG_DISTANCE:
-                wifiChannel.AddPropagationLoss("ns3::ThreeLogDistancePropagationLossModel",
-                                               "Distance0",
-                                               DoubleValue(1.0),
-                                               "Distance1",
-                                               DoubleValue(100.0),
-                                               "Distance2",
-                                               DoubleValue(500.0),
-                                               "ReferenceLoss",
-                                               DoubleValue(46.77));
-                break;
-            case TWO_RAY_GROUND:
-                wifiChannel.AddPropagationLoss("ns3::TwoRayGroundPropagationLossModel",
-                                               "Frequency",
-                                               DoubleValue(5.18e9),
-                                               "MinDistance",
-                                               DoubleValue(0.5),
-                                               "SystemLoss",
-                                               DoubleValue(1.0),
-                                               "HeightAboveZ",
-                                               DoubleValue(antennaZ));
-                break;
-            case NAKAGAMI:
-                wifiChannel.AddPropagationLoss("ns3::NakagamiPropagationLossModel",
-                                               "Distance1",
-                                               DoubleValue(80.0),
-                                               "Distance2",
-                                               DoubleValue(200.0),
-                                               "m0",
-                                               DoubleValue(1.5),
-                                               "m1",
-                                               DoubleValue(0.75),
-                                               "m2",
-                                               DoubleValue(0.75));
-                break;
+                for (uint32_t blockAckTimeout :
+                     ParseUnsignedList("blockAckInactivityTimeouts", blockAckTimeoutList))
+                {
+                    AggregationConfig aggregation;
+                    aggregation.maxAmpduSize = maxAmpduSize;
+                    aggregation.maxAmsduSize = maxAmsduSize;
+                    aggregation.blockAckThreshold = blockAckThreshold;
+                    aggregation.blockAckInactivityTimeout = blockAckTimeout;
+                    for (PhyType phy : phyTypes)
+                    {
+                        variants.push_back({phy, aggregation});
+                    }
+                }
             }
+        }
+    }
+    NS_ABORT_MSG_IF(variants.empty(), "At least one aggregation configuration is required");
 
-            wifiPhy.SetChannel(wifiChannel.Create());
-
-            WifiMacHelper wifiMac;
-            wifiMac.SetType("ns3::AdhocWifiMac");
+    // Every number of hops repeats the variants, so the order within a group is kept
+    std::vector<Variant> chainVariants;
+    for (uint32_t hops : ParseUnsignedList("hops", hopsList))
+    {
+        for (Variant variant : variants)
+        {
+            variant.hops = hops;
+            NS_ABORT_MSG_IF(variant.hops < 1 || variant.hops > 253,
+                            "Invalid number of hops " << hops);
+            chainVariants.push_back(variant);
+        }
+    }
+    NS_ABORT_MSG_IF(chainVariants.empty(), "At least one number of hops is required");
+    variants = chainVariants;
 
-            MobilityHelper mobility;
-            Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator>();
-            positionAlloc->Add(Vector(0.0, 0.0, antennaZ));
-            positionAlloc->Add(Vector(d, 0.0, antennaZ));
-            mobility.SetPositionAllocator(positionAlloc);
-            mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
-            mobility.Install(nodes);
+    // Likewise every transport, TCP once for every congestion control and segment size
+    std::vector<TransportConfig> transports;
+    for (const std::string& name : SplitList(transportList))
+    {
+        TransportConfig transport;
+        transport.type = transportTypeFromString(name);
+        if (transport.type != TCP_BULK)
+        {
+            transports.push_back(transport);
+            continue;
+        }
+        for (const std::string& congestionControl : SplitList(congestionControlList))
+        {
+            NS_ABORT_MSG_IF(!IsCongestionControl(congestionControl),
+                            "Unknown congestion control " << congestionControl);
+            for (uint32_t segmentSize : ParseUnsignedList("segmentSizes", segmentSizeList))
+            {
+                transport.congestionControl = congestionControl;
+                transport.segmentSize = segmentSize;
+                NS_ABORT_MSG_IF(transport.segmentSize < 64 || transport.segmentSize > 2244,
+                                "Invalid segment size " << segmentSize);
+                transports.push_back(transport);
+            }
+        }
+    }
+    NS_ABORT_MSG_IF(transports.empty(), "At least one transport is required");
+    std::vector<Variant> transportVariants;
+    for (const TransportConfig& transport : transports)
+    {
+        for (Variant variant : variants)
+        {
+            variant.transport = transport;
+            transportVariants.push_back(variant);
+        }
+    }
+    variants = transportVariants;
 
-            NetDeviceContainer serverDevice = wifi.Install(wifiPhy, wifiMac, nodes.Get(0));
-            NetDeviceContainer clientDevice = wifi.Install(wifiPhy, wifiMac, nodes.Get(1));
+    if (writeShards > 0)
+    {
+        WriteShardManifests(modelsToBeExamined,
+                            variants,
+                            ParseUnsignedList("seeds", seedList),
+                            maxDistance,
+                            writeShards,
+                            shardPrefix,
+                            shardCostFile,
+                            config);
+        return 0;
+    }
+    // Created before the first worker is forked, so that all of them share it
+    ResultRing ring(512, 16384);
 
-            Ipv4AddressHelper address;
-            address.SetBase("10.1.1.0", "255.255.255.0");
+    if (runShard >= 0)
+    {
+        RunShard(ring, runShard, shardPrefix, config, jobs);
+        return 0;
+    }
+    if (!equivalence.empty())
+    {
+        std::vector<double> distances =
+            ParseNonNegativeList("equivalenceDistances", equivalenceDistances);
+        bool passed = RunEquivalenceTests(ring,
+                                          config,
+                                          equivalence,
+                                          modelsToBeExamined,
+                                          distances,
+                                          equivalenceSeeds,
+                                          jobs,
+                                          equivalenceAlpha,
+                                          equivalenceTolerance);
+        return passed ? 0 : 1;
+    }
+    if (validateFastMath)
+    {
+        RunFastMathValidation(ring, config, jobs, maxDistance);
+        return 0;
+    }
+    if (benchmarkPinningTasks > 0)
+    {
+        RunPinningBenchmark(ring, benchmarkPinningTasks, jobs, config);
+        return 0;
+    }
+    if (!benchmarkContention.empty() || !analyticContention.empty())
+    {
+        std::vector<double> distances =
+            ParseNonNegativeList("contentionDistances", contentionDistances);
+        auto contentionPoints = [&](const std::string& option, const std::string& list) {
+            std::vector<uint32_t> clientCounts = ParseUnsignedList(option, list);
+            for (uint32_t clients : clientCounts)
+            {
+                NS_ABORT_MSG_IF(clients < 1 || clients > 1024,
+                                "Invalid number of clients " << clients);
+            }
+            return ContentionPoints(modelsToBeExamined, phyTypes[0], distances, clientCounts);
+        };
+        if (!benchmarkContention.empty())
+        {
+            std::vector<SweepPoint> points =
+                contentionPoints("benchmarkContention", benchmarkContention);
+            std::vector<PointResult> results =
+                RunContentionBenchmark(ring, config, points, contentionDataRate, jobs);
+            if (validateAnalytic)
+            {
+                RunAnalyticContention(config, points, analyticSamples, results);
+            }
+        }
+        else
+        {
+            RunAnalyticContention(config,
+                                  contentionPoints("analyticContention", analyticContention),
+                                  analyticSamples,
+                                  {});
+        }
+        return 0;
+    }
+    if (mergeShards > 0)
+    {
+        MergeShards(mergeShards, shardPrefix);
+        return 0;
+    }
 
-            Ipv4InterfaceContainer serverInterface = address.Assign(serverDevice);
-            Ipv4InterfaceContainer clientInterface = address.Assign(clientDevice);
+    std::ofstream comparisonFile("output_phy_comparison.csv");
+    comparisonFile << "model,distanceMeters,phy,maxAmpduSize,maxAmsduSize,blockAckThreshold,"
+                      "blockAckInactivityTimeout,rssDBm,throughputKbps,rssDeltaDB,"
+                      "throughputDeltaKbps,wallSeconds,events,eventsPerSecond,peakRssKb,"
+                      "eventReduction,wallSpeedup,hops,transport,congestionControl,segmentSize,"
+                      "goodputKbps\n";
+
+    // Written straight from the result ring as the chunks arrive, so the samples of the
+    // points of a batch are interleaved and include speculative points past the cutoff
+    std::map<std::string, std::ofstream> rssFiles;
+    std::function<void(const SweepPoint&, const RssSample*, size_t)> writeRssSamples =
+        [&rssFiles](const SweepPoint& point, const RssSample* samples, size_t count) {
+            std::string fileName = outputFileName(point);
+            fileName.replace(fileName.size() - 4, 4, "_rss.csv");
+            auto file = rssFiles.find(fileName);
+            if (file == rssFiles.end())
+            {
+                file = rssFiles.emplace(fileName, std::ofstream(fileName)).first;
+                file->second << "distanceMeters,timeSeconds,rssDBm\n";
+            }
+            for (size_t i = 0; i < count; i++)
+            {
+                file->second << point.distance << "," << samples[i].time << "," << samples[i].rss
+                             << "\n";
+            }
+        };
 
-            NS_LOG_INFO("Create UdpServer application on node 1.");
-            ApplicationContainer serverApp;
-            uint16_t port = 9;
-            UdpServerHelper server(port);
-            serverApp = server.Install(nodes.Get(0));
-            serverApp.Start(Seconds(1.0));
-            serverApp.Stop(Seconds(simulationTime));
+    const std::string configHash = ConfigHash(config);
+    if (store)
+    {
+        std::string commandLine;
+        for (int i = 0; i < argc; i++)
+        {
+            commandLine += (i ? " " : "") + std::string(argv[i]);
+        }
+        NS_ABORT_MSG_IF(!store->BeginRun("wifi-propagation-comparison",
+                                         commandLine,
+                                         configHash,
+                                         ConfigDescription(config)),
+                        store->Error());
+    }
 
-            Ptr<UdpServer> serverPtr = server.GetServer();
-            Address serverAddr = Address(serverInterface.GetAddress(0));
+    for (PropagationModel model : modelsToBeExamined)
+    {
+        NS_LOG_UNCOND("Running with " << propagationModelToString(model));
 
-            UdpClientHelper client(serverAddr, port);
-            client.SetAttribute("MaxPackets", UintegerValue(packetLimit));
-            client.SetAttribute("Interval", TimeValue(interPacketInterval));
-            client.SetAttribute("PacketSize", UintegerValue(packetSize));
+        std::vector<bool> connectionPossible(variants.size(), true);
+        for (const Variant& variant : variants)
+        {
+            std::ofstream outputFile(
+                outputFileName({model,
+                                variant.phy,
+                                variant.aggregation,
+                                0,
+                                1,
+                                variant.hops,
+                                1,
+                                variant.transport}));
+            WriteOutputHeader(outputFile, model);
+        }
 
-            ApplicationContainer clientApp = client.Install(nodes.Get(1));
-            clientApp.Start(Seconds(2.0));
-            clientApp.Stop(Seconds(simulationTime));
+        // Distances are simulated in batches of one distance per job. Points past the
+        // cutoff of a variant within a batch are speculative and discarded.
+        for (double batchStart = 1;
+             std::find(connectionPossible.begin(), connectionPossible.end(), true) !=
+             connectionPossible.end();
+             batchStart += jobs)
+        {
+            std::vector<SweepPoint> points;
+            std::vector<size_t> pointVariants;
+            for (unsigned i = 0; i < jobs; i++)
+            {
+                for (size_t v = 0; v < variants.size(); v++)
+                {
+                    if (connectionPossible[v])
+                    {
+                        points.push_back({model,
+                                          variants[v].phy,
+                                          variants[v].aggregation,
+                                          batchStart + i,
+                                          1,
+                                          variants[v].hops,
+                                          1,
+                                          variants[v].transport});
+                        pointVariants.push_back(v);
+                    }
+                }
+            }
 
-            FlowMonitorHelper flowMonitorHelper;
-            Ptr<FlowMonitor> flowMonitor = flowMonitorHelper.InstallAll();
+            std::vector<std::vector<StoredFlow>> flows(points.size());
+            std::function<void(size_t, const StoredFlow*, size_t)> collectFlows;
+            if (store)
+            {
+                collectFlows = [&flows](size_t task, const StoredFlow* taskFlows, size_t count) {
+                    flows[task].insert(flows[task].end(), taskFlows, taskFlows + count);
+                };
+            }
+            std::vector<std::optional<PointResult>> results =
+                RunPoints(ring,
+                          points,
+                          config,
+                          jobs,
+                          rssTimeSeries ? writeRssSamples : nullptr,
+                          collectFlows);
+
+            // The points of a batch go into the store in one transaction
+            if (store)
+            {
+                store->Begin();
+            }
+            std::map<double, std::map<size_t, PointResult>> resultsByDistance;
+            for (size_t i = 0; i < points.size(); i++)
+            {
+                const SweepPoint& point = points[i];
+                size_t v = pointVariants[i];
+                NS_ABORT_MSG_IF(!results[i],
+                                "Simulation for distance=" << point.distance << "m with "
+                                                           << phyTypeToString(point.phy)
+                                                           << " PHY failed");
+                if (!connectionPossible[v])
+                {
+                    continue;
+                }
 
-            Config::ConnectWithoutContext(
-                "/NodeList/0/DeviceList/1/$ns3::WifiNetDevice/Phy/MonitorSnifferRx",
-                MakeCallback(&PhyTrace));
+                const PointResult& result = *results[i];
+                resultsByDistance[point.distance][v] = result;
+                if (store)
+                {
+                    StoredPoint stored = ToStoredPoint(point, result, configHash);
+                    stored.flows = std::move(flows[i]);
+                    store->InsertPoint(stored);
+                }
 
-            Simulator::Stop(Seconds(simulationTime));
-            Simulator::Run();
+                if (result.flows > 0)
+                {
+                    NS_LOG_UNCOND(phyTypeToString(point.phy)
+                                  << variantSuffix(variants[v]) << " at " << point.distance
+                                  << "m: RSS: " << result.rss
+                                  << " dBm, Throughput: " << result.throughput << " Kbps");
 
-            flowMonitor->CheckForLostPackets();
-            flowMonitor->SerializeToXmlFile("flow.xml", true, true);
+                    std::ofstream outputFile(outputFileName(point), std::ios_base::app);
+                    WriteOutputRow(outputFile, point.distance, result);
+                }
 
-            FlowMonitor::FlowStatsContainer stats = flowMonitor->GetFlowStats();
+                if (EndsSweep(point, result))
+                {
+                    connectionPossible[v] = false;
+                }
+            }
+            NS_ABORT_MSG_IF(store && !store->Commit(), store->Error());
 
-            for (auto it = stats.begin(); it != stats.end(); ++it)
+            for (size_t i = 0; i < points.size(); i++)
             {
-                double throughput = it->second.rxBytes * 8.0 / (simulationTime) / 1024; // Kbps
+                const SweepPoint& point = points[i];
+                size_t v = pointVariants[i];
+                auto& results = resultsByDistance[point.distance];
+                auto found = results.find(v);
+                if (found == results.end())
+                {
+                    continue;
+                }
 
-                NS_LOG_UNCOND("RSS: " << averageRSS << " dBm, Throughput: " << throughput
-                                      << " Kbps");
+                const PointResult& result = found->second;
+                const AggregationConfig& aggregation = point.aggregation;
+                comparisonFile << propagationModelToString(model) << "," << point.distance << ","
+                               << phyTypeToString(point.phy) << "," << aggregation.maxAmpduSize
+                               << "," << aggregation.maxAmsduSize << ","
+                               << aggregation.blockAckThreshold << ","
+                               << aggregation.blockAckInactivityTimeout << "," << result.rss
+                               << "," << result.throughput << ",";
+
+                auto reference = results.find(v - v % phyTypes.size());
+                if (reference != results.end())
+                {
+                    comparisonFile << result.rss - reference->second.rss << ","
+                                   << result.throughput - reference->second.throughput;
+                }
+                else
+                {
+                    comparisonFile << ",";
+                }
 
-                outputFile.open(outputFileName, std::ios_base::app);
-                outputFile << d << "," << averageRSS << "," << throughput << "," << std::endl;
-                outputFile.close();
+                double eventsPerSecond =
+                    result.runSeconds > 0 ? result.events / result.runSeconds : 0;
+                comparisonFile << "," << result.wallSeconds << "," << result.events << ","
+                               << eventsPerSecond << "," << result.peakRssKb << ",";
 
-                if (it->second.rxBytes == 0)
+                if (reference != results.end() && result.events > 0 && result.wallSeconds > 0)
                 {
-                    connectionPossible = false;
+                    comparisonFile << double(reference->second.events) / result.events << ","
+                                   << reference->second.wallSeconds / result.wallSeconds;
                 }
+                else
+                {
+                    comparisonFile << ",";
+                }
+                comparisonFile << "," << point.hops << ","
+                               << transportTypeToString(point.transport.type) << ",";
+                if (point.transport.type == TCP_BULK)
+                {
+                    comparisonFile << point.transport.congestionControl << ","
+                                   << point.transport.segmentSize;
+                }
+                else
+                {
+                    comparisonFile << ",";
+                }
+                comparisonFile << "," << result.goodput << "\n";
             }
-
-            if (d >= 500 && (model == NAKAGAMI || model == FIXED_RSS))
-            {
-                connectionPossible = false;
-            }
-
-            Simulator::Destroy();
         }
 
         std::cout << "End of Simulation with model" << model << std::endl;